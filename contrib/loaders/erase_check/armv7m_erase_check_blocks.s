@@ -0,0 +1,56 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+/*
+	parameters:
+	r0 - pointer to struct { uint32_t address; uint32_t size; uint32_t result; }
+	r1 - number of blocks
+	r2 - erased value
+
+	The result of each block is set to the erased value if the block
+	is blank, otherwise to the first byte that differs from it.
+*/
+
+	.text
+	.syntax unified
+	.cpu cortex-m0
+	.thumb
+	.thumb_func
+
+	.align	2
+
+next_block:
+	ldr		r3, [r0]
+	ldr		r4, [r0, #4]
+	mov		r6, r2
+loop:
+	ldrb	r5, [r3]
+	adds	r3, #1
+	cmp		r5, r2
+	bne		mismatch
+	subs	r4, #1
+	bne		loop
+	b		store
+mismatch:
+	mov		r6, r5
+store:
+	str		r6, [r0, #8]
+	adds	r0, #12
+	subs	r1, #1
+	bne		next_block
+end:
+	bkpt	#0
+
+	.end
@@ -0,0 +1,276 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or (at
+ * your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Summarize a recording made with the OpenOCD "tracelog start" command:
+ * how many debug link round trips were made and how long they took, and
+ * for each kind of target operation (halt, step, memory and flash
+ * accesses) how often it ran, how long it took and how many round trips
+ * it needed. Round trips are counted for every operation in progress, so
+ * a flash write includes the memory writes and round trips it was made of.
+ *
+ * The file format is described in src/helper/tracelog.h.
+ *
+ * Build with e.g. "cc -O2 -o tracelog-dump tracelog-dump.c".
+ */
+
+#include <errno.h>
+#include <inttypes.h>
+#include <libgen.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TRACELOG_MAGIC		"OCDTRACE"
+#define TRACELOG_VERSION	1
+#define TRACELOG_HEADER_SIZE	16
+#define TRACELOG_RECORD_SIZE	16
+
+#define TRACELOG_BEGIN		0
+#define TRACELOG_END		1
+
+/* longest chain of operations in progress at the same time */
+#define MAX_DEPTH		32
+
+struct event_type {
+	unsigned int id;
+	const char *name;
+	/* a debug link round trip rather than a target operation */
+	bool link;
+	/* the argument of the begin record is a byte count */
+	bool bytes;
+};
+
+static const struct event_type event_types[] = {
+	{  1, "jtag_execute_queue", true, false },
+	{  2, "swd_run", true, false },
+	{  3, "dap_run", true, false },
+	{ 16, "halt", false, false },
+	{ 17, "resume", false, false },
+	{ 18, "step", false, false },
+	{ 19, "read_memory", false, true },
+	{ 20, "write_memory", false, true },
+	{ 21, "flash_erase", false, false },
+	{ 22, "flash_write", false, true },
+};
+
+#define NUM_TYPES (sizeof(event_types) / sizeof(event_types[0]))
+
+struct event_stats {
+	uint64_t count;
+	uint64_t errors;
+	uint64_t total_us;
+	uint64_t max_us;
+	uint64_t amount;
+	/* link round trips made while the operation was in progress */
+	uint64_t round_trips;
+	uint64_t round_trip_us;
+};
+
+struct open_event {
+	unsigned int type;
+	uint64_t begin_us;
+	uint64_t round_trips;
+	uint64_t round_trip_us;
+};
+
+static struct event_stats stats[NUM_TYPES];
+static struct open_event open_events[MAX_DEPTH];
+static unsigned int depth;
+static bool verbose;
+
+static uint32_t get_u32(const uint8_t *buf)
+{
+	return buf[0] | buf[1] << 8 | buf[2] << 16 | (uint32_t)buf[3] << 24;
+}
+
+static uint64_t get_u64(const uint8_t *buf)
+{
+	return get_u32(buf) | (uint64_t)get_u32(buf + 4) << 32;
+}
+
+static int find_type(unsigned int id)
+{
+	for (unsigned int i = 0; i < NUM_TYPES; i++) {
+		if (event_types[i].id == id)
+			return i;
+	}
+	return -1;
+}
+
+static void begin_event(unsigned int type, uint64_t time_us, uint32_t arg)
+{
+	if (depth == MAX_DEPTH) {
+		fprintf(stderr, "operations nested too deeply at %" PRIu64 " us\n", time_us);
+		return;
+	}
+
+	open_events[depth].type = type;
+	open_events[depth].begin_us = time_us;
+	open_events[depth].round_trips = 0;
+	open_events[depth].round_trip_us = 0;
+	depth++;
+
+	stats[type].amount += arg;
+}
+
+static void end_event(unsigned int type, uint64_t time_us, int32_t result)
+{
+	/* operations end in reverse order of their start; anything still
+	 * open above this one has no end record, which happens when the
+	 * recording was stopped or started in the middle of it */
+	unsigned int i = depth;
+	while (i > 0 && open_events[i - 1].type != type)
+		i--;
+	if (i == 0) {
+		fprintf(stderr, "end of %s without a start at %" PRIu64 " us\n",
+				event_types[type].name, time_us);
+		return;
+	}
+	depth = i - 1;
+
+	struct open_event *ev = &open_events[depth];
+	uint64_t duration = time_us - ev->begin_us;
+	struct event_stats *s = &stats[type];
+
+	s->count++;
+	if (result != 0)
+		s->errors++;
+	s->total_us += duration;
+	if (duration > s->max_us)
+		s->max_us = duration;
+	s->round_trips += ev->round_trips;
+	s->round_trip_us += ev->round_trip_us;
+
+	/* Round trips are added to all enclosing operations as they end. A
+	 * DAP run over JTAG is made of JTAG round trips, so only link events
+	 * without any inside them are round trips of their own. */
+	if (event_types[type].link && ev->round_trips == 0) {
+		for (unsigned int j = 0; j < depth; j++) {
+			open_events[j].round_trips++;
+			open_events[j].round_trip_us += duration;
+		}
+	}
+
+	if (verbose)
+		printf("%12" PRIu64 " us  %*s%s %" PRIu64 " us, %" PRIu64 " round trips%s\n",
+				time_us, 2 * depth, "", event_types[type].name, duration,
+				ev->round_trips, result ? ", failed" : "");
+}
+
+static void print_summary(uint64_t end_us)
+{
+	printf("recording of %.3f s\n\n", end_us / 1000000.0);
+
+	printf("%-20s %10s %8s %12s %10s %10s %12s %12s\n", "operation", "count", "errors",
+			"total ms", "avg us", "max us", "round trips", "bytes");
+	for (unsigned int i = 0; i < NUM_TYPES; i++) {
+		const struct event_stats *s = &stats[i];
+
+		if (s->count == 0)
+			continue;
+
+		printf("%-20s %10" PRIu64 " %8" PRIu64 " %12.3f %10" PRIu64 " %10" PRIu64,
+				event_types[i].name, s->count, s->errors, s->total_us / 1000.0,
+				s->total_us / s->count, s->max_us);
+		if (event_types[i].link)
+			printf(" %12s", "-");
+		else
+			printf(" %12" PRIu64, s->round_trips);
+		if (event_types[i].bytes)
+			printf(" %12" PRIu64, s->amount);
+		printf("\n");
+	}
+
+	printf("\n");
+	for (unsigned int i = 0; i < NUM_TYPES; i++) {
+		const struct event_stats *s = &stats[i];
+
+		if (event_types[i].link || s->count == 0)
+			continue;
+
+		printf("%s: %.1f round trips and %.1f us per operation, %.0f%% of the time "
+				"spent in round trips\n", event_types[i].name,
+				(double)s->round_trips / s->count, (double)s->total_us / s->count,
+				s->total_us ? 100.0 * s->round_trip_us / s->total_us : 0.0);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	FILE *f = stdin;
+	uint8_t header[TRACELOG_HEADER_SIZE];
+	uint8_t record[TRACELOG_RECORD_SIZE];
+	uint64_t time_us = 0;
+	int c;
+
+	/* parse arguments */
+	while ((c = getopt(argc, argv, "f:v")) != EOF) {
+		switch (c) {
+		case 'f':
+			f = fopen(optarg, "rb");
+			if (!f) {
+				perror(optarg);
+				return 1;
+			}
+			break;
+		case 'v':
+			verbose = true;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-v] [-f input]\n",
+				basename(argv[0]));
+			return 1;
+		}
+	}
+
+	if (fread(header, sizeof(header), 1, f) != 1
+			|| memcmp(header, TRACELOG_MAGIC, 8) != 0) {
+		fprintf(stderr, "not an OpenOCD trace log\n");
+		return 1;
+	}
+	if (get_u32(header + 8) != TRACELOG_VERSION
+			|| get_u32(header + 12) != TRACELOG_RECORD_SIZE) {
+		fprintf(stderr, "unsupported trace log version %u\n", get_u32(header + 8));
+		return 1;
+	}
+
+	while (fread(record, sizeof(record), 1, f) == 1) {
+		int type = find_type(record[8]);
+
+		time_us = get_u64(record);
+		if (type < 0) {
+			fprintf(stderr, "unknown event %u at %" PRIu64 " us\n", record[8], time_us);
+			continue;
+		}
+
+		if (record[9] == TRACELOG_BEGIN)
+			begin_event(type, time_us, get_u32(record + 12));
+		else
+			end_event(type, time_us, (int32_t)get_u32(record + 12));
+	}
+
+	if (ferror(f)) {
+		fprintf(stderr, "read error: %s\n", strerror(errno));
+		return 1;
+	}
+
+	print_summary(time_us);
+
+	return 0;
+}
@@ -49,10 +49,11 @@ static int arm_code_to_working_area(struct target *target,
 	int retval;
 	unsigned size = code_size + additional;
 
-	/* REVISIT this assumes size doesn't ever change.
-	 * That's usually correct; but there are boards with
-	 * both large and small page chips, where it won't be...
-	 */
+	/* a transfer larger than the area was made for needs a new one */
+	if (*area && (*area)->size < size) {
+		target_free_working_area(target, *area);
+		*area = NULL;
+	}
 
 	/* make sure we have a working area */
 	if (NULL == *area) {
@@ -148,9 +149,10 @@ int arm_nandwrite(struct arm_nand_data *nand, uint8_t *data, int size)
 		target_code_src = code_armv4_5;
 	}
 
-	if (nand->op != ARM_NAND_WRITE || !nand->copy_area) {
+	if (nand->op != ARM_NAND_WRITE || !nand->copy_area
+			|| nand->copy_area->size < (uint32_t)(target_code_size + size)) {
 		retval = arm_code_to_working_area(target, target_code_src, target_code_size,
-				nand->chunk_size, &nand->copy_area);
+				MAX(nand->chunk_size, (unsigned)size), &nand->copy_area);
 		if (retval != ERROR_OK)
 			return retval;
 	}
@@ -259,9 +261,10 @@ int arm_nandread(struct arm_nand_data *nand, uint8_t *data, uint32_t size)
 	}
 
 	/* create the copy area if not yet available */
-	if (nand->op != ARM_NAND_READ || !nand->copy_area) {
+	if (nand->op != ARM_NAND_READ || !nand->copy_area
+			|| nand->copy_area->size < (uint32_t)(target_code_size + size)) {
 		retval = arm_code_to_working_area(target, target_code_src, target_code_size,
-				nand->chunk_size, &nand->copy_area);
+				MAX(nand->chunk_size, size), &nand->copy_area);
 		if (retval != ERROR_OK)
 			return retval;
 	}
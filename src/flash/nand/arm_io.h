@@ -37,7 +37,8 @@ struct arm_nand_data {
 	/** The copy area holds code loop and data for I/O operations. */
 	struct working_area *copy_area;
 
-	/** The chunk size is the page size or ECC chunk. */
+	/** The chunk size is the page size or ECC chunk, plus the OOB area
+	 * when both are moved together. Larger transfers grow the copy area. */
 	unsigned chunk_size;
 
 	/** Where data is read from or written to. */
@@ -49,6 +50,11 @@ struct arm_nand_data {
 	/* currently implicit:  data width == 8 bits (not 16) */
 };
 
+/* A page and its OOB area, which nand_read_page_raw() and
+ * nand_write_page_raw() move in one transfer. The OOB area is at
+ * most 16 bytes per 512 bytes of data. */
+#define ARM_NAND_PAGE_CHUNK(nand)	((nand)->page_size + (nand)->page_size / 32)
+
 int arm_nandwrite(struct arm_nand_data *nand, uint8_t *data, int size);
 int arm_nandread(struct arm_nand_data *nand, uint8_t *data, uint32_t size);
 
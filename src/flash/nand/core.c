@@ -24,6 +24,7 @@
 #endif
 
 #include "imp.h"
+#include <helper/time_support.h>
 
 /* configured NAND devices and NAND Flash command handler */
 struct nand_device *nand_devices;
@@ -229,6 +230,10 @@ int nand_build_bbt(struct nand_device *nand, int first, int last)
 	int i;
 	int pages_per_block = (nand->erase_size / nand->page_size);
 	uint8_t oob[6];
+	/* large page devices keep the marker in the first two OOB bytes,
+	 * only small page devices need to read up to byte 5 */
+	uint32_t oob_size = (nand->page_size == 512) ? 6 : 2;
+	struct duration bench;
 	int ret;
 
 	if ((first < 0) || (first >= nand->num_blocks))
@@ -237,9 +242,11 @@ int nand_build_bbt(struct nand_device *nand, int first, int last)
 	if ((last >= nand->num_blocks) || (last == -1))
 		last = nand->num_blocks - 1;
 
+	duration_start(&bench);
+
 	page = first * pages_per_block;
 	for (i = first; i <= last; i++) {
-		ret = nand_read_page(nand, page, NULL, 0, oob, 6);
+		ret = nand_read_page(nand, page, NULL, 0, oob, oob_size);
 		if (ret != ERROR_OK)
 			return ret;
 
@@ -252,6 +259,13 @@ int nand_build_bbt(struct nand_device *nand, int first, int last)
 			nand->blocks[i].is_bad = 0;
 
 		page += pages_per_block;
+		keep_alive();
+	}
+
+	if (duration_measure(&bench) == ERROR_OK) {
+		float elapsed = duration_elapsed(&bench);
+		LOG_INFO("checked %d blocks in %fs (%0.1f blocks/s)", last - first + 1,
+			elapsed, elapsed > 0 ? (last - first + 1) / elapsed : 0);
 	}
 
 	return ERROR_OK;
@@ -769,6 +783,21 @@ int nand_read_data_page(struct nand_device *nand, uint8_t *data, uint32_t size)
 	return retval;
 }
 
+/* Returns the device's page staging buffer, grown to at least @a size
+ * bytes, or NULL if it can't be allocated.
+ */
+static uint8_t *nand_page_buffer(struct nand_device *nand, uint32_t size)
+{
+	if (nand->page_buffer_size < size) {
+		uint8_t *buf = realloc(nand->page_buffer, size);
+		if (!buf)
+			return NULL;
+		nand->page_buffer = buf;
+		nand->page_buffer_size = size;
+	}
+	return nand->page_buffer;
+}
+
 int nand_read_page_raw(struct nand_device *nand, uint32_t page,
 	uint8_t *data, uint32_t data_size,
 	uint8_t *oob, uint32_t oob_size)
@@ -779,13 +808,30 @@ int nand_read_page_raw(struct nand_device *nand, uint32_t page,
 	if (ERROR_OK != retval)
 		return retval;
 
-	if (data)
-		nand_read_data_page(nand, data, data_size);
+	/* The OOB area follows the page data, so a whole page and its OOB
+	 * can come in one block transfer: one bus transaction or algorithm
+	 * run per page instead of two.
+	 */
+	if (data && oob && data_size == (uint32_t)nand->page_size) {
+		uint8_t *buf = nand_page_buffer(nand, data_size + oob_size);
+		if (buf) {
+			retval = nand_read_data_page(nand, buf, data_size + oob_size);
+			memcpy(data, buf, data_size);
+			memcpy(oob, buf + data_size, oob_size);
+			return retval;
+		}
+	}
+
+	if (data) {
+		retval = nand_read_data_page(nand, data, data_size);
+		if (ERROR_OK != retval)
+			return retval;
+	}
 
 	if (oob)
-		nand_read_data_page(nand, oob, oob_size);
+		retval = nand_read_data_page(nand, oob, oob_size);
 
-	return ERROR_OK;
+	return retval;
 }
 
 int nand_write_data_page(struct nand_device *nand, uint8_t *data, uint32_t size)
@@ -856,6 +902,21 @@ int nand_write_page_raw(struct nand_device *nand, uint32_t page,
 	if (ERROR_OK != retval)
 		return retval;
 
+	/* as for reads, send a whole page and its OOB in one go */
+	if (data && oob && data_size == (uint32_t)nand->page_size) {
+		uint8_t *buf = nand_page_buffer(nand, data_size + oob_size);
+		if (buf) {
+			memcpy(buf, data, data_size);
+			memcpy(buf + data_size, oob, oob_size);
+			retval = nand_write_data_page(nand, buf, data_size + oob_size);
+			if (ERROR_OK != retval) {
+				LOG_ERROR("Unable to write data to NAND device");
+				return retval;
+			}
+			return nand_write_finish(nand);
+		}
+	}
+
 	if (data) {
 		retval = nand_write_data_page(nand, data, data_size);
 		if (ERROR_OK != retval) {
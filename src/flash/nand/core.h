@@ -69,6 +69,9 @@ struct nand_device {
 	bool use_raw;
 	int num_blocks;
 	struct nand_block *blocks;
+	/* staging for a page and its OOB, reused across raw page I/O */
+	uint8_t *page_buffer;
+	uint32_t page_buffer_size;
 	struct nand_device *next;
 };
 
@@ -214,6 +217,12 @@ int nand_calculate_ecc(struct nand_device *nand,
 int nand_calculate_ecc_kw(struct nand_device *nand,
 			  const uint8_t *dat, uint8_t *ecc_code);
 
+/* byte at a time versions of the above, for testing and benchmarks */
+int nand_calculate_ecc_ref(struct nand_device *nand,
+			   const uint8_t *dat, uint8_t *ecc_code);
+int nand_calculate_ecc_kw_ref(struct nand_device *nand,
+			      const uint8_t *dat, uint8_t *ecc_code);
+
 int nand_register_commands(struct command_context *cmd_ctx);
 
 /** helper for parsing a nand device command argument string */
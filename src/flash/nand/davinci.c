@@ -288,10 +288,10 @@ static int davinci_write_page(struct nand_device *nand, uint32_t page,
 	}
 
 	/* REVISIT avoid wasting SRAM:  unless nand->use_raw is set,
-	 * use 512 byte chunks.  Read side support will often want
-	 * to include oob_size ...
+	 * use 512 byte chunks.  Raw page access moves the OOB area
+	 * along with the page, so make room for both.
 	 */
-	info->io.chunk_size = nand->page_size;
+	info->io.chunk_size = nand->page_size + oob_size;
 
 	status = info->write_page(nand, page, data, data_size, oob, oob_size);
 	free(ooballoc);
@@ -64,29 +64,10 @@ static const uint8_t nand_ecc_precalc_table[] = {
 	0x00, 0x55, 0x56, 0x03, 0x59, 0x0c, 0x0f, 0x5a, 0x5a, 0x0f, 0x0c, 0x59, 0x03, 0x56, 0x55, 0x00
 };
 
-/*
- * nand_calculate_ecc - Calculate 3-byte ECC for 256-byte block
- */
-int nand_calculate_ecc(struct nand_device *nand, const uint8_t *dat, uint8_t *ecc_code)
+/* Turn column parity and line parity into the 3 ECC bytes */
+static void nand_ecc_pack(uint8_t reg1, uint8_t reg2, uint8_t reg3, uint8_t *ecc_code)
 {
-	uint8_t idx, reg1, reg2, reg3, tmp1, tmp2;
-	int i;
-
-	/* Initialize variables */
-	reg1 = reg2 = reg3 = 0;
-
-	/* Build up column parity */
-	for (i = 0; i < 256; i++) {
-		/* Get CP0 - CP5 from table */
-		idx = nand_ecc_precalc_table[*dat++];
-		reg1 ^= (idx & 0x3f);
-
-		/* All bit XOR = 1 ? */
-		if (idx & 0x40) {
-			reg3 ^= (uint8_t) i;
-			reg2 ^= ~((uint8_t) i);
-		}
-	}
+	uint8_t tmp1, tmp2;
 
 	/* Create non-inverted ECC code from line parity */
 	tmp1  = (reg3 & 0x80) >> 0; /* B7 -> B7 */
@@ -116,6 +97,92 @@ int nand_calculate_ecc(struct nand_device *nand, const uint8_t *dat, uint8_t *ec
 	ecc_code[1] = ~tmp2;
 #endif
 	ecc_code[2] = ((~reg1) << 2) | 0x03;
+}
+
+static inline unsigned int parity64(uint64_t x)
+{
+	x ^= x >> 32;
+	x ^= x >> 16;
+	x ^= x >> 8;
+	x ^= x >> 4;
+	return (0x6996 >> (x & 0xf)) & 1;
+}
+
+/*
+ * nand_calculate_ecc - Calculate 3-byte ECC for 256-byte block
+ *
+ * Parity is linear, so instead of looking at one byte at a time this XORs
+ * the block together 64 bits at a time. Byte i of the block is byte lane
+ * i % 8 of word i / 8: line parity for the low 3 bits of the byte index
+ * comes from lanes of the XOR of all words, for the upper 5 bits from the
+ * XOR of the words whose index has that bit set. Column parity is taken
+ * from the table for the XOR of all bytes.
+ */
+int nand_calculate_ecc(struct nand_device *nand, const uint8_t *dat, uint8_t *ecc_code)
+{
+	uint64_t all = 0;
+	uint64_t line[5] = { 0, 0, 0, 0, 0 };
+	uint8_t reg1, reg2, reg3;
+	int i;
+
+	for (i = 0; i < 32; i++) {
+		uint64_t w = le_to_h_u64(dat + 8 * i);
+
+		all ^= w;
+		line[0] ^= w & -(uint64_t)(i & 1);
+		line[1] ^= w & -(uint64_t)((i >> 1) & 1);
+		line[2] ^= w & -(uint64_t)((i >> 2) & 1);
+		line[3] ^= w & -(uint64_t)((i >> 3) & 1);
+		line[4] ^= w & -(uint64_t)((i >> 4) & 1);
+	}
+
+	/* column parity of the XOR of all bytes */
+	uint64_t fold = all ^ (all >> 32);
+	fold ^= fold >> 16;
+	fold ^= fold >> 8;
+	reg1 = nand_ecc_precalc_table[fold & 0xff] & 0x3f;
+
+	/* line parity: reg3 for byte indexes with a bit set, reg2 for those
+	 * with it clear, which is reg3 flipped if the whole block is odd */
+	reg3 = parity64(all & 0xff00ff00ff00ff00ULL) << 0;
+	reg3 |= parity64(all & 0xffff0000ffff0000ULL) << 1;
+	reg3 |= parity64(all & 0xffffffff00000000ULL) << 2;
+	for (i = 0; i < 5; i++)
+		reg3 |= parity64(line[i]) << (3 + i);
+	reg2 = parity64(all) ? ~reg3 : reg3;
+
+	nand_ecc_pack(reg1, reg2, reg3, ecc_code);
+
+	return 0;
+}
+
+/*
+ * nand_calculate_ecc_ref - Calculate 3-byte ECC for 256-byte block, one
+ * byte at a time. Gives the same result as nand_calculate_ecc(); kept as
+ * a reference for testing and benchmarking it.
+ */
+int nand_calculate_ecc_ref(struct nand_device *nand, const uint8_t *dat, uint8_t *ecc_code)
+{
+	uint8_t idx, reg1, reg2, reg3;
+	int i;
+
+	/* Initialize variables */
+	reg1 = reg2 = reg3 = 0;
+
+	/* Build up column parity */
+	for (i = 0; i < 256; i++) {
+		/* Get CP0 - CP5 from table */
+		idx = nand_ecc_precalc_table[*dat++];
+		reg1 ^= (idx & 0x3f);
+
+		/* All bit XOR = 1 ? */
+		if (idx & 0x40) {
+			reg3 ^= (uint8_t) i;
+			reg2 ^= ~((uint8_t) i);
+		}
+	}
+
+	nand_ecc_pack(reg1, reg2, reg3, ecc_code);
 
 	return 0;
 }
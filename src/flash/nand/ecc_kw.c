@@ -47,6 +47,20 @@ static uint16_t gf_exp[1023 + 1023];
  */
 static uint16_t gf_log[1024];
 
+/*
+ * The discrete logs of the coefficients of the generator polynomial
+ * (see below), for X^7 down to X^0.
+ */
+static const uint16_t gen_log[8] = {
+	0x21c, 0x181, 0x18e, 0x25f, 0x197, 0x193, 0x237, 0x024,
+};
+
+/*
+ * gen_mul[b][k] is b times generator coefficient k, so that every step of
+ * the division below is 8 lookups in one row, with no test for b == 0.
+ */
+static uint16_t gen_mul[1024][8];
+
 static void gf_build_log_exp_table(void)
 {
 	int i;
@@ -71,6 +85,21 @@ static void gf_build_log_exp_table(void)
 		if (p_i & (1 << 10))
 			p_i ^= MODPOLY;
 	}
+
+	for (i = 1; i < 1024; i++) {
+		for (int k = 0; k < 8; k++)
+			gen_mul[i][k] = gf_exp[gf_log[i] + gen_log[k]];
+	}
+}
+
+static void gf_init(void)
+{
+	static int tables_initialized;
+
+	if (!tables_initialized) {
+		gf_build_log_exp_table();
+		tables_initialized = 1;
+	}
 }
 
 
@@ -105,13 +134,65 @@ int nand_calculate_ecc_kw(struct nand_device *nand, const uint8_t *data, uint8_t
 {
 	unsigned int r7, r6, r5, r4, r3, r2, r1, r0;
 	int i;
-	static int tables_initialized;
 
-	if (!tables_initialized) {
-		gf_build_log_exp_table();
-		tables_initialized = 1;
+	gf_init();
+
+	/*
+	 * Load bytes 504..511 of the data into r.
+	 */
+	r0 = data[504];
+	r1 = data[505];
+	r2 = data[506];
+	r3 = data[507];
+	r4 = data[508];
+	r5 = data[509];
+	r6 = data[510];
+	r7 = data[511];
+
+	/*
+	 * Shift bytes 503..0 (in that order) into r0, followed
+	 * by eight zero bytes, while reducing the polynomial by the
+	 * generator polynomial in every step.
+	 */
+	for (i = 503; i >= -8; i--) {
+		const uint16_t *t = gen_mul[r7];
+
+		r7 = r6 ^ t[0];
+		r6 = r5 ^ t[1];
+		r5 = r4 ^ t[2];
+		r4 = r3 ^ t[3];
+		r3 = r2 ^ t[4];
+		r2 = r1 ^ t[5];
+		r1 = r0 ^ t[6];
+		r0 = ((i >= 0) ? data[i] : 0) ^ t[7];
 	}
 
+	ecc[0] = r0;
+	ecc[1] = (r0 >> 8) | (r1 << 2);
+	ecc[2] = (r1 >> 6) | (r2 << 4);
+	ecc[3] = (r2 >> 4) | (r3 << 6);
+	ecc[4] = (r3 >> 2);
+	ecc[5] = r4;
+	ecc[6] = (r4 >> 8) | (r5 << 2);
+	ecc[7] = (r5 >> 6) | (r6 << 4);
+	ecc[8] = (r6 >> 4) | (r7 << 6);
+	ecc[9] = (r7 >> 2);
+
+	return 0;
+}
+
+/*
+ * The same as nand_calculate_ecc_kw(), with a log/exponent lookup per step
+ * instead of the product table; kept as a reference for testing and
+ * benchmarking it.
+ */
+int nand_calculate_ecc_kw_ref(struct nand_device *nand, const uint8_t *data, uint8_t *ecc)
+{
+	unsigned int r7, r6, r5, r4, r3, r2, r1, r0;
+	int i;
+
+	gf_init();
+
 	/*
 	 * Load bytes 504..511 of the data into r.
 	 */
@@ -26,6 +26,9 @@
 #include "core.h"
 #include "fileio.h"
 
+/* number of pages moved between the file and memory at once */
+#define NAND_FILEIO_QUEUE_PAGES	64
+
 static struct nand_ecclayout nand_oob_16 = {
 	.eccbytes = 6,
 	.eccpos = {0, 1, 2, 3, 6, 7},
@@ -92,6 +95,15 @@ int nand_fileio_start(struct command_context *cmd_ctx,
 		state->oob = malloc(state->oob_size);
 	}
 
+	if (state->file_opened) {
+		state->queue_size = NAND_FILEIO_QUEUE_PAGES * (state->page_size + state->oob_size);
+		state->queue = malloc(state->queue_size);
+		if (!state->queue) {
+			nand_fileio_cleanup(state);
+			return ERROR_FAIL;
+		}
+	}
+
 	return ERROR_OK;
 }
 int nand_fileio_cleanup(struct nand_fileio_state *state)
@@ -107,6 +119,8 @@ int nand_fileio_cleanup(struct nand_fileio_state *state)
 		free(state->page);
 		state->page = NULL;
 	}
+	free(state->queue);
+	state->queue = NULL;
 	return ERROR_OK;
 }
 int nand_fileio_finish(struct nand_fileio_state *state)
@@ -178,6 +192,31 @@ COMMAND_HELPER(nand_fileio_parse_args, struct nand_fileio_state *state,
 	return ERROR_OK;
 }
 
+/* Take up to @a size bytes of the file from the queue, refilling it from
+ * the file when it runs empty. Returns the number of bytes taken.
+ */
+static size_t nand_fileio_take(struct nand_fileio_state *s, uint8_t *buf, size_t size)
+{
+	size_t taken = 0;
+
+	while (taken < size) {
+		if (s->queue_pos == s->queue_len) {
+			if (fileio_read(s->fileio, s->queue_size, s->queue, &s->queue_len) != ERROR_OK)
+				s->queue_len = 0;
+			s->queue_pos = 0;
+			if (s->queue_len == 0)
+				break;
+		}
+
+		size_t n = MIN(size - taken, s->queue_len - s->queue_pos);
+		memcpy(buf + taken, s->queue + s->queue_pos, n);
+		s->queue_pos += n;
+		taken += n;
+	}
+
+	return taken;
+}
+
 /**
  * @returns If no error occurred, returns number of bytes consumed;
  * otherwise, returns a negative error code.)
@@ -188,7 +227,7 @@ int nand_fileio_read(struct nand_device *nand, struct nand_fileio_state *s)
 	size_t one_read;
 
 	if (NULL != s->page) {
-		fileio_read(s->fileio, s->page_size, s->page, &one_read);
+		one_read = nand_fileio_take(s, s->page, s->page_size);
 		if (one_read < s->page_size)
 			memset(s->page + one_read, 0xff, s->page_size - one_read);
 		total_read += one_read;
@@ -217,10 +256,49 @@ int nand_fileio_read(struct nand_device *nand, struct nand_fileio_state *s)
 			ecc += 10;
 		}
 	} else if (NULL != s->oob)   {
-		fileio_read(s->fileio, s->oob_size, s->oob, &one_read);
+		one_read = nand_fileio_take(s, s->oob, s->oob_size);
 		if (one_read < s->oob_size)
 			memset(s->oob + one_read, 0xff, s->oob_size - one_read);
 		total_read += one_read;
 	}
 	return total_read;
 }
+
+/* Queue the current page and OOB for writing to the file. */
+int nand_fileio_write(struct nand_fileio_state *s)
+{
+	if (s->queue_len + s->page_size + s->oob_size > s->queue_size) {
+		int retval = nand_fileio_flush(s);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	if (NULL != s->page) {
+		memcpy(s->queue + s->queue_len, s->page, s->page_size);
+		s->queue_len += s->page_size;
+	}
+
+	if (NULL != s->oob) {
+		memcpy(s->queue + s->queue_len, s->oob, s->oob_size);
+		s->queue_len += s->oob_size;
+	}
+
+	return ERROR_OK;
+}
+
+/* Write out the pages queued by nand_fileio_write(). */
+int nand_fileio_flush(struct nand_fileio_state *s)
+{
+	size_t written;
+	int retval;
+
+	if (s->queue_len == 0)
+		return ERROR_OK;
+
+	retval = fileio_write(s->fileio, s->queue_len, s->queue, &written);
+	if (retval == ERROR_OK && written != s->queue_len)
+		retval = ERROR_FAIL;
+	s->queue_len = 0;
+
+	return retval;
+}
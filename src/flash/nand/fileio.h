@@ -37,6 +37,13 @@ struct nand_fileio_state {
 	bool file_opened;
 	struct fileio *fileio;
 
+	/* pages read from or to be written to the file, so that the file is
+	 * accessed many pages at a time instead of for every page */
+	uint8_t *queue;
+	size_t queue_size;
+	size_t queue_len;
+	size_t queue_pos;
+
 	struct duration bench;
 };
 
@@ -52,5 +59,7 @@ COMMAND_HELPER(nand_fileio_parse_args, struct nand_fileio_state *state,
 	bool need_size, bool sw_ecc);
 
 int nand_fileio_read(struct nand_device *nand, struct nand_fileio_state *s);
+int nand_fileio_write(struct nand_fileio_state *s);
+int nand_fileio_flush(struct nand_fileio_state *s);
 
 #endif /* OPENOCD_FLASH_NAND_FILEIO_H */
@@ -27,6 +27,7 @@
 #include "imp.h"
 #include "fileio.h"
 #include <target/target.h>
+#include <helper/time_support.h>
 
 /* to be removed */
 extern struct nand_device *nand_devices;
@@ -250,6 +251,7 @@ COMMAND_HANDLER(handle_nand_write_command)
 		return retval;
 
 	uint32_t total_bytes = s.size;
+	uint32_t pages = 0;
 	while (s.size > 0) {
 		int bytes_read = nand_fileio_read(nand, &s);
 		if (bytes_read <= 0) {
@@ -269,13 +271,17 @@ COMMAND_HANDLER(handle_nand_write_command)
 			return retval;
 		}
 		s.address += s.page_size;
+		pages++;
+		keep_alive();
 	}
 
 	if (nand_fileio_finish(&s) == ERROR_OK) {
+		float elapsed = duration_elapsed(&s.bench);
 		command_print(CMD_CTX, "wrote file %s to NAND flash %s up to "
-			"offset 0x%8.8" PRIx32 " in %fs (%0.3f KiB/s)",
-			CMD_ARGV[1], CMD_ARGV[0], s.address, duration_elapsed(&s.bench),
-			duration_kbps(&s.bench, total_bytes));
+			"offset 0x%8.8" PRIx32 " in %fs (%0.3f KiB/s, %0.1f pages/s)",
+			CMD_ARGV[1], CMD_ARGV[0], s.address, elapsed,
+			duration_kbps(&s.bench, total_bytes),
+			elapsed > 0 ? pages / elapsed : 0);
 	}
 	return ERROR_OK;
 }
@@ -327,6 +333,7 @@ COMMAND_HANDLER(handle_nand_verify_command)
 
 		file.size -= bytes_read;
 		dev.address += nand->page_size;
+		keep_alive();
 	}
 
 	if (nand_fileio_finish(&file) == ERROR_OK) {
@@ -349,8 +356,8 @@ COMMAND_HANDLER(handle_nand_dump_command)
 	if (ERROR_OK != retval)
 		return retval;
 
+	uint32_t pages = 0;
 	while (s.size > 0) {
-		size_t size_written;
 		retval = nand_read_page(nand, s.address / nand->page_size,
 				s.page, s.page_size, s.oob, s.oob_size);
 		if (ERROR_OK != retval) {
@@ -359,24 +366,33 @@ COMMAND_HANDLER(handle_nand_dump_command)
 			return retval;
 		}
 
-		if (NULL != s.page)
-			fileio_write(s.fileio, s.page_size, s.page, &size_written);
-
-		if (NULL != s.oob)
-			fileio_write(s.fileio, s.oob_size, s.oob, &size_written);
+		retval = nand_fileio_write(&s);
+		if (ERROR_OK != retval) {
+			command_print(CMD_CTX, "error while writing file");
+			nand_fileio_cleanup(&s);
+			return retval;
+		}
 
 		s.size -= nand->page_size;
 		s.address += nand->page_size;
+		pages++;
+		keep_alive();
 	}
 
-	retval = fileio_size(s.fileio, &filesize);
-	if (retval != ERROR_OK)
+	retval = nand_fileio_flush(&s);
+	if (ERROR_OK == retval)
+		retval = fileio_size(s.fileio, &filesize);
+	if (retval != ERROR_OK) {
+		command_print(CMD_CTX, "error while writing file");
+		nand_fileio_cleanup(&s);
 		return retval;
+	}
 
 	if (nand_fileio_finish(&s) == ERROR_OK) {
-		command_print(CMD_CTX, "dumped %zu bytes in %fs (%0.3f KiB/s)",
-			filesize, duration_elapsed(&s.bench),
-			duration_kbps(&s.bench, filesize));
+		float elapsed = duration_elapsed(&s.bench);
+		command_print(CMD_CTX, "dumped %zu bytes in %fs (%0.3f KiB/s, %0.1f pages/s)",
+			filesize, elapsed, duration_kbps(&s.bench, filesize),
+			elapsed > 0 ? pages / elapsed : 0);
 	}
 	return ERROR_OK;
 }
@@ -548,6 +564,8 @@ static COMMAND_HELPER(create_nand_device, const char *bank_name,
 	c->address_cycles = 0;
 	c->page_size = 0;
 	c->use_raw = false;
+	c->page_buffer = NULL;
+	c->page_buffer_size = 0;
 	c->next = NULL;
 
 	retval = CALL_COMMAND_HANDLER(controller->nand_device_command, c);
@@ -611,6 +629,106 @@ static const struct command_registration nand_config_command_handlers[] = {
 	COMMAND_REGISTRATION_DONE
 };
 
+typedef int (*nand_ecc_fn)(struct nand_device *nand, const uint8_t *dat, uint8_t *ecc_code);
+
+/* Time one ECC routine over all of @a data, @a block bytes per code */
+static uint64_t nand_ecc_bench_one(nand_ecc_fn fn, const uint8_t *data, uint32_t size,
+		uint32_t block, uint8_t *ecc, unsigned int ecc_size)
+{
+	struct duration bench;
+
+	duration_start(&bench);
+	for (uint32_t i = 0; i < size / block; i++)
+		fn(NULL, data + i * block, ecc + i * ecc_size);
+	duration_measure(&bench);
+
+	return bench.elapsed.tv_sec * 1000000ULL + bench.elapsed.tv_usec;
+}
+
+static double nand_ecc_bench_kibps(uint32_t bytes, uint64_t us)
+{
+	return us ? bytes * 1000000.0 / 1024 / us : 0;
+}
+
+static int nand_ecc_bench_compare(struct command_context *cmd_ctx, const char *name,
+		nand_ecc_fn fn, nand_ecc_fn ref, const uint8_t *data, uint32_t size,
+		uint32_t block, unsigned int ecc_size)
+{
+	unsigned int codes = size / block;
+	uint8_t *ecc = malloc(codes * ecc_size);
+	uint8_t *ecc_ref = malloc(codes * ecc_size);
+	int retval = ERROR_OK;
+
+	if (ecc == NULL || ecc_ref == NULL) {
+		LOG_ERROR("out of memory");
+		retval = ERROR_FAIL;
+		goto out;
+	}
+
+	uint64_t us = nand_ecc_bench_one(fn, data, size, block, ecc, ecc_size);
+	uint64_t ref_us = nand_ecc_bench_one(ref, data, size, block, ecc_ref, ecc_size);
+
+	command_print(cmd_ctx, "bench nand_ecc %s bytes=%" PRIu32 " us=%" PRIu64
+			" kibps=%.1f ref_us=%" PRIu64 " ref_kibps=%.1f", name, size, us,
+			nand_ecc_bench_kibps(size, us), ref_us,
+			nand_ecc_bench_kibps(size, ref_us));
+
+	if (memcmp(ecc, ecc_ref, codes * ecc_size) != 0) {
+		LOG_ERROR("%s ECC differs from the reference implementation", name);
+		retval = ERROR_FAIL;
+	}
+
+out:
+	free(ecc);
+	free(ecc_ref);
+	return retval;
+}
+
+COMMAND_HANDLER(handle_bench_nand_ecc_command)
+{
+	unsigned int kib = 4096;
+	int retval;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], kib);
+	if (kib == 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	uint32_t size = kib * 1024;
+	uint8_t *data = malloc(size);
+	if (data == NULL) {
+		LOG_ERROR("out of memory");
+		return ERROR_FAIL;
+	}
+
+	for (uint32_t i = 0; i < size; i++)
+		data[i] = rand();
+
+	retval = nand_ecc_bench_compare(CMD_CTX, "hamming", nand_calculate_ecc,
+			nand_calculate_ecc_ref, data, size, 256, 3);
+	if (retval == ERROR_OK)
+		retval = nand_ecc_bench_compare(CMD_CTX, "kw", nand_calculate_ecc_kw,
+				nand_calculate_ecc_kw_ref, data, size, 512, 10);
+
+	free(data);
+
+	return retval;
+}
+
+static const struct command_registration nand_bench_subcommand_handlers[] = {
+	{
+		.name = "nand_ecc",
+		.handler = handle_bench_nand_ecc_command,
+		.mode = COMMAND_EXEC,
+		.help = "measure host side NAND ECC computation against the "
+			"byte at a time reference code, on random data",
+		.usage = "[KiB]",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
 static const struct command_registration nand_command_handlers[] = {
 	{
 		.name = "nand",
@@ -619,6 +737,14 @@ static const struct command_registration nand_command_handlers[] = {
 		.usage = "",
 		.chain = nand_config_command_handlers,
 	},
+	{
+		/* joins the "bench" group of src/target/bench.c */
+		.name = "bench",
+		.mode = COMMAND_EXEC,
+		.help = "adapter and target benchmarks",
+		.usage = "",
+		.chain = nand_bench_subcommand_handlers,
+	},
 	COMMAND_REGISTRATION_DONE
 };
 
@@ -420,6 +420,9 @@ static int avrf_mass_erase(struct flash_bank *bank)
 		return ERROR_TARGET_NOT_HALTED;
 	}
 
+	/* the chip erase runs over JTAG programming mode, not the target */
+	flash_sector_state_invalidate(bank);
+
 	if ((ERROR_OK != avr_jtagprg_enterprogmode(avr))
 	    || (ERROR_OK != avr_jtagprg_chiperase(avr))
 	    || (ERROR_OK != avr_jtagprg_leaveprogmode(avr)))
@@ -26,6 +26,7 @@
 #include <flash/nor/core.h>
 #include <flash/nor/imp.h>
 #include <target/image.h>
+#include <helper/tracelog.h>
 
 /**
  * @file
@@ -36,14 +37,210 @@
 
 static struct flash_bank *flash_banks;
 
+/* Another target, such as a second core of the same chip, can change
+ * the flash without moving the memory generation of @a bank's target.
+ * So the cached state is only trusted with a single target configured. */
+static bool flash_state_cacheable(struct flash_bank *bank)
+{
+	return all_targets == bank->target && bank->target->next == NULL;
+}
+
+/* The cached erase state of the sectors of @a bank. Entries go back to
+ * unknown (-1) when the target may have changed the flash since they were
+ * recorded. NULL if there is no memory for it, or nothing is cached. */
+static int *flash_sector_state(struct flash_bank *bank)
+{
+	int i;
+
+	if (!flash_state_cacheable(bank)) {
+		flash_sector_state_invalidate(bank);
+		return NULL;
+	}
+
+	if (bank->num_erase_state != bank->num_sectors) {
+		free(bank->erase_state);
+		bank->num_erase_state = 0;
+		bank->erase_state = NULL;
+		if (bank->num_sectors <= 0)
+			return NULL;
+
+		bank->erase_state = malloc(bank->num_sectors * sizeof(*bank->erase_state));
+		if (bank->erase_state == NULL)
+			return NULL;
+		bank->num_erase_state = bank->num_sectors;
+
+		for (i = 0; i < bank->num_erase_state; i++)
+			bank->erase_state[i] = -1;
+	} else if (bank->sector_state_generation != bank->target->memory_generation) {
+		for (i = 0; i < bank->num_erase_state; i++)
+			bank->erase_state[i] = -1;
+	}
+
+	bank->sector_state_generation = bank->target->memory_generation;
+
+	return bank->erase_state;
+}
+
+/* Record the erase state of sectors @a first to @a last after an operation
+ * of ours, started after @a state was obtained from flash_sector_state().
+ * The operation is known to be the only change since, so the other
+ * sectors keep their state. */
+static void flash_sector_state_set(struct flash_bank *bank, int *state,
+		int first, int last, int is_erased)
+{
+	int i;
+
+	if (state == NULL || last >= bank->num_erase_state)
+		return;
+
+	for (i = first; i <= last; i++)
+		state[i] = is_erased;
+
+	bank->sector_state_generation = bank->target->memory_generation;
+}
+
+void flash_sector_state_invalidate(struct flash_bank *bank)
+{
+	free(bank->erase_state);
+	bank->erase_state = NULL;
+	bank->num_erase_state = 0;
+	bank->protect_state_valid = false;
+}
+
+void flash_target_state_invalidate(struct target *target)
+{
+	for (struct flash_bank *bank = flash_banks; bank; bank = bank->next) {
+		if (bank->target == target)
+			flash_sector_state_invalidate(bank);
+	}
+}
+
 int flash_driver_erase(struct flash_bank *bank, int first, int last)
 {
 	int retval;
+	int *state = flash_sector_state(bank);
 
+	TRACELOG(TRACELOG_FLASH_ERASE, TRACELOG_BEGIN, last - first + 1);
 	retval = bank->driver->erase(bank, first, last);
+	TRACELOG(TRACELOG_FLASH_ERASE, TRACELOG_END, retval);
 	if (retval != ERROR_OK)
 		LOG_ERROR("failed erasing sectors %d to %d", first, last);
 
+	flash_sector_state_set(bank, state, first, last, retval == ERROR_OK ? 1 : -1);
+
+	return retval;
+}
+
+/* Erase the sectors from @a first to @a last which aren't known to be
+ * erased already, in as few calls to the driver as possible. */
+static int flash_driver_erase_dirty(struct flash_bank *bank, int first, int last)
+{
+	int *state = flash_sector_state(bank);
+	int skipped = 0;
+	int retval;
+	int i;
+
+	if (state == NULL)
+		return flash_driver_erase(bank, first, last);
+
+	while (first <= last) {
+		if (state[first] == 1) {
+			skipped++;
+			first++;
+			continue;
+		}
+
+		for (i = first; i < last && state[i + 1] != 1; i++)
+			;
+
+		retval = flash_driver_erase(bank, first, i);
+		if (retval != ERROR_OK)
+			return retval;
+
+		first = i + 1;
+
+		/* the erase may have resized the bank, then erase the rest */
+		state = flash_sector_state(bank);
+		if (first <= last && (state == NULL || last >= bank->num_erase_state))
+			return flash_driver_erase(bank, first, last);
+	}
+
+	if (skipped)
+		LOG_DEBUG("skipped erasing %d sectors known to be erased", skipped);
+
+	return ERROR_OK;
+}
+
+int flash_driver_erase_check(struct flash_bank *bank)
+{
+	int *state = NULL;
+	int retval;
+	int i;
+
+	/* leave a target which isn't halted to the driver, which fails */
+	if (bank->target->state == TARGET_HALTED)
+		state = flash_sector_state(bank);
+
+	if (state != NULL) {
+		for (i = 0; i < bank->num_sectors; i++) {
+			if (state[i] != 0 && state[i] != 1)
+				break;
+		}
+
+		/* the whole bank is known from our own erase operations or an
+		 * earlier check, and nothing has changed it since */
+		if (i == bank->num_sectors) {
+			LOG_DEBUG("using cached erase state of flash bank %d", bank->bank_number);
+			for (i = 0; i < bank->num_sectors; i++)
+				bank->sectors[i].is_erased = state[i];
+			return ERROR_OK;
+		}
+	}
+
+	retval = bank->driver->erase_check(bank);
+	if (retval != ERROR_OK || state == NULL || bank->num_erase_state != bank->num_sectors)
+		return retval;
+
+	for (i = 0; i < bank->num_sectors; i++)
+		state[i] = bank->sectors[i].is_erased;
+	bank->sector_state_generation = bank->target->memory_generation;
+
+	return retval;
+}
+
+int flash_driver_protect_check(struct flash_bank *bank)
+{
+	struct flash_sector *block_array = bank->sectors;
+	int num_blocks = bank->num_sectors;
+	int retval;
+	int i;
+
+	if (bank->num_prot_blocks && bank->prot_blocks) {
+		block_array = bank->prot_blocks;
+		num_blocks = bank->num_prot_blocks;
+	}
+
+	/* Protection can only change by target memory writes, code running on
+	 * the target or a reset, all of which move the memory generation on;
+	 * and by flash_driver_protect(), which invalidates this. */
+	if (bank->protect_state_valid && flash_state_cacheable(bank)
+			&& bank->target->state == TARGET_HALTED
+			&& bank->protect_state_generation == bank->target->memory_generation) {
+		for (i = 0; i < num_blocks; i++) {
+			if (block_array[i].is_protected != 0 && block_array[i].is_protected != 1)
+				break;
+		}
+		if (i == num_blocks) {
+			LOG_DEBUG("using cached protection state of flash bank %d", bank->bank_number);
+			return ERROR_OK;
+		}
+	}
+
+	retval = bank->driver->protect_check(bank);
+	bank->protect_state_valid = (retval == ERROR_OK
+			&& bank->target->state == TARGET_HALTED);
+	bank->protect_state_generation = bank->target->memory_generation;
+
 	return retval;
 }
 
@@ -78,6 +275,7 @@ int flash_driver_protect(struct flash_bank *bank, int set, int first, int last)
 	 *
 	 * Drivers only receive valid protection block range.
 	 */
+	bank->protect_state_valid = false;
 	retval = bank->driver->protect(bank, set, first, last);
 	if (retval != ERROR_OK)
 		LOG_ERROR("failed setting protection for blocks %d to %d", first, last);
@@ -89,8 +287,14 @@ int flash_driver_write(struct flash_bank *bank,
 	uint8_t *buffer, uint32_t offset, uint32_t count)
 {
 	int retval;
+	int *state = flash_sector_state(bank);
+	int first = -1;
+	int last = -1;
+	int i;
 
+	TRACELOG(TRACELOG_FLASH_WRITE, TRACELOG_BEGIN, count);
 	retval = bank->driver->write(bank, buffer, offset, count);
+	TRACELOG(TRACELOG_FLASH_WRITE, TRACELOG_END, retval);
 	if (retval != ERROR_OK) {
 		LOG_ERROR(
 			"error writing to flash at address 0x%08" PRIx32 " at offset 0x%8.8" PRIx32,
@@ -98,6 +302,21 @@ int flash_driver_write(struct flash_bank *bank,
 			offset);
 	}
 
+	/* the sectors written to may no longer be erased; they are left
+	 * unknown rather than not erased, as the data written can equal
+	 * the erased value */
+	for (i = 0; i < bank->num_sectors && count > 0; i++) {
+		struct flash_sector *f = &bank->sectors[i];
+
+		if (f->offset < offset + count && f->offset + f->size > offset) {
+			if (first < 0)
+				first = i;
+			last = i;
+		}
+	}
+	if (first >= 0)
+		flash_sector_state_set(bank, state, first, last, -1);
+
 	return retval;
 }
 
@@ -261,12 +480,34 @@ int get_flash_bank_by_addr(struct target *target,
 	return ERROR_OK;
 }
 
-static int default_flash_mem_blank_check(struct flash_bank *bank)
+/* compare a word at a time, the tail byte by byte */
+static bool default_flash_buffer_is_erased(const uint8_t *buffer, uint32_t size,
+		uint8_t erased_value)
+{
+	const uint64_t pattern = erased_value * 0x0101010101010101ULL;
+	uint64_t word;
+	uint32_t i;
+
+	for (i = 0; i + sizeof(word) <= size; i += sizeof(word)) {
+		memcpy(&word, buffer + i, sizeof(word));
+		if (word != pattern)
+			return false;
+	}
+
+	for (; i < size; i++) {
+		if (buffer[i] != erased_value)
+			return false;
+	}
+
+	return true;
+}
+
+/* read back the sectors from @a first on and check them on the host */
+static int default_flash_mem_blank_check(struct flash_bank *bank, int first)
 {
 	struct target *target = bank->target;
-	const int buffer_size = 1024;
+	const uint32_t buffer_size = 64 * 1024;
 	int i;
-	uint32_t nBytes;
 	int retval = ERROR_OK;
 
 	if (bank->target->state != TARGET_HALTED) {
@@ -275,31 +516,34 @@ static int default_flash_mem_blank_check(struct flash_bank *bank)
 	}
 
 	uint8_t *buffer = malloc(buffer_size);
+	if (buffer == NULL) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
 
-	for (i = 0; i < bank->num_sectors; i++) {
+	for (i = first; i < bank->num_sectors; i++) {
 		uint32_t j;
 		bank->sectors[i].is_erased = 1;
 
 		for (j = 0; j < bank->sectors[i].size; j += buffer_size) {
 			uint32_t chunk;
 			chunk = buffer_size;
-			if (chunk > (j - bank->sectors[i].size))
-				chunk = (j - bank->sectors[i].size);
+			if (chunk > (bank->sectors[i].size - j))
+				chunk = (bank->sectors[i].size - j);
 
-			retval = target_read_memory(target,
+			retval = target_read_buffer(target,
 					bank->base + bank->sectors[i].offset + j,
-					4,
-					chunk/4,
+					chunk,
 					buffer);
 			if (retval != ERROR_OK)
 				goto done;
 
-			for (nBytes = 0; nBytes < chunk; nBytes++) {
-				if (buffer[nBytes] != bank->erased_value) {
-					bank->sectors[i].is_erased = 0;
-					break;
-				}
+			if (!default_flash_buffer_is_erased(buffer, chunk, bank->erased_value)) {
+				bank->sectors[i].is_erased = 0;
+				break;
 			}
+
+			keep_alive();
 		}
 	}
 
@@ -312,38 +556,50 @@ done:
 int default_flash_blank_check(struct flash_bank *bank)
 {
 	struct target *target = bank->target;
+	struct target_memory_check_block *blocks;
 	int i;
-	int retval;
-	int fast_check = 0;
-	uint32_t blank;
+	int retval = ERROR_OK;
 
 	if (bank->target->state != TARGET_HALTED) {
 		LOG_ERROR("Target not halted");
 		return ERROR_TARGET_NOT_HALTED;
 	}
 
+	if (bank->num_sectors == 0)
+		return ERROR_OK;
+
+	blocks = malloc(bank->num_sectors * sizeof(*blocks));
+	if (blocks == NULL) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
+
 	for (i = 0; i < bank->num_sectors; i++) {
-		uint32_t address = bank->base + bank->sectors[i].offset;
-		uint32_t size = bank->sectors[i].size;
+		blocks[i].address = bank->base + bank->sectors[i].offset;
+		blocks[i].size = bank->sectors[i].size;
+	}
 
-		retval = target_blank_check_memory(target, address, size, &blank, bank->erased_value);
-		if (retval != ERROR_OK) {
-			fast_check = 0;
+	/* as many sectors per algorithm run as the target can take */
+	i = 0;
+	while (i < bank->num_sectors) {
+		retval = target_blank_check_memory_blocks(target, blocks + i,
+				bank->num_sectors - i, bank->erased_value);
+		if (retval < 0)
 			break;
-		}
-		if (blank == bank->erased_value)
-			bank->sectors[i].is_erased = 1;
-		else
-			bank->sectors[i].is_erased = 0;
-		fast_check = 1;
+
+		for (int n = i + retval; i < n; i++)
+			bank->sectors[i].is_erased = (blocks[i].result == bank->erased_value);
+		retval = ERROR_OK;
 	}
 
-	if (!fast_check) {
+	free(blocks);
+
+	if (i < bank->num_sectors) {
 		LOG_USER("Running slow fallback erase check - add working memory");
-		return default_flash_mem_blank_check(bank);
+		return default_flash_mem_blank_check(bank, i);
 	}
 
-	return ERROR_OK;
+	return retval;
 }
 
 /* Manipulate given flash region, selecting the bank according to target
@@ -749,9 +1005,11 @@ int flash_write_unlock(struct target *target, struct image *image,
 			retval = flash_unlock_address_range(target, run_address, run_size);
 		if (retval == ERROR_OK) {
 			if (erase) {
-				/* calculate and erase sectors */
-				retval = flash_erase_address_range(target,
-						true, run_address, run_size);
+				/* calculate and erase sectors, skipping those which
+				 * are still erased from before */
+				retval = flash_iterate_address_range(target, "erase",
+						run_address, run_size, false,
+						&flash_driver_erase_dirty);
 			}
 		}
 
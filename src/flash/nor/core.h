@@ -116,6 +116,22 @@ struct flash_bank {
 	/** Array of protection blocks, allocated and initilized by the flash driver */
 	struct flash_sector *prot_blocks;
 
+	/**
+	 * Erase state of each sector as left by our own erase and write
+	 * operations or found by the last erase check, same values as
+	 * @c flash_sector::is_erased. Kept by the flash core, it holds as
+	 * long as the memory_generation of the target is still
+	 * @a sector_state_generation: nothing ran on the target and nothing
+	 * else wrote to it since.
+	 */
+	int *erase_state;
+	int num_erase_state;
+	uint32_t sector_state_generation;
+	/** The protection flags were read by protect_check at
+	 * @a protect_state_generation and not changed by us since. */
+	bool protect_state_valid;
+	uint32_t protect_state_generation;
+
 	struct flash_bank *next; /**< The next flash bank on this chip */
 };
 
@@ -153,6 +169,14 @@ int flash_write(struct target *target,
  * This routine must be called when the system may modify the status.
  */
 void flash_set_dirty(void);
+/**
+ * Forgets the erase and protection state cached for @a bank. Needed
+ * only by drivers changing the flash other than through target memory
+ * accesses, e.g. over a separate JTAG TAP.
+ */
+void flash_sector_state_invalidate(struct flash_bank *bank);
+/** Forgets the state cached for all flash banks of @a target. */
+void flash_target_state_invalidate(struct target *target);
 /** @returns The number of flash banks currently defined. */
 int flash_get_bank_count(void);
 /**
@@ -26,6 +26,14 @@
 
 #define JTAGSPI_MAX_TIMEOUT 3000
 
+/* pages programmed per JTAG queue execution */
+#define JTAGSPI_BATCH_PAGES 64
+/* initial wait between queued page programs, most parts need less */
+#define JTAGSPI_PAGE_DELAY_US 1000
+#define JTAGSPI_MAX_PAGE_DELAY_US 10000
+/* bytes read per JTAG queue execution */
+#define JTAGSPI_READ_CHUNK (256 * 1024)
+
 
 struct jtagspi_flash_bank {
 	struct jtag_tap *tap;
@@ -75,7 +83,10 @@ static void flip_u8(uint8_t *in, uint8_t *out, int len)
 		out[i] = flip_u32(in[i], 8);
 }
 
-static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
+/* Queue a command without running the queue; @a len as for jtagspi_cmd().
+ * Read data is left bit reversed in @a data until jtagspi_read_done().
+ */
+static int jtagspi_queue_cmd(struct flash_bank *bank, uint8_t cmd,
 		uint32_t *addr, uint8_t *data, int len)
 {
 	struct jtagspi_flash_bank *info = bank->driver_priv;
@@ -127,12 +138,8 @@ static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
 	}
 
 	lenb = DIV_ROUND_UP(len, 8);
-	data_buf = malloc(lenb);
+	data_buf = NULL;
 	if (lenb > 0) {
-		if (data_buf == NULL) {
-			LOG_ERROR("no memory for spi buffer");
-			return ERROR_FAIL;
-		}
 		if (is_read) {
 			fields[n].num_bits = jtag_tap_count_enabled();
 			fields[n].out_value = NULL;
@@ -140,8 +147,13 @@ static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
 			n++;
 
 			fields[n].out_value = NULL;
-			fields[n].in_value = data_buf;
+			fields[n].in_value = data;
 		} else {
+			data_buf = malloc(lenb);
+			if (data_buf == NULL) {
+				LOG_ERROR("no memory for spi buffer");
+				return ERROR_FAIL;
+			}
 			flip_u8(data, data_buf, lenb);
 			fields[n].out_value = data_buf;
 			fields[n].in_value = NULL;
@@ -153,14 +165,35 @@ static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
 	jtagspi_set_ir(bank);
 	/* passing from an IR scan to SHIFT-DR clears BYPASS registers */
 	jtag_add_dr_scan(info->tap, n, fields, TAP_IDLE);
-	jtag_execute_queue();
 
-	if (is_read)
-		flip_u8(data_buf, data, lenb);
+	/* the queue has its own copy of the data to write */
 	free(data_buf);
 	return ERROR_OK;
 }
 
+static void jtagspi_read_done(uint8_t *data, int lenb)
+{
+	flip_u8(data, data, lenb);
+}
+
+static int jtagspi_cmd(struct flash_bank *bank, uint8_t cmd,
+		uint32_t *addr, uint8_t *data, int len)
+{
+	int retval;
+
+	retval = jtagspi_queue_cmd(bank, cmd, addr, data, len);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = jtag_execute_queue();
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (len < 0)
+		jtagspi_read_done(data, DIV_ROUND_UP(-len, 8));
+	return ERROR_OK;
+}
+
 static int jtagspi_probe(struct flash_bank *bank)
 {
 	struct jtagspi_flash_bank *info = bank->driver_priv;
@@ -282,11 +315,26 @@ static int jtagspi_sector_erase(struct flash_bank *bank, int sector)
 	struct jtagspi_flash_bank *info = bank->driver_priv;
 	int retval;
 	int64_t t0 = timeval_ms();
-
-	retval = jtagspi_write_enable(bank);
+	uint8_t status;
+
+	/* write enable, its check and the erase take one queue execution;
+	 * the device ignores the erase if write enable didn't take */
+	jtagspi_queue_cmd(bank, SPIFLASH_WRITE_ENABLE, NULL, NULL, 0);
+	jtagspi_queue_cmd(bank, SPIFLASH_READ_STATUS, NULL, &status, -8);
+	retval = jtagspi_queue_cmd(bank, info->dev->erase_cmd,
+			&bank->sectors[sector].offset, NULL, 0);
+	if (retval == ERROR_OK)
+		retval = jtag_execute_queue();
 	if (retval != ERROR_OK)
 		return retval;
-	jtagspi_cmd(bank, info->dev->erase_cmd, &bank->sectors[sector].offset, NULL, 0);
+	jtagspi_read_done(&status, 1);
+	if ((status & SPIFLASH_WE_BIT) == 0) {
+		LOG_ERROR("Cannot enable write to flash. Status=0x%02" PRIx8, status);
+		return ERROR_FAIL;
+	}
+
+	/* a sector erase takes tens of ms at least, so polling it
+	 * at the 1 ms pace of jtagspi_wait() costs little */
 	retval = jtagspi_wait(bank, JTAGSPI_MAX_TIMEOUT);
 	LOG_INFO("sector %d took %" PRId64 " ms", sector, timeval_ms() - t0);
 	return retval;
@@ -366,7 +414,30 @@ static int jtagspi_read(struct flash_bank *bank, uint8_t *buffer, uint32_t offse
 		return ERROR_FLASH_BANK_NOT_PROBED;
 	}
 
-	jtagspi_cmd(bank, SPIFLASH_READ, &offset, buffer, -count*8);
+	struct duration bench;
+	uint32_t total = count;
+	int retval;
+
+	duration_start(&bench);
+
+	/* one command per chunk, so the scan sizes stay within what adapters
+	 * and the bitstream's 32 bit counter handle */
+	while (count > 0) {
+		uint32_t chunk = MIN(count, JTAGSPI_READ_CHUNK);
+
+		retval = jtagspi_cmd(bank, SPIFLASH_READ, &offset, buffer, -chunk * 8);
+		if (retval != ERROR_OK)
+			return retval;
+
+		buffer += chunk;
+		offset += chunk;
+		count -= chunk;
+		keep_alive();
+	}
+
+	if (duration_measure(&bench) == ERROR_OK && total > JTAGSPI_READ_CHUNK)
+		LOG_INFO("read %" PRIu32 " bytes in %fs (%0.3f MiB/s)", total,
+			duration_elapsed(&bench), duration_kbps(&bench, total) / 1024);
 	return ERROR_OK;
 }
 
@@ -381,26 +452,134 @@ static int jtagspi_page_write(struct flash_bank *bank, const uint8_t *buffer, ui
 	return jtagspi_wait(bank, JTAGSPI_MAX_TIMEOUT);
 }
 
+/* Wait about @a us in the JTAG queue, by clocking in Run-Test/Idle when the
+ * clock rate is known so the queue doesn't have to be flushed.
+ */
+static void jtagspi_queue_delay(unsigned int us)
+{
+	int khz;
+
+	if (jtag_get_speed_readable(&khz) == ERROR_OK && khz > 0)
+		jtag_add_runtest(DIV_ROUND_UP(us * khz, 1000), TAP_IDLE);
+	else
+		jtag_add_sleep(us);
+}
+
+/*
+ * Program up to JTAGSPI_BATCH_PAGES pages in one JTAG queue execution.
+ * Before each page the queue waits page_delay_us and reads the status, and
+ * again after write enable. The device ignores write enable and program
+ * while busy, so a page whose second status was still busy, or whose write
+ * enable didn't take, simply wasn't programmed: it's left in @a failed
+ * for a slow retry. A busy status makes the delay longer.
+ */
+static int jtagspi_write_batch(struct flash_bank *bank, const uint8_t *buffer,
+		uint32_t offset, uint32_t count, unsigned int *page_delay_us,
+		bool *failed, unsigned int *num_pages)
+{
+	struct jtagspi_flash_bank *info = bank->driver_priv;
+	uint32_t pagesize = info->dev->pagesize;
+	uint8_t status[JTAGSPI_BATCH_PAGES][2];
+	unsigned int pages = 0;
+	uint32_t n;
+	int retval;
+
+	for (n = 0; n < count && pages < JTAGSPI_BATCH_PAGES; pages++) {
+		uint32_t addr = offset + n;
+		/* pages must not cross a page boundary of the device */
+		uint32_t len = MIN(count - n, pagesize - addr % pagesize);
+
+		if (pages > 0)
+			jtagspi_queue_delay(*page_delay_us);
+		jtagspi_queue_cmd(bank, SPIFLASH_READ_STATUS, NULL, &status[pages][0], -8);
+		jtagspi_queue_cmd(bank, SPIFLASH_WRITE_ENABLE, NULL, NULL, 0);
+		jtagspi_queue_cmd(bank, SPIFLASH_READ_STATUS, NULL, &status[pages][1], -8);
+		retval = jtagspi_queue_cmd(bank, SPIFLASH_PAGE_PROGRAM, &addr,
+				(uint8_t *) buffer + n, len * 8);
+		if (retval != ERROR_OK)
+			return retval;
+		n += len;
+	}
+
+	retval = jtag_execute_queue();
+	if (retval != ERROR_OK)
+		return retval;
+
+	bool slow = false;
+	for (unsigned int i = 0; i < pages; i++) {
+		jtagspi_read_done(status[i], 2);
+		/* the status after write enable is what the program saw */
+		failed[i] = (status[i][1] & SPIFLASH_BSY_BIT)
+			|| !(status[i][1] & SPIFLASH_WE_BIT);
+		if ((status[i][0] | status[i][1]) & SPIFLASH_BSY_BIT)
+			slow = true;
+	}
+
+	if (slow && *page_delay_us < JTAGSPI_MAX_PAGE_DELAY_US) {
+		*page_delay_us *= 2;
+		LOG_DEBUG("page program slower than expected, waiting %u us per page",
+			*page_delay_us);
+	}
+
+	*num_pages = pages;
+	return jtagspi_wait(bank, JTAGSPI_MAX_TIMEOUT);
+}
+
 static int jtagspi_write(struct flash_bank *bank, const uint8_t *buffer, uint32_t offset, uint32_t count)
 {
 	struct jtagspi_flash_bank *info = bank->driver_priv;
+	unsigned int page_delay_us = JTAGSPI_PAGE_DELAY_US;
+	bool failed[JTAGSPI_BATCH_PAGES];
+	struct duration bench;
+	uint32_t pagesize, total = count;
 	int retval;
-	uint32_t n;
 
 	if (!(info->probed)) {
 		LOG_ERROR("Flash bank not yet probed.");
 		return ERROR_FLASH_BANK_NOT_PROBED;
 	}
 
-	for (n = 0; n < count; n += info->dev->pagesize) {
-		retval = jtagspi_page_write(bank, buffer + n, offset + n,
-				MIN(count - n, info->dev->pagesize));
+	pagesize = info->dev->pagesize;
+	duration_start(&bench);
+
+	/* the first page must not start programming while a previous
+	 * operation is still running */
+	retval = jtagspi_wait(bank, JTAGSPI_MAX_TIMEOUT);
+	if (retval != ERROR_OK)
+		return retval;
+
+	while (count > 0) {
+		unsigned int pages;
+
+		retval = jtagspi_write_batch(bank, buffer, offset, count,
+				&page_delay_us, failed, &pages);
 		if (retval != ERROR_OK) {
 			LOG_ERROR("page write error");
 			return retval;
 		}
-		LOG_DEBUG("wrote page at 0x%08" PRIx32, offset + n);
+
+		for (unsigned int i = 0; i < pages; i++) {
+			uint32_t len = MIN(count, pagesize - offset % pagesize);
+
+			if (failed[i]) {
+				LOG_DEBUG("retrying page at 0x%08" PRIx32, offset);
+				retval = jtagspi_page_write(bank, buffer, offset, len);
+				if (retval != ERROR_OK) {
+					LOG_ERROR("page write error");
+					return retval;
+				}
+			}
+
+			buffer += len;
+			offset += len;
+			count -= len;
+		}
+		keep_alive();
 	}
+
+	if (duration_measure(&bench) == ERROR_OK)
+		LOG_INFO("wrote %" PRIu32 " bytes in %fs (%0.3f MiB/s)", total,
+			duration_elapsed(&bench), duration_kbps(&bench, total) / 1024);
 	return ERROR_OK;
 }
 
@@ -579,6 +579,9 @@ COMMAND_HANDLER(kinetis_mdm_mass_erase)
 		return ERROR_FAIL;
 	}
 
+	/* the flash is mass erased over the MDM-AP, not by the target */
+	flash_target_state_invalidate(target);
+
 	int retval;
 
 	/*
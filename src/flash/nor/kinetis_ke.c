@@ -509,6 +509,9 @@ COMMAND_HANDLER(kinetis_ke_mdm_mass_erase)
 		return ERROR_FAIL;
 	}
 
+	/* the flash is mass erased over the MDM-AP, not by the target */
+	flash_target_state_invalidate(target);
+
 	int retval;
 
 	/* According to chapter 18.3.7.2 of the KE02 reference manual */
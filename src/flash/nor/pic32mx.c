@@ -911,6 +911,7 @@ COMMAND_HANDLER(pic32mx_handle_unlock_command)
 	}
 
 	/* unlock/erase device */
+	flash_sector_state_invalidate(bank);
 	mips_ejtag_drscan_8_out(ejtag_info, MCHP_ASERT_RST);
 	jtag_add_sleep(200);
 
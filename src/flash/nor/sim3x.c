@@ -972,6 +972,9 @@ COMMAND_HANDLER(sim3x_mass_erase)
 		return ERROR_FAIL;
 	}
 
+	/* the flash is mass erased over the debug port, not by the target */
+	flash_target_state_invalidate(target);
+
 	/* Mass erase sequence */
 	ret = ap_write_register(dap, SIM3X_AP_CTRL1, SIM3X_AP_CTRL1_RESET_REQ);
 	if (ret != ERROR_OK)
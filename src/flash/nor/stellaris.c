@@ -1364,6 +1364,9 @@ COMMAND_HANDLER(stellaris_handle_recover_command)
 	if (!bank)
 		return ERROR_FAIL;
 
+	/* the flash is mass erased over the debug port, not by the target */
+	flash_sector_state_invalidate(bank);
+
 	/* REVISIT ... it may be worth sanity checking that the AP is
 	 * inactive before we start.  ARM documents that switching a DP's
 	 * mode while it's active can cause fault modes that need a power
@@ -525,6 +525,7 @@ static int str9xpec_protect(struct flash_bank *bank, int set, int first, int las
 		else {
 			/* perform full erase to unlock device */
 			status = str9xpec_unlock_device(bank);
+			flash_sector_state_invalidate(bank);
 		}
 	} else {
 		for (i = first; i <= last; i++) {
@@ -881,6 +882,7 @@ COMMAND_HANDLER(str9xpec_handle_flash_options_write_command)
 		return retval;
 
 	status = str9xpec_write_options(bank);
+	flash_sector_state_invalidate(bank);
 
 	if ((status & ISC_STATUS_ERROR) != STR9XPEC_ISC_SUCCESS)
 		return ERROR_FLASH_OPERATION_FAILED;
@@ -993,6 +995,7 @@ COMMAND_HANDLER(str9xpec_handle_flash_lock_command)
 		return retval;
 
 	status = str9xpec_lock_device(bank);
+	flash_sector_state_invalidate(bank);
 
 	if ((status & ISC_STATUS_ERROR) != STR9XPEC_ISC_SUCCESS)
 		return ERROR_FLASH_OPERATION_FAILED;
@@ -1013,6 +1016,7 @@ COMMAND_HANDLER(str9xpec_handle_flash_unlock_command)
 		return retval;
 
 	status = str9xpec_unlock_device(bank);
+	flash_sector_state_invalidate(bank);
 
 	if ((status & ISC_STATUS_ERROR) != STR9XPEC_ISC_SUCCESS)
 		return ERROR_FLASH_OPERATION_FAILED;
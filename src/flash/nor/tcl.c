@@ -97,8 +97,9 @@ COMMAND_HANDLER(handle_flash_info_command)
 		if (retval != ERROR_OK)
 			return retval;
 
-		/* We must query the hardware to avoid printing stale information! */
-		retval = p->driver->protect_check(p);
+		/* We must query the hardware to avoid printing stale information,
+		 * unless nothing could have changed it since the last query */
+		retval = flash_driver_protect_check(p);
 		if (retval != ERROR_OK)
 			return retval;
 
@@ -191,7 +192,7 @@ COMMAND_HANDLER(handle_flash_erase_check_command)
 		return retval;
 
 	int j;
-	retval = p->driver->erase_check(p);
+	retval = flash_driver_erase_check(p);
 	if (retval == ERROR_OK)
 		command_print(CMD_CTX, "successfully checked erase state");
 	else {
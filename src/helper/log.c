@@ -61,6 +61,13 @@ static const char * const log_strings[6] = {
 
 static int count;
 
+/* Size of the stdio buffer of the log output. Debug messages stay in there
+ * until the server loop goes idle, keep_alive() prints its message or a
+ * message of a higher level is logged, unless log_buffering is off. */
+#define LOG_BUFFER_SIZE		(64 * 1024)
+
+static bool log_buffering = true;
+
 static struct store_log_forward *log_head;
 static int log_forward_count;
 
@@ -114,6 +121,26 @@ static void log_forward(const char *file, unsigned line, const char *function, c
  * target_request.c).
  *
  */
+static void log_header(enum log_levels level, const char *file, int line,
+	const char *function)
+{
+	/* print with count and time information */
+	int64_t t = timeval_ms() - start;
+#ifdef _DEBUG_FREE_SPACE_
+	struct mallinfo info;
+	info = mallinfo();
+#endif
+	fprintf(log_output, "%s%d %" PRId64 " %s:%d %s()"
+#ifdef _DEBUG_FREE_SPACE_
+		" %d"
+#endif
+		": ", log_strings[level + 1], count, t, file, line, function
+#ifdef _DEBUG_FREE_SPACE_
+		, info.fordblks
+#endif
+		);
+}
+
 static void log_puts(enum log_levels level,
 	const char *file,
 	int line,
@@ -134,21 +161,8 @@ static void log_puts(enum log_levels level,
 
 	if (strlen(string) > 0) {
 		if (debug_level >= LOG_LVL_DEBUG) {
-			/* print with count and time information */
-			int64_t t = timeval_ms() - start;
-#ifdef _DEBUG_FREE_SPACE_
-			struct mallinfo info;
-			info = mallinfo();
-#endif
-			fprintf(log_output, "%s%d %" PRId64 " %s:%d %s()"
-#ifdef _DEBUG_FREE_SPACE_
-				" %d"
-#endif
-				": %s", log_strings[level + 1], count, t, file, line, function,
-#ifdef _DEBUG_FREE_SPACE_
-				info.fordblks,
-#endif
-				string);
+			log_header(level, file, line, function);
+			fputs(string, log_output);
 		} else {
 			/* if we are using gdb through pipes then we do not want any output
 			 * to the pipe otherwise we get repeated strings */
@@ -160,7 +174,8 @@ static void log_puts(enum log_levels level,
 		 *nothing. */
 	}
 
-	fflush(log_output);
+	if (!log_buffering || level <= LOG_LVL_INFO)
+		fflush(log_output);
 
 	/* Never forward LOG_LVL_DEBUG, too verbose and they can be found in the log if need be */
 	if (level <= LOG_LVL_INFO)
@@ -202,6 +217,16 @@ void log_vprintf_lf(enum log_levels level, const char *file, unsigned line,
 	if (level > debug_level)
 		return;
 
+	if (log_buffering && level >= LOG_LVL_DEBUG) {
+		/* Debug messages are not forwarded, so there is no need to build
+		 * the string. Format it straight into the output buffer. */
+		const char *f = strrchr(file, '/');
+		log_header(level, f ? f + 1 : file, line, function);
+		vfprintf(log_output, format, args);
+		fputc('\n', log_output);
+		return;
+	}
+
 	tmp = alloc_vprintf(format, args);
 
 	if (!tmp)
@@ -248,6 +273,19 @@ COMMAND_HANDLER(handle_debug_level_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_log_buffering_command)
+{
+	if (CMD_ARGC == 1) {
+		COMMAND_PARSE_ON_OFF(CMD_ARGV[0], log_buffering);
+		log_flush();
+	} else if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	command_print(CMD_CTX, "log buffering is %s", log_buffering ? "on" : "off");
+
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_log_output_command)
 {
 	if (CMD_ARGC == 1) {
@@ -261,6 +299,7 @@ COMMAND_HANDLER(handle_log_output_command)
 			fclose(log_output);
 		}
 		log_output = file;
+		setvbuf(log_output, NULL, _IOFBF, LOG_BUFFER_SIZE);
 	}
 
 	return ERROR_OK;
@@ -284,6 +323,14 @@ static struct command_registration log_command_handlers[] = {
 			"4 adds extra verbose debugging.",
 		.usage = "number",
 	},
+	{
+		.name = "log_buffering",
+		.handler = handle_log_buffering_command,
+		.mode = COMMAND_ANY,
+		.help = "hold debug messages in a buffer instead of writing "
+			"each one out right away (default: on)",
+		.usage = "['on'|'off']",
+	},
 	COMMAND_REGISTRATION_DONE
 };
 
@@ -309,8 +356,10 @@ void log_init(void)
 				debug_level = value;
 	}
 
-	if (log_output == NULL)
+	if (log_output == NULL) {
 		log_output = stderr;
+		setvbuf(log_output, NULL, _IOFBF, LOG_BUFFER_SIZE);
+	}
 
 	start = last_time = timeval_ms();
 }
@@ -321,6 +370,13 @@ int set_log_output(struct command_context *cmd_ctx, FILE *output)
 	return ERROR_OK;
 }
 
+/* Write out buffered messages, called when there is time for it */
+void log_flush(void)
+{
+	if (log_output)
+		fflush(log_output);
+}
+
 /* add/remove log callback handler */
 int log_add_callback(log_callback_fn fn, void *priv)
 {
@@ -73,6 +73,7 @@ __attribute__ ((format (PRINTF_ATTRIBUTE_FORMAT, 5, 6)));
  */
 void log_init(void);
 int set_log_output(struct command_context *cmd_ctx, FILE *output);
+void log_flush(void);
 
 int log_register_commands(struct command_context *cmd_ctx);
 
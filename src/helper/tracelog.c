@@ -0,0 +1,172 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "tracelog.h"
+#include "log.h"
+#include "command.h"
+#include "time_support.h"
+#include "binarybuffer.h"
+
+#define TRACELOG_BUFFER_SIZE	(256 * 1024)
+
+bool tracelog_enabled;
+
+static FILE *tracelog_file;
+static char *tracelog_filename;
+static struct timeval tracelog_start;
+static uint64_t tracelog_records;
+
+void tracelog_record(enum tracelog_event event, enum tracelog_phase phase, uint32_t arg)
+{
+	struct timeval now, elapsed;
+	uint8_t record[TRACELOG_RECORD_SIZE];
+
+	gettimeofday(&now, NULL);
+	timeval_subtract(&elapsed, &now, &tracelog_start);
+
+	h_u64_to_le(record, elapsed.tv_sec * 1000000ULL + elapsed.tv_usec);
+	record[8] = event;
+	record[9] = phase;
+	h_u16_to_le(record + 10, 0);
+	h_u32_to_le(record + 12, arg);
+
+	if (fwrite(record, sizeof(record), 1, tracelog_file) != 1) {
+		/* don't try again for every record */
+		tracelog_enabled = false;
+		LOG_ERROR("failed to write trace log '%s', recording stopped", tracelog_filename);
+		return;
+	}
+
+	tracelog_records++;
+}
+
+static void tracelog_stop(void)
+{
+	if (tracelog_file == NULL)
+		return;
+
+	tracelog_enabled = false;
+	fclose(tracelog_file);
+	tracelog_file = NULL;
+
+	LOG_INFO("trace log '%s' closed, %" PRIu64 " records", tracelog_filename,
+			tracelog_records);
+	free(tracelog_filename);
+	tracelog_filename = NULL;
+}
+
+COMMAND_HANDLER(handle_tracelog_start_command)
+{
+	uint8_t header[TRACELOG_HEADER_SIZE];
+
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	tracelog_stop();
+
+	tracelog_file = fopen(CMD_ARGV[0], "wb");
+	if (tracelog_file == NULL) {
+		LOG_ERROR("failed to open trace log '%s'", CMD_ARGV[0]);
+		return ERROR_FAIL;
+	}
+	setvbuf(tracelog_file, NULL, _IOFBF, TRACELOG_BUFFER_SIZE);
+
+	memcpy(header, TRACELOG_MAGIC, 8);
+	h_u32_to_le(header + 8, TRACELOG_VERSION);
+	h_u32_to_le(header + 12, TRACELOG_RECORD_SIZE);
+	if (fwrite(header, sizeof(header), 1, tracelog_file) != 1) {
+		LOG_ERROR("failed to write trace log '%s'", CMD_ARGV[0]);
+		fclose(tracelog_file);
+		tracelog_file = NULL;
+		return ERROR_FAIL;
+	}
+
+	tracelog_filename = strdup(CMD_ARGV[0]);
+	tracelog_records = 0;
+	gettimeofday(&tracelog_start, NULL);
+	tracelog_enabled = true;
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_tracelog_stop_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	tracelog_stop();
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_tracelog_status_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (tracelog_file == NULL)
+		command_print(CMD_CTX, "not recording");
+	else
+		command_print(CMD_CTX, "recording to '%s'%s, %" PRIu64 " records",
+				tracelog_filename, tracelog_enabled ? "" : " (stopped by an error)",
+				tracelog_records);
+
+	return ERROR_OK;
+}
+
+static const struct command_registration tracelog_subcommand_handlers[] = {
+	{
+		.name = "start",
+		.handler = handle_tracelog_start_command,
+		.mode = COMMAND_ANY,
+		.help = "start recording debug link transactions to a file",
+		.usage = "filename",
+	},
+	{
+		.name = "stop",
+		.handler = handle_tracelog_stop_command,
+		.mode = COMMAND_ANY,
+		.help = "stop recording and close the file",
+		.usage = "",
+	},
+	{
+		.name = "status",
+		.handler = handle_tracelog_status_command,
+		.mode = COMMAND_ANY,
+		.help = "show whether a recording is in progress",
+		.usage = "",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration tracelog_command_handlers[] = {
+	{
+		.name = "tracelog",
+		.mode = COMMAND_ANY,
+		.help = "binary trace of debug link transactions",
+		.usage = "",
+		.chain = tracelog_subcommand_handlers,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+int tracelog_register_commands(struct command_context *cmd_ctx)
+{
+	return register_commands(cmd_ctx, NULL, tracelog_command_handlers);
+}
@@ -0,0 +1,75 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef OPENOCD_HELPER_TRACELOG_H
+#define OPENOCD_HELPER_TRACELOG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Binary recording of debug link round trips and of the target operations
+ * they are issued for. Every event is a fixed size record with a timestamp,
+ * so recording costs little more than a gettimeofday() call and a copy into
+ * the stdio buffer. contrib/tracelog-dump.c summarizes a recording.
+ *
+ * File format, all values little endian:
+ *	header:	"OCDTRACE", u32 version, u32 record size
+ *	record:	u64 microseconds since start, u8 event, u8 phase,
+ *		u16 reserved, u32 argument
+ * The argument of an end record is the result of the operation. The values
+ * below are part of the file format and must not be renumbered.
+ */
+
+#define TRACELOG_MAGIC		"OCDTRACE"
+#define TRACELOG_VERSION	1
+#define TRACELOG_HEADER_SIZE	16
+#define TRACELOG_RECORD_SIZE	16
+
+enum tracelog_event {
+	/* debug link round trips */
+	TRACELOG_JTAG_EXECUTE = 1,
+	TRACELOG_SWD_RUN = 2,
+	TRACELOG_DAP_RUN = 3,
+	/* target operations, the argument is the number of bytes or sectors */
+	TRACELOG_TARGET_HALT = 16,
+	TRACELOG_TARGET_RESUME = 17,
+	TRACELOG_TARGET_STEP = 18,
+	TRACELOG_TARGET_READ_MEMORY = 19,
+	TRACELOG_TARGET_WRITE_MEMORY = 20,
+	TRACELOG_FLASH_ERASE = 21,
+	TRACELOG_FLASH_WRITE = 22,
+};
+
+enum tracelog_phase {
+	TRACELOG_BEGIN = 0,
+	TRACELOG_END = 1,
+};
+
+struct command_context;
+
+extern bool tracelog_enabled;
+
+void tracelog_record(enum tracelog_event event, enum tracelog_phase phase, uint32_t arg);
+
+#define TRACELOG(event, phase, arg) \
+	do { \
+		if (tracelog_enabled) \
+			tracelog_record(event, phase, arg); \
+	} while (0)
+
+int tracelog_register_commands(struct command_context *cmd_ctx);
+
+#endif /* OPENOCD_HELPER_TRACELOG_H */
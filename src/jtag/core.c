@@ -35,6 +35,7 @@
 #include "interface.h"
 #include <transport/transport.h>
 #include <helper/jep106.h>
+#include <helper/tracelog.h>
 
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
@@ -842,7 +843,11 @@ int default_interface_jtag_execute_queue(void)
 void jtag_execute_queue_noclear(void)
 {
 	jtag_flush_queue_count++;
-	jtag_set_error(interface_jtag_execute_queue());
+
+	TRACELOG(TRACELOG_JTAG_EXECUTE, TRACELOG_BEGIN, 0);
+	int retval = interface_jtag_execute_queue();
+	TRACELOG(TRACELOG_JTAG_EXECUTE, TRACELOG_END, retval);
+	jtag_set_error(retval);
 
 	if (jtag_flush_queue_sleep > 0) {
 		/* For debug purposes it can be useful to test performance
@@ -0,0 +1,344 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <helper/log.h>
+#include <helper/binarybuffer.h>
+#include <jtag/swd.h>
+#include <target/arm_adi_v5.h>
+
+#include "dap_sim.h"
+#include "cmsis_dap_emu.h"
+
+/* the subset of commands the driver uses */
+#define DAP_INFO		0x00
+#define DAP_LED			0x01
+#define DAP_CONNECT		0x02
+#define DAP_DISCONNECT		0x03
+#define DAP_TFER_CONFIGURE	0x04
+#define DAP_TFER		0x05
+#define DAP_TFER_BLOCK		0x06
+#define DAP_WRITE_ABORT		0x08
+#define DAP_DELAY		0x09
+#define DAP_RESET_TARGET	0x0A
+#define DAP_SWJ_PINS		0x10
+#define DAP_SWJ_CLOCK		0x11
+#define DAP_SWJ_SEQ		0x12
+#define DAP_SWD_CONFIGURE	0x13
+
+#define DAP_OK			0x00
+#define DAP_ERROR		0xFF
+
+/* transfer request bits */
+#define TFER_APnDP		(1 << 0)
+#define TFER_RnW		(1 << 1)
+#define TFER_A32		(3 << 2)
+
+#define EMU_RAM_BASE		0x20000000
+#define EMU_RAM_SIZE		(64 * 1024)
+
+struct cmsis_dap_emu {
+	uint16_t packet_size;
+	uint8_t packet_count;
+
+	/* replies waiting to be read, oldest first */
+	uint8_t *replies;
+	unsigned int reply_head;
+	unsigned int in_flight;
+
+	/* target side */
+	struct dap_sim *dap;
+
+	struct cmsis_dap_emu_stats stats;
+};
+
+struct cmsis_dap_emu *cmsis_dap_emu_open(uint16_t packet_size, uint8_t packet_count)
+{
+	struct cmsis_dap_emu *emu = calloc(1, sizeof(*emu));
+
+	if (emu == NULL)
+		return NULL;
+
+	emu->packet_size = packet_size;
+	emu->packet_count = packet_count ? packet_count : 1;
+	emu->replies = calloc(emu->packet_count, packet_size);
+	emu->dap = dap_sim_new();
+
+	if (emu->replies == NULL || emu->dap == NULL
+			|| dap_sim_add_region(emu->dap, EMU_RAM_BASE, EMU_RAM_SIZE, false) != ERROR_OK) {
+		cmsis_dap_emu_close(emu);
+		return NULL;
+	}
+
+	return emu;
+}
+
+void cmsis_dap_emu_close(struct cmsis_dap_emu *emu)
+{
+	if (emu == NULL)
+		return;
+
+	free(emu->replies);
+	dap_sim_free(emu->dap);
+	free(emu);
+}
+
+void cmsis_dap_emu_get_stats(struct cmsis_dap_emu *emu, struct cmsis_dap_emu_stats *stats)
+{
+	*stats = emu->stats;
+}
+
+/* one SWD transfer as the probe would run it, with AP reads un-posted */
+static int emu_transfer(struct cmsis_dap_emu *emu, uint8_t request, uint32_t *value)
+{
+	bool read = request & TFER_RnW;
+	bool ap = request & TFER_APnDP;
+	int ack;
+
+	emu->stats.transfers++;
+
+	ack = dap_sim_transaction(emu->dap, swd_cmd(read, ap, request & TFER_A32), value);
+	if (ack == SWD_ACK_OK && read && ap)
+		ack = dap_sim_transaction(emu->dap, swd_cmd(true, false, DP_RDBUFF), value);
+
+	return ack;
+}
+
+/* Stop a transfer command that runs out of request data or reply space.
+ * A host which builds such a command has a bug; a probe would answer
+ * with the number of transfers done so far, so report WAIT for the rest. */
+static int emu_transfer_overrun(const char *what, unsigned int done)
+{
+	LOG_ERROR("cmsis-dap emulator: %s after %u transfers", what, done);
+	return SWD_ACK_WAIT;
+}
+
+/* DAP_Transfer: request count, then request bytes each followed by write data */
+static size_t emu_cmd_transfer(struct cmsis_dap_emu *emu, const uint8_t *req, size_t req_len,
+		uint8_t *reply)
+{
+	unsigned int count = req_len > 2 ? req[2] : 0;
+	size_t in = 3, out = 3;
+	unsigned int done = 0;
+	int ack = SWD_ACK_OK;
+
+	emu->stats.transfer_packets++;
+
+	for (; done < count; done++) {
+		if (in >= req_len) {
+			ack = emu_transfer_overrun("request truncated", done);
+			break;
+		}
+
+		uint8_t request = req[in++];
+		uint32_t value = 0;
+
+		if (!(request & TFER_RnW)) {
+			if (in + 4 > req_len) {
+				ack = emu_transfer_overrun("request truncated", done);
+				break;
+			}
+			value = le_to_h_u32(req + in);
+			in += 4;
+		} else if (out + 4 > emu->packet_size) {
+			ack = emu_transfer_overrun("reply full", done);
+			break;
+		}
+
+		ack = emu_transfer(emu, request, &value);
+		if (ack != SWD_ACK_OK)
+			break;
+
+		if (request & TFER_RnW) {
+			h_u32_to_le(reply + out, value);
+			out += 4;
+		}
+	}
+
+	reply[1] = done;
+	reply[2] = ack;
+	return out;
+}
+
+/* DAP_TransferBlock: one request byte repeated for a 16 bit count */
+static size_t emu_cmd_transfer_block(struct cmsis_dap_emu *emu, const uint8_t *req, size_t req_len,
+		uint8_t *reply)
+{
+	size_t in = 5, out = 4;
+	unsigned int done = 0;
+	int ack = SWD_ACK_OK;
+
+	emu->stats.block_packets++;
+
+	if (req_len < in) {
+		reply[3] = emu_transfer_overrun("request truncated", 0);
+		return out;
+	}
+
+	unsigned int count = le_to_h_u16(req + 2);
+	uint8_t request = req[4];
+
+	for (; done < count; done++) {
+		uint32_t value = 0;
+
+		if (!(request & TFER_RnW)) {
+			if (in + 4 > req_len) {
+				ack = emu_transfer_overrun("request truncated", done);
+				break;
+			}
+			value = le_to_h_u32(req + in);
+			in += 4;
+		} else if (out + 4 > emu->packet_size) {
+			ack = emu_transfer_overrun("reply full", done);
+			break;
+		}
+
+		ack = emu_transfer(emu, request, &value);
+		if (ack != SWD_ACK_OK)
+			break;
+
+		if (request & TFER_RnW) {
+			h_u32_to_le(reply + out, value);
+			out += 4;
+		}
+	}
+
+	h_u16_to_le(reply + 1, done);
+	reply[3] = ack;
+	return out;
+}
+
+static size_t emu_cmd_info(struct cmsis_dap_emu *emu, uint8_t id, uint8_t *reply)
+{
+	static const char fw_version[] = "1.10-emulator";
+
+	switch (id) {
+	case 0x04:	/* firmware version */
+		reply[1] = sizeof(fw_version);
+		memcpy(reply + 2, fw_version, sizeof(fw_version));
+		return 2 + sizeof(fw_version);
+	case 0xf0:	/* capabilities: SWD only */
+		reply[1] = 1;
+		reply[2] = 0x01;
+		return 3;
+	case 0xfe:	/* packet count */
+		reply[1] = 1;
+		reply[2] = emu->packet_count;
+		return 3;
+	case 0xff:	/* packet size */
+		reply[1] = 2;
+		h_u16_to_le(reply + 2, emu->packet_size);
+		return 4;
+	default:
+		reply[1] = 0;
+		return 2;
+	}
+}
+
+int cmsis_dap_emu_write(struct cmsis_dap_emu *emu, const uint8_t *data, size_t length)
+{
+	/* skip the report number */
+	const uint8_t *req = data + 1;
+	size_t req_len = length - 1;
+
+	if (length < 2)
+		return -1;
+
+	if (emu->in_flight == emu->packet_count) {
+		LOG_ERROR("cmsis-dap emulator: more than %u packets in flight",
+				emu->packet_count);
+		return -1;
+	}
+
+	if (req_len > emu->packet_size)
+		req_len = emu->packet_size;
+
+	unsigned int slot = (emu->reply_head + emu->in_flight) % emu->packet_count;
+	uint8_t *reply = emu->replies + slot * emu->packet_size;
+
+	memset(reply, 0, emu->packet_size);
+	reply[0] = req[0];
+
+	emu->stats.packets++;
+
+	switch (req[0]) {
+	case DAP_INFO:
+		emu_cmd_info(emu, req[1], reply);
+		break;
+	case DAP_CONNECT:
+		/* only SWD, which is also the default port */
+		reply[1] = (req[1] == 0 || req[1] == 1) ? 1 : 0;
+		break;
+	case DAP_SWJ_PINS:
+		/* nRESET and nTRST released */
+		reply[1] = 0xa0;
+		break;
+	case DAP_SWJ_SEQ:
+		dap_sim_line_reset(emu->dap);
+		reply[1] = DAP_OK;
+		break;
+	case DAP_WRITE_ABORT: {
+		uint32_t abort = le_to_h_u32(req + 2);
+		dap_sim_transaction(emu->dap, swd_cmd(false, false, DP_ABORT), &abort);
+		reply[1] = DAP_OK;
+		break;
+	}
+	case DAP_RESET_TARGET:
+		dap_sim_reset(emu->dap);
+		reply[1] = DAP_OK;
+		break;
+	case DAP_LED:
+	case DAP_DISCONNECT:
+	case DAP_TFER_CONFIGURE:
+	case DAP_DELAY:
+	case DAP_SWJ_CLOCK:
+	case DAP_SWD_CONFIGURE:
+		reply[1] = DAP_OK;
+		break;
+	case DAP_TFER:
+		emu_cmd_transfer(emu, req, req_len, reply);
+		break;
+	case DAP_TFER_BLOCK:
+		emu_cmd_transfer_block(emu, req, req_len, reply);
+		break;
+	default:
+		reply[0] = DAP_ERROR;
+		break;
+	}
+
+	emu->in_flight++;
+	if (emu->in_flight > emu->stats.max_in_flight)
+		emu->stats.max_in_flight = emu->in_flight;
+
+	return length;
+}
+
+int cmsis_dap_emu_read(struct cmsis_dap_emu *emu, uint8_t *data, size_t length)
+{
+	if (emu->in_flight == 0)
+		return 0;
+
+	if (length > emu->packet_size)
+		length = emu->packet_size;
+
+	memcpy(data, emu->replies + emu->reply_head * emu->packet_size, length);
+	emu->reply_head = (emu->reply_head + 1) % emu->packet_count;
+	emu->in_flight--;
+
+	return length;
+}
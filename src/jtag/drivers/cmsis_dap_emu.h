@@ -0,0 +1,59 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef OPENOCD_JTAG_DRIVERS_CMSIS_DAP_EMU_H
+#define OPENOCD_JTAG_DRIVERS_CMSIS_DAP_EMU_H
+
+/*
+ * Software CMSIS-DAP probe at the HID report level, with the DAP model of
+ * dap_sim.c and a block of RAM behind it. The calls mirror hid_write() and
+ * hid_read_timeout(), so the driver's packet handling, including several
+ * packets in flight, can be tested without a probe.
+ */
+
+struct cmsis_dap_emu;
+
+struct cmsis_dap_emu_stats {
+	/** Command packets received. */
+	uint64_t packets;
+	/** DAP_Transfer and DAP_TransferBlock packets among them. */
+	uint64_t transfer_packets;
+	uint64_t block_packets;
+	/** SWD transfers carried by those packets. */
+	uint64_t transfers;
+	/** Largest number of packets that were waiting for their reply. */
+	unsigned int max_in_flight;
+};
+
+struct cmsis_dap_emu *cmsis_dap_emu_open(uint16_t packet_size, uint8_t packet_count);
+void cmsis_dap_emu_close(struct cmsis_dap_emu *emu);
+
+/**
+ * Hand a report to the emulated probe. Like hid_write(), @a data starts
+ * with the report number.
+ * @returns the number of bytes written, or -1 if too many packets are
+ *	already waiting for their reply.
+ */
+int cmsis_dap_emu_write(struct cmsis_dap_emu *emu, const uint8_t *data, size_t length);
+
+/**
+ * Fetch the reply to the oldest outstanding packet.
+ * @returns the number of bytes read, or 0 if no reply is pending.
+ */
+int cmsis_dap_emu_read(struct cmsis_dap_emu *emu, uint8_t *data, size_t length);
+
+void cmsis_dap_emu_get_stats(struct cmsis_dap_emu *emu, struct cmsis_dap_emu_stats *stats);
+
+#endif /* OPENOCD_JTAG_DRIVERS_CMSIS_DAP_EMU_H */
@@ -40,6 +40,10 @@
 
 #include <hidapi.h>
 
+#if BUILD_SWDSIM
+#include "cmsis_dap_emu.h"
+#endif
+
 /*
  * See CMSIS-DAP documentation:
  * Version 0.01 - Beta.
@@ -165,10 +169,16 @@ static const char * const info_caps_str[] = {
 
 struct cmsis_dap {
 	hid_device *dev_handle;
+#if BUILD_SWDSIM
+	/** software probe used instead of dev_handle, see cmsis_dap_emulator */
+	struct cmsis_dap_emu *emu;
+#endif
 	uint16_t packet_size;
 	uint16_t packet_count;
 	uint8_t *packet_buffer;
 	uint8_t caps;
+	/** last AP or RDBUFF read, returned for the next one like a posted read */
+	uint32_t last_read;
 	uint8_t mode;
 };
 
@@ -192,6 +202,29 @@ struct pending_scan_result {
 static int pending_transfer_count, pending_queue_len;
 static struct pending_transfer_result *pending_transfers;
 
+/* A DAP_Transfer or DAP_TransferBlock packet sent to the probe whose
+ * reply has not been read yet. */
+struct pending_request {
+	/** Index of the first transfer in pending_transfers. */
+	int first;
+	/** Number of transfers in the packet. */
+	int count;
+	bool block;
+};
+
+/* ring of up to packet_count requests in flight */
+static struct pending_request *pending_requests;
+
+/* A run of at least this many accesses to the same AP register
+ * is sent as DAP_TransferBlock. */
+#define TFER_BLOCK_MIN_RUN 4
+
+#if BUILD_SWDSIM
+/* emulated probe configuration, packet_count == 0 when not in use */
+static uint16_t cmsis_dap_emu_packet_size = 64;
+static uint8_t cmsis_dap_emu_packet_count;
+#endif
+
 /* pointers to buffers that will receive jtag scan results on the next flush */
 #define MAX_PENDING_SCAN_RESULTS 256
 static int pending_scan_result_count;
@@ -210,6 +243,33 @@ static uint8_t output_pins = SWJ_PIN_SRST | SWJ_PIN_TRST;
 
 static struct cmsis_dap *cmsis_dap_handle;
 
+#if BUILD_SWDSIM
+static int cmsis_dap_emu_usb_open(void)
+{
+	struct cmsis_dap *dap = calloc(1, sizeof(struct cmsis_dap));
+	if (dap == NULL) {
+		LOG_ERROR("unable to allocate memory");
+		return ERROR_FAIL;
+	}
+
+	dap->emu = cmsis_dap_emu_open(cmsis_dap_emu_packet_size, cmsis_dap_emu_packet_count);
+	dap->packet_size = PACKET_SIZE;
+	dap->packet_buffer = malloc(dap->packet_size);
+
+	if (dap->emu == NULL || dap->packet_buffer == NULL) {
+		LOG_ERROR("unable to allocate memory");
+		cmsis_dap_emu_close(dap->emu);
+		free(dap->packet_buffer);
+		free(dap);
+		return ERROR_FAIL;
+	}
+
+	cmsis_dap_handle = dap;
+	LOG_INFO("CMSIS-DAP: using emulated probe");
+	return ERROR_OK;
+}
+#endif
+
 static int cmsis_dap_usb_open(void)
 {
 	hid_device *dev = NULL;
@@ -221,6 +281,11 @@ static int cmsis_dap_usb_open(void)
 	bool found = false;
 	bool serial_found = false;
 
+#if BUILD_SWDSIM
+	if (cmsis_dap_emu_packet_count)
+		return cmsis_dap_emu_usb_open();
+#endif
+
 	target_vid = 0;
 	target_pid = 0;
 
@@ -338,8 +403,15 @@ static int cmsis_dap_usb_open(void)
 
 static void cmsis_dap_usb_close(struct cmsis_dap *dap)
 {
-	hid_close(dap->dev_handle);
-	hid_exit();
+#if BUILD_SWDSIM
+	if (dap->emu) {
+		cmsis_dap_emu_close(dap->emu);
+	} else
+#endif
+	{
+		hid_close(dap->dev_handle);
+		hid_exit();
+	}
 
 	free(cmsis_dap_handle->packet_buffer);
 	free(cmsis_dap_handle);
@@ -348,27 +420,48 @@ static void cmsis_dap_usb_close(struct cmsis_dap *dap)
 	cmsis_dap_serial = NULL;
 	free(pending_transfers);
 	pending_transfers = NULL;
+	free(pending_requests);
+	pending_requests = NULL;
 
 	return;
 }
 
-/* Send a message and receive the reply */
-static int cmsis_dap_usb_xfer(struct cmsis_dap *dap, int txlen)
+/* Send a packet without waiting for the reply */
+static int cmsis_dap_usb_write(struct cmsis_dap *dap, int txlen)
 {
-#ifdef CMSIS_DAP_JTAG_DEBUG
-	LOG_DEBUG("cmsis-dap usb xfer cmd=%02X", dap->packet_buffer[1]);
-#endif
+	int retval;
+
 	/* Pad the rest of the TX buffer with 0's */
 	memset(dap->packet_buffer + txlen, 0, dap->packet_size - txlen);
 
-	/* write data to device */
-	int retval = hid_write(dap->dev_handle, dap->packet_buffer, dap->packet_size);
+#if BUILD_SWDSIM
+	if (dap->emu) {
+		retval = cmsis_dap_emu_write(dap->emu, dap->packet_buffer, dap->packet_size);
+		return retval == -1 ? ERROR_FAIL : ERROR_OK;
+	}
+#endif
+
+	retval = hid_write(dap->dev_handle, dap->packet_buffer, dap->packet_size);
 	if (retval == -1) {
 		LOG_ERROR("error writing data: %ls", hid_error(dap->dev_handle));
 		return ERROR_FAIL;
 	}
 
-	/* get reply */
+	return ERROR_OK;
+}
+
+/* Receive the reply to the oldest packet sent */
+static int cmsis_dap_usb_read(struct cmsis_dap *dap)
+{
+	int retval;
+
+#if BUILD_SWDSIM
+	if (dap->emu) {
+		retval = cmsis_dap_emu_read(dap->emu, dap->packet_buffer, dap->packet_size);
+		return retval == 0 ? ERROR_FAIL : ERROR_OK;
+	}
+#endif
+
 	retval = hid_read_timeout(dap->dev_handle, dap->packet_buffer, dap->packet_size, USB_TIMEOUT);
 	if (retval == -1 || retval == 0) {
 		LOG_DEBUG("error reading data: %ls", hid_error(dap->dev_handle));
@@ -378,6 +471,19 @@ static int cmsis_dap_usb_xfer(struct cmsis_dap *dap, int txlen)
 	return ERROR_OK;
 }
 
+/* Send a message and receive the reply */
+static int cmsis_dap_usb_xfer(struct cmsis_dap *dap, int txlen)
+{
+#ifdef CMSIS_DAP_JTAG_DEBUG
+	LOG_DEBUG("cmsis-dap usb xfer cmd=%02X", dap->packet_buffer[1]);
+#endif
+	int retval = cmsis_dap_usb_write(dap, txlen);
+	if (retval != ERROR_OK)
+		return retval;
+
+	return cmsis_dap_usb_read(dap);
+}
+
 static int cmsis_dap_cmd_DAP_SWJ_Pins(uint8_t pins, uint8_t mask, uint32_t delay, uint8_t *input)
 {
 	int retval;
@@ -594,29 +700,92 @@ static int cmsis_dap_cmd_DAP_Delay(uint16_t delay_us)
 }
 #endif
 
-static int cmsis_dap_swd_run_queue(void)
+/* Length of the run of identical AP accesses starting at transfer first */
+static int cmsis_dap_swd_ap_run_length(int first)
+{
+	uint8_t cmd = pending_transfers[first].cmd;
+	int i;
+
+	if (!(cmd & SWD_CMD_APnDP))
+		return 0;
+
+	for (i = first; i < pending_transfer_count && pending_transfers[i].cmd == cmd; i++)
+		;
+
+	return i - first;
+}
+
+/* Build a DAP_TransferBlock packet for up to count identical AP accesses */
+static int cmsis_dap_swd_build_block(int first, int count, struct pending_request *req)
 {
 	uint8_t *buffer = cmsis_dap_handle->packet_buffer;
+	int pkt_sz = cmsis_dap_handle->packet_size - 1;
+	uint8_t cmd = pending_transfers[first].cmd;
+	int max;
 
-	LOG_DEBUG_IO("Executing %d queued transactions", pending_transfer_count);
+	/* request: command, index, count, request byte; reply: command, count, ack */
+	if (cmd & SWD_CMD_RnW)
+		max = (pkt_sz - 4) / 4;
+	else
+		max = (pkt_sz - 5) / 4;
+	if (count > max)
+		count = max;
 
-	if (queued_retval != ERROR_OK) {
-		LOG_DEBUG("Skipping due to previous errors: %d", queued_retval);
-		goto skip;
+	size_t idx = 0;
+	buffer[idx++] = 0;	/* report number */
+	buffer[idx++] = CMD_DAP_TFER_BLOCK;
+	buffer[idx++] = 0x00;	/* DAP Index */
+	h_u16_to_le(&buffer[idx], count);
+	idx += 2;
+	buffer[idx++] = (cmd >> 1) & 0x0f;
+
+	for (int i = first; i < first + count; i++) {
+		LOG_DEBUG_IO("AP %s reg %x %"PRIx32 " (block)",
+				cmd & SWD_CMD_RnW ? "read" : "write",
+				(cmd & SWD_CMD_A32) >> 1, pending_transfers[i].data);
+
+		if (!(cmd & SWD_CMD_RnW)) {
+			h_u32_to_le(&buffer[idx], pending_transfers[i].data);
+			idx += 4;
+		}
 	}
 
-	if (!pending_transfer_count)
-		goto skip;
+	req->first = first;
+	req->count = count;
+	req->block = true;
+	return idx;
+}
+
+/* Build a DAP_Transfer packet with as many transfers from first on as fit */
+static int cmsis_dap_swd_build_transfer(int first, struct pending_request *req)
+{
+	uint8_t *buffer = cmsis_dap_handle->packet_buffer;
+	int pkt_sz = cmsis_dap_handle->packet_size - 1;
+	/* command, index and count in the request; command, count and ack in the reply */
+	int req_len = 3, reply_len = 3;
+	int i;
 
 	size_t idx = 0;
 	buffer[idx++] = 0;	/* report number */
 	buffer[idx++] = CMD_DAP_TFER;
 	buffer[idx++] = 0x00;	/* DAP Index */
-	buffer[idx++] = pending_transfer_count;
+	buffer[idx++] = 0;	/* count, filled in below */
 
-	for (int i = 0; i < pending_transfer_count; i++) {
+	for (i = first; i < pending_transfer_count && i - first < 255; i++) {
 		uint8_t cmd = pending_transfers[i].cmd;
 		uint32_t data = pending_transfers[i].data;
+		int req_size = (cmd & SWD_CMD_RnW) ? 1 : 5;
+		int reply_size = (cmd & SWD_CMD_RnW) ? 4 : 0;
+
+		if (req_len + req_size > pkt_sz || reply_len + reply_size > pkt_sz)
+			break;
+
+		/* leave a long enough run to its own DAP_TransferBlock */
+		if (i > first && cmsis_dap_swd_ap_run_length(i) >= TFER_BLOCK_MIN_RUN)
+			break;
+
+		req_len += req_size;
+		reply_len += reply_size;
 
 		LOG_DEBUG_IO("%s %s reg %x %"PRIx32,
 				cmd & SWD_CMD_APnDP ? "AP" : "DP",
@@ -651,27 +820,45 @@ static int cmsis_dap_swd_run_queue(void)
 		}
 	}
 
-	queued_retval = cmsis_dap_usb_xfer(cmsis_dap_handle, idx);
-	if (queued_retval != ERROR_OK)
-		goto skip;
+	buffer[3] = i - first;
 
-	idx = 2;
-	uint8_t ack = buffer[idx] & 0x07;
-	if (ack != SWD_ACK_OK || (buffer[idx] & 0x08)) {
-		LOG_DEBUG("SWD ack not OK: %d %s", buffer[idx-1],
-			  ack == SWD_ACK_WAIT ? "WAIT" : ack == SWD_ACK_FAULT ? "FAULT" : "JUNK");
-		queued_retval = ack == SWD_ACK_WAIT ? ERROR_WAIT : ERROR_FAIL;
-		goto skip;
+	req->first = first;
+	req->count = i - first;
+	req->block = false;
+	return idx;
+}
+
+/* Check the reply to a request in packet_buffer and store read results */
+static int cmsis_dap_swd_read_reply(struct pending_request *req)
+{
+	uint8_t *buffer = cmsis_dap_handle->packet_buffer;
+	int count, idx;
+	uint8_t ack;
+
+	if (req->block) {
+		count = le_to_h_u16(&buffer[1]);
+		ack = buffer[3];
+		idx = 4;
+	} else {
+		count = buffer[1];
+		ack = buffer[2];
+		idx = 3;
+	}
+
+	if ((ack & 0x07) != SWD_ACK_OK || (ack & 0x08)) {
+		LOG_DEBUG("SWD ack not OK: %d %s", count,
+			  (ack & 0x07) == SWD_ACK_WAIT ? "WAIT" : (ack & 0x07) == SWD_ACK_FAULT ? "FAULT" : "JUNK");
+		return (ack & 0x07) == SWD_ACK_WAIT ? ERROR_WAIT : ERROR_FAIL;
 	}
-	idx++;
 
-	if (pending_transfer_count != buffer[1])
+	if (req->count != count) {
 		LOG_ERROR("CMSIS-DAP transfer count mismatch: expected %d, got %d",
-			  pending_transfer_count, buffer[1]);
+			  req->count, count);
+		return ERROR_FAIL;
+	}
 
-	for (int i = 0; i < buffer[1]; i++) {
+	for (int i = req->first; i < req->first + count; i++) {
 		if (pending_transfers[i].cmd & SWD_CMD_RnW) {
-			static uint32_t last_read;
 			uint32_t data = le_to_h_u32(&buffer[idx]);
 			uint32_t tmp = data;
 			idx += 4;
@@ -681,8 +868,8 @@ static int cmsis_dap_swd_run_queue(void)
 			/* Imitate posted AP reads */
 			if ((pending_transfers[i].cmd & SWD_CMD_APnDP) ||
 			    ((pending_transfers[i].cmd & SWD_CMD_A32) >> 1 == DP_RDBUFF)) {
-				tmp = last_read;
-				last_read = data;
+				tmp = cmsis_dap_handle->last_read;
+				cmsis_dap_handle->last_read = data;
 			}
 
 			if (pending_transfers[i].buffer)
@@ -690,6 +877,64 @@ static int cmsis_dap_swd_run_queue(void)
 		}
 	}
 
+	return ERROR_OK;
+}
+
+/*
+ * The queue is cut into DAP_Transfer and DAP_TransferBlock packets and up
+ * to packet_count of them are kept in flight, so the probe can work on the
+ * next packet while the reply to the previous one travels back. Replies
+ * come back in order. After an error no further packets are sent, but the
+ * replies to those already sent are still collected.
+ */
+static int cmsis_dap_swd_run_queue(void)
+{
+	int packet_count = MAX(cmsis_dap_handle->packet_count, 1);
+	int next = 0, sent = 0, received = 0;
+
+	LOG_DEBUG_IO("Executing %d queued transactions", pending_transfer_count);
+
+	if (queued_retval != ERROR_OK) {
+		LOG_DEBUG("Skipping due to previous errors: %d", queued_retval);
+		goto skip;
+	}
+
+	while (received < sent || next < pending_transfer_count) {
+		/* fill the window */
+		while (next < pending_transfer_count && sent - received < packet_count
+				&& queued_retval == ERROR_OK) {
+			struct pending_request *req = &pending_requests[sent % packet_count];
+			int run = cmsis_dap_swd_ap_run_length(next);
+			int len;
+
+			if (run >= TFER_BLOCK_MIN_RUN)
+				len = cmsis_dap_swd_build_block(next, run, req);
+			else
+				len = cmsis_dap_swd_build_transfer(next, req);
+
+			queued_retval = cmsis_dap_usb_write(cmsis_dap_handle, len);
+			if (queued_retval != ERROR_OK)
+				break;
+
+			next += req->count;
+			sent++;
+		}
+
+		if (received == sent)
+			break;
+
+		/* collect the oldest reply */
+		int retval = cmsis_dap_usb_read(cmsis_dap_handle);
+		if (retval == ERROR_OK)
+			retval = cmsis_dap_swd_read_reply(&pending_requests[received % packet_count]);
+		received++;
+
+		if (retval != ERROR_OK && queued_retval == ERROR_OK)
+			queued_retval = retval;
+		if (queued_retval != ERROR_OK)
+			next = pending_transfer_count;
+	}
+
 skip:
 	pending_transfer_count = 0;
 	int retval = queued_retval;
@@ -729,6 +974,11 @@ static void cmsis_dap_swd_read_reg(uint8_t cmd, uint32_t *value, uint32_t ap_del
 	cmsis_dap_swd_queue_cmd(cmd, value, 0);
 }
 
+static unsigned int cmsis_dap_swd_queue_size(void)
+{
+	return pending_queue_len;
+}
+
 static int cmsis_dap_get_version_info(void)
 {
 	uint8_t *data;
@@ -915,16 +1165,6 @@ static int cmsis_dap_init(void)
 	if (data[0] == 2) {  /* short */
 		uint16_t pkt_sz = data[1] + (data[2] << 8);
 
-		/* 4 bytes of command header + 5 bytes per register
-		 * write. For bulk read sequences just 4 bytes are
-		 * needed per transfer, so this is suboptimal. */
-		pending_queue_len = (pkt_sz - 4) / 5;
-		pending_transfers = malloc(pending_queue_len * sizeof(*pending_transfers));
-		if (!pending_transfers) {
-			LOG_ERROR("Unable to allocate memory for CMSIS-DAP queue");
-			return ERROR_FAIL;
-		}
-
 		if (cmsis_dap_handle->packet_size != pkt_sz + 1) {
 			/* reallocate buffer */
 			cmsis_dap_handle->packet_size = pkt_sz + 1;
@@ -950,6 +1190,20 @@ static int cmsis_dap_init(void)
 		LOG_DEBUG("CMSIS-DAP: Packet Count = %" PRId16, pkt_cnt);
 	}
 
+	if (cmsis_dap_handle->packet_count == 0)
+		cmsis_dap_handle->packet_count = 1;
+
+	/* The queue holds enough for every packet in flight to be full of
+	 * register writes: 4 bytes of command header + 5 bytes each. */
+	pending_queue_len = cmsis_dap_handle->packet_count
+		* ((cmsis_dap_handle->packet_size - 1 - 4) / 5);
+	pending_transfers = malloc(pending_queue_len * sizeof(*pending_transfers));
+	pending_requests = malloc(cmsis_dap_handle->packet_count * sizeof(*pending_requests));
+	if (!pending_transfers || !pending_requests) {
+		LOG_ERROR("Unable to allocate memory for CMSIS-DAP queue");
+		return ERROR_FAIL;
+	}
+
 	retval = cmsis_dap_get_status();
 	if (retval != ERROR_OK)
 		return ERROR_FAIL;
@@ -1547,9 +1801,42 @@ COMMAND_HANDLER(cmsis_dap_handle_info_command)
 	if (cmsis_dap_get_version_info() == ERROR_OK)
 		cmsis_dap_get_status();
 
+#if BUILD_SWDSIM
+	if (cmsis_dap_handle && cmsis_dap_handle->emu) {
+		struct cmsis_dap_emu_stats stats;
+		cmsis_dap_emu_get_stats(cmsis_dap_handle->emu, &stats);
+		command_print(CMD_CTX, "emulator: %" PRIu64 " packets, %" PRIu64 " DAP_Transfer, %"
+				PRIu64 " DAP_TransferBlock, %" PRIu64 " transfers, up to %u in flight",
+				stats.packets, stats.transfer_packets, stats.block_packets,
+				stats.transfers, stats.max_in_flight);
+	}
+#endif
+
 	return ERROR_OK;
 }
 
+#if BUILD_SWDSIM
+COMMAND_HANDLER(cmsis_dap_handle_emulator_command)
+{
+	if (CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	cmsis_dap_emu_packet_count = 4;
+	if (CMD_ARGC > 0)
+		COMMAND_PARSE_NUMBER(u16, CMD_ARGV[0], cmsis_dap_emu_packet_size);
+	if (CMD_ARGC > 1)
+		COMMAND_PARSE_NUMBER(u8, CMD_ARGV[1], cmsis_dap_emu_packet_count);
+
+	if (cmsis_dap_emu_packet_size < 64 || cmsis_dap_emu_packet_count == 0) {
+		cmsis_dap_emu_packet_count = 0;
+		LOG_ERROR("packet size must be at least 64 and packet count at least 1");
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+
+	return ERROR_OK;
+}
+#endif
+
 COMMAND_HANDLER(cmsis_dap_handle_vid_pid_command)
 {
 	if (CMD_ARGC > MAX_USB_IDS * 2) {
@@ -1634,6 +1921,16 @@ static const struct command_registration cmsis_dap_command_handlers[] = {
 		.help = "set the serial number of the adapter",
 		.usage = "serial_string",
 	},
+#if BUILD_SWDSIM
+	{
+		.name = "cmsis_dap_emulator",
+		.handler = &cmsis_dap_handle_emulator_command,
+		.mode = COMMAND_CONFIG,
+		.help = "use a software CMSIS-DAP probe with RAM at 0x20000000 "
+			"instead of a USB device, for testing",
+		.usage = "[packet_size [packet_count]]",
+	},
+#endif
 	COMMAND_REGISTRATION_DONE
 };
 
@@ -1644,6 +1941,7 @@ static const struct swd_driver cmsis_dap_swd_driver = {
 	.read_reg = cmsis_dap_swd_read_reg,
 	.write_reg = cmsis_dap_swd_write_reg,
 	.run = cmsis_dap_swd_run_queue,
+	.queue_size = cmsis_dap_swd_queue_size,
 };
 
 static const char * const cmsis_dap_transport[] = { "swd", "jtag", NULL };
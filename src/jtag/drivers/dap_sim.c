@@ -0,0 +1,522 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+
+/*
+ * ADIv5 SW-DP, AHB-AP and Cortex-M debug register model behind the
+ * simulated adapters, see dap_sim.h. The core itself does not execute
+ * instructions; halting, stepping, resuming and core register access work
+ * through DHCSR, DCRSR, DCRDR, DEMCR, DFSR and AIRCR, and the FPB and DWT
+ * report their comparators.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <helper/log.h>
+#include <helper/binarybuffer.h>
+#include <jtag/swd.h>
+#include <target/arm_adi_v5.h>
+#include <target/cortex_m.h>
+
+#include "dap_sim.h"
+
+/* SW-DP, designer ARM, version 1 */
+#define SIM_DPIDR		0x2BA01477
+/* AHB-AP, as found on Cortex-M3/M4 */
+#define SIM_AP_IDR		0x24770011
+#define SIM_AP_BASE		0xE00FF003
+/* Cortex-M3 r2p1 */
+#define SIM_CPUID		0x412FC231
+
+#define SIM_PPB_BASE		0xE0000000
+#define SIM_PPB_SIZE		0x00100000
+
+#define SIM_CPUID_ADDR		0xE000ED00
+#define SIM_AIRCR		0xE000ED0C
+#define SIM_DFSR		0xE000ED30
+#define SIM_DHCSR		0xE000EDF0
+#define SIM_DCRSR		0xE000EDF4
+#define SIM_DCRDR		0xE000EDF8
+#define SIM_DEMCR		0xE000EDFC
+#define SIM_DWT_CTRL		0xE0001000
+#define SIM_FP_CTRL		0xE0002000
+
+#define SIM_FPB_NUM_CODE	6
+#define SIM_FPB_NUM_LIT		2
+#define SIM_DWT_NUMCOMP		4
+
+#define SIM_NUM_CORE_REGS	128
+#define SIM_MAX_REGIONS		8
+
+struct sim_region {
+	uint32_t base;
+	uint32_t size;
+	bool read_only;
+	uint8_t *data;
+};
+
+struct dap_sim {
+	/* memory map */
+	struct sim_region regions[SIM_MAX_REGIONS];
+	unsigned int num_regions;
+	uint8_t *ppb;
+
+	/* debug port */
+	uint32_t ctrl_stat;
+	uint32_t select;
+	uint32_t rdbuff;
+
+	/* MEM-AP */
+	uint32_t csw;
+	uint32_t tar;
+
+	/* core */
+	uint32_t regs[SIM_NUM_CORE_REGS];
+	uint32_t dhcsr_ctrl;
+	uint32_t dcrdr;
+	bool halted;
+	bool reset_seen;
+
+	struct dap_sim_stats stats;
+};
+
+/* bus accesses */
+
+static uint8_t *sim_bus_ptr(struct dap_sim *sim, uint32_t addr, unsigned int size, bool write)
+{
+	if (addr >= SIM_PPB_BASE && addr - SIM_PPB_BASE <= SIM_PPB_SIZE - size)
+		return sim->ppb + (addr - SIM_PPB_BASE);
+
+	for (unsigned int i = 0; i < sim->num_regions; i++) {
+		struct sim_region *r = &sim->regions[i];
+		if (addr >= r->base && size <= r->size && addr - r->base <= r->size - size) {
+			if (write && r->read_only)
+				return NULL;
+			return r->data + (addr - r->base);
+		}
+	}
+
+	return NULL;
+}
+
+static uint32_t sim_ppb_get(struct dap_sim *sim, uint32_t addr)
+{
+	return le_to_h_u32(sim->ppb + (addr - SIM_PPB_BASE));
+}
+
+static void sim_ppb_set(struct dap_sim *sim, uint32_t addr, uint32_t value)
+{
+	h_u32_to_le(sim->ppb + (addr - SIM_PPB_BASE), value);
+}
+
+void dap_sim_reset(struct dap_sim *sim)
+{
+	uint8_t *vectors = sim->num_regions ? sim->regions[0].data : NULL;
+
+	memset(sim->regs, 0, sizeof(sim->regs));
+	if (vectors && sim->regions[0].size >= 8) {
+		sim->regs[13] = le_to_h_u32(vectors);
+		sim->regs[15] = le_to_h_u32(vectors + 4) & ~1;
+	}
+	sim->regs[16] = 0x01000000;
+	sim->reset_seen = true;
+
+	if ((sim->dhcsr_ctrl & C_DEBUGEN) && (sim_ppb_get(sim, SIM_DEMCR) & VC_CORERESET)) {
+		sim->halted = true;
+		sim_ppb_set(sim, SIM_DFSR, sim_ppb_get(sim, SIM_DFSR) | DFSR_VCATCH);
+	} else {
+		sim->halted = false;
+	}
+}
+
+static uint32_t sim_scs_read(struct dap_sim *sim, uint32_t addr, uint32_t value)
+{
+	switch (addr) {
+	case SIM_CPUID_ADDR:
+		return SIM_CPUID;
+	case SIM_AIRCR:
+		return 0xFA050000 | (value & 0x0000FFF8);
+	case SIM_DHCSR:
+		value = sim->dhcsr_ctrl | S_REGRDY;
+		if (sim->halted)
+			value |= S_HALT;
+		if (sim->reset_seen)
+			value |= S_RESET_ST;
+		sim->reset_seen = false;
+		return value;
+	case SIM_DCRDR:
+		return sim->dcrdr;
+	case SIM_DWT_CTRL:
+		return SIM_DWT_NUMCOMP << 28;
+	case SIM_FP_CTRL:
+		return (value & 1) | (SIM_FPB_NUM_CODE << 4) | (SIM_FPB_NUM_LIT << 8);
+	default:
+		return value;
+	}
+}
+
+/* returns true if the write was consumed by a register model */
+static bool sim_scs_write(struct dap_sim *sim, uint32_t addr, uint32_t value)
+{
+	switch (addr) {
+	case SIM_CPUID_ADDR:
+		return true;
+	case SIM_AIRCR:
+		if ((value >> 16) == 0x05FA && (value & (AIRCR_SYSRESETREQ | AIRCR_VECTRESET)))
+			dap_sim_reset(sim);
+		sim_ppb_set(sim, addr, value & 0x0000FFF8);
+		return true;
+	case SIM_DFSR:
+		/* write one to clear */
+		sim_ppb_set(sim, addr, sim_ppb_get(sim, addr) & ~value);
+		return true;
+	case SIM_DHCSR:
+		if ((value & 0xFFFF0000) != DBGKEY)
+			return true;
+		sim->dhcsr_ctrl = value & (C_DEBUGEN | C_HALT | C_STEP | C_MASKINTS);
+		if (!(value & C_DEBUGEN)) {
+			sim->halted = false;
+		} else if (value & C_HALT) {
+			if (!sim->halted)
+				sim_ppb_set(sim, SIM_DFSR, sim_ppb_get(sim, SIM_DFSR) | DFSR_HALTED);
+			sim->halted = true;
+		} else if (value & C_STEP) {
+			/* no instruction model, step over a 16 bit instruction */
+			sim->regs[15] += 2;
+			sim->halted = true;
+			sim_ppb_set(sim, SIM_DFSR, sim_ppb_get(sim, SIM_DFSR) | DFSR_HALTED);
+		} else {
+			sim->halted = false;
+		}
+		return true;
+	case SIM_DCRSR:
+		if (sim->halted) {
+			unsigned int regsel = value & 0x7F;
+			if (value & DCRSR_WnR)
+				sim->regs[regsel] = sim->dcrdr;
+			else
+				sim->dcrdr = sim->regs[regsel];
+		}
+		return true;
+	case SIM_DCRDR:
+		sim->dcrdr = value;
+		return true;
+	case SIM_FP_CTRL:
+		if (value & 2)
+			sim_ppb_set(sim, addr, value & 1);
+		return true;
+	default:
+		return false;
+	}
+}
+
+static int sim_bus_read(struct dap_sim *sim, uint32_t addr, unsigned int size, uint32_t *value)
+{
+	uint32_t aligned = addr & ~3;
+	uint8_t *p = sim_bus_ptr(sim, aligned, 4, false);
+
+	if (p == NULL)
+		return ERROR_FAIL;
+
+	uint32_t word = le_to_h_u32(p);
+	if (aligned >= SIM_PPB_BASE && aligned - SIM_PPB_BASE < SIM_PPB_SIZE)
+		word = sim_scs_read(sim, aligned, word);
+
+	/* data shows up on the byte lanes of the address, like on the AHB */
+	*value = word;
+	if (size < 4) {
+		uint32_t mask = size == 1 ? 0xff : 0xffff;
+		*value = word & (mask << 8 * (addr & 3));
+	}
+	return ERROR_OK;
+}
+
+static int sim_bus_write(struct dap_sim *sim, uint32_t addr, unsigned int size, uint32_t value)
+{
+	uint32_t aligned = addr & ~3;
+	uint8_t *p = sim_bus_ptr(sim, aligned, 4, true);
+
+	if (p == NULL)
+		return ERROR_FAIL;
+
+	if (aligned >= SIM_PPB_BASE && aligned - SIM_PPB_BASE < SIM_PPB_SIZE
+			&& size == 4 && sim_scs_write(sim, aligned, value))
+		return ERROR_OK;
+
+	for (unsigned int i = 0; i < size; i++) {
+		unsigned int lane = (addr & 3) + i;
+		p[lane] = value >> 8 * lane;
+	}
+	return ERROR_OK;
+}
+
+/* MEM-AP */
+
+static unsigned int sim_csw_size(struct dap_sim *sim)
+{
+	switch (sim->csw & CSW_SIZE_MASK) {
+	case CSW_8BIT:
+		return 1;
+	case CSW_16BIT:
+		return 2;
+	default:
+		return 4;
+	}
+}
+
+static void sim_tar_increment(struct dap_sim *sim, uint32_t amount)
+{
+	/* the auto-increment only covers the low ten bits */
+	sim->tar = (sim->tar & ~0x3FF) | ((sim->tar + amount) & 0x3FF);
+}
+
+static int sim_drw_access(struct dap_sim *sim, bool read, uint32_t *value)
+{
+	unsigned int size = sim_csw_size(sim);
+	uint32_t addrinc = sim->csw & CSW_ADDRINC_MASK;
+	unsigned int count = 1;
+	int retval = ERROR_OK;
+
+	if (addrinc == CSW_ADDRINC_PACKED && size < 4)
+		count = 4 / size;
+
+	if (read)
+		*value = 0;
+
+	for (unsigned int i = 0; i < count && retval == ERROR_OK; i++) {
+		uint32_t addr = sim->tar + i * size;
+		if (read) {
+			uint32_t data;
+			retval = sim_bus_read(sim, addr, size, &data);
+			*value |= data;
+		} else {
+			retval = sim_bus_write(sim, addr, size, *value);
+		}
+	}
+
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (addrinc == CSW_ADDRINC_PACKED)
+		sim_tar_increment(sim, count * size);
+	else if (addrinc == CSW_ADDRINC_SINGLE)
+		sim_tar_increment(sim, size);
+
+	return ERROR_OK;
+}
+
+static int sim_ap_access(struct dap_sim *sim, bool read, unsigned int reg, uint32_t *value)
+{
+	unsigned int apsel = sim->select >> 24;
+
+	if (apsel != 0) {
+		/* no AP there, reads as zero */
+		if (read)
+			*value = 0;
+		return ERROR_OK;
+	}
+
+	reg |= sim->select & DP_SELECT_APBANK;
+
+	switch (reg) {
+	case MEM_AP_REG_CSW:
+		if (read)
+			*value = sim->csw | CSW_DEVICE_EN;
+		else
+			sim->csw = *value & ~(CSW_DEVICE_EN | CSW_TRIN_PROG);
+		return ERROR_OK;
+	case MEM_AP_REG_TAR:
+		if (read)
+			*value = sim->tar;
+		else
+			sim->tar = *value;
+		return ERROR_OK;
+	case MEM_AP_REG_DRW:
+		return sim_drw_access(sim, read, value);
+	case MEM_AP_REG_BD0:
+	case MEM_AP_REG_BD1:
+	case MEM_AP_REG_BD2:
+	case MEM_AP_REG_BD3:
+		if (read)
+			return sim_bus_read(sim, (sim->tar & ~0xF) | (reg & 0xC), 4, value);
+		return sim_bus_write(sim, (sim->tar & ~0xF) | (reg & 0xC), 4, *value);
+	case MEM_AP_REG_BASE:
+		if (read)
+			*value = SIM_AP_BASE;
+		return ERROR_OK;
+	case AP_REG_IDR:
+		if (read)
+			*value = SIM_AP_IDR;
+		return ERROR_OK;
+	default:
+		if (read)
+			*value = 0;
+		return ERROR_OK;
+	}
+}
+
+/* one SWD packet */
+int dap_sim_transaction(struct dap_sim *sim, uint8_t cmd, uint32_t *value)
+{
+	bool read = cmd & SWD_CMD_RnW;
+	unsigned int reg = (cmd & SWD_CMD_A32) >> 1;
+	uint32_t data = value ? *value : 0;
+
+	sim->stats.transactions++;
+
+	if (!(cmd & SWD_CMD_APnDP)) {
+		switch (reg | (read ? 0x100 : 0)) {
+		case DP_DPIDR | 0x100:
+			data = SIM_DPIDR;
+			break;
+		case DP_ABORT:
+			if (data & STKERRCLR)
+				sim->ctrl_stat &= ~SSTICKYERR;
+			if (data & STKCMPCLR)
+				sim->ctrl_stat &= ~SSTICKYCMP;
+			if (data & ORUNERRCLR)
+				sim->ctrl_stat &= ~SSTICKYORUN;
+			if (data & WDERRCLR)
+				sim->ctrl_stat &= ~WDATAERR;
+			break;
+		case DP_CTRL_STAT | 0x100:
+			if (sim->select & DP_SELECT_DPBANK) {
+				data = 0;
+				break;
+			}
+			data = sim->ctrl_stat;
+			if (data & CDBGPWRUPREQ)
+				data |= CDBGPWRUPACK;
+			if (data & CSYSPWRUPREQ)
+				data |= CSYSPWRUPACK;
+			break;
+		case DP_CTRL_STAT:
+			if (!(sim->select & DP_SELECT_DPBANK))
+				sim->ctrl_stat = (sim->ctrl_stat & (SSTICKYERR | SSTICKYCMP | SSTICKYORUN | WDATAERR))
+					| (data & ~(SSTICKYERR | SSTICKYCMP | SSTICKYORUN | WDATAERR
+						| CDBGPWRUPACK | CSYSPWRUPACK));
+			break;
+		case DP_SELECT:
+			sim->select = data;
+			break;
+		case DP_RESEND | 0x100:
+		case DP_RDBUFF | 0x100:
+			data = sim->rdbuff;
+			break;
+		default:
+			data = 0;
+			break;
+		}
+
+		if (read && value)
+			*value = data;
+		return SWD_ACK_OK;
+	}
+
+	/* AP accesses fault while a sticky error is pending */
+	if (sim->ctrl_stat & SSTICKYERR) {
+		sim->stats.faults++;
+		return SWD_ACK_FAULT;
+	}
+
+	if (read) {
+		uint32_t result = 0;
+		sim->stats.ap_reads++;
+		if (sim_ap_access(sim, true, reg, &result) != ERROR_OK)
+			sim->ctrl_stat |= SSTICKYERR;
+		/* AP reads are posted, the result of this one comes with the next */
+		if (value)
+			*value = sim->rdbuff;
+		sim->rdbuff = result;
+	} else {
+		sim->stats.ap_writes++;
+		if (sim_ap_access(sim, false, reg, &data) != ERROR_OK)
+			sim->ctrl_stat |= SSTICKYERR;
+	}
+
+	return SWD_ACK_OK;
+}
+
+void dap_sim_line_reset(struct dap_sim *sim)
+{
+	sim->select = 0;
+}
+
+int dap_sim_add_region(struct dap_sim *sim, uint32_t base, uint32_t size, bool read_only)
+{
+	if (sim->num_regions == SIM_MAX_REGIONS) {
+		LOG_ERROR("too many memory regions");
+		return ERROR_FAIL;
+	}
+
+	struct sim_region *r = &sim->regions[sim->num_regions];
+	r->data = malloc(size);
+	if (r->data == NULL) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
+
+	memset(r->data, read_only ? 0xff : 0x00, size);
+	r->base = base;
+	r->size = size;
+	r->read_only = read_only;
+	sim->num_regions++;
+
+	return ERROR_OK;
+}
+
+unsigned int dap_sim_num_regions(struct dap_sim *sim)
+{
+	return sim->num_regions;
+}
+
+struct dap_sim *dap_sim_new(void)
+{
+	struct dap_sim *sim = calloc(1, sizeof(*sim));
+
+	if (sim == NULL)
+		return NULL;
+
+	sim->ppb = calloc(1, SIM_PPB_SIZE);
+	if (sim->ppb == NULL) {
+		free(sim);
+		return NULL;
+	}
+
+	return sim;
+}
+
+void dap_sim_free(struct dap_sim *sim)
+{
+	if (sim == NULL)
+		return;
+
+	for (unsigned int i = 0; i < sim->num_regions; i++)
+		free(sim->regions[i].data);
+	free(sim->ppb);
+	free(sim);
+}
+
+void dap_sim_get_stats(struct dap_sim *sim, struct dap_sim_stats *stats)
+{
+	*stats = sim->stats;
+}
+
+void dap_sim_reset_stats(struct dap_sim *sim)
+{
+	memset(&sim->stats, 0, sizeof(sim->stats));
+}
@@ -0,0 +1,65 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef OPENOCD_JTAG_DRIVERS_DAP_SIM_H
+#define OPENOCD_JTAG_DRIVERS_DAP_SIM_H
+
+/*
+ * Software model of an ADIv5 SW-DP with one AHB-AP in front of a memory
+ * map and the Cortex-M debug registers. Shared by the simulated adapters
+ * (swdsim and the CMSIS-DAP emulator), which only differ in how the
+ * transactions reach it.
+ */
+
+struct dap_sim;
+
+struct dap_sim_stats {
+	/** DP and AP accesses, including faulted ones. */
+	uint64_t transactions;
+	uint64_t ap_reads;
+	uint64_t ap_writes;
+	/** AP accesses answered with FAULT because of a sticky error. */
+	uint64_t faults;
+};
+
+struct dap_sim *dap_sim_new(void);
+void dap_sim_free(struct dap_sim *sim);
+
+/**
+ * Add a memory region. The first one holds the vector table used on reset.
+ * Flash (@a read_only) reads as erased, RAM as zero.
+ */
+int dap_sim_add_region(struct dap_sim *sim, uint32_t base, uint32_t size, bool read_only);
+unsigned int dap_sim_num_regions(struct dap_sim *sim);
+
+/** Reset the core, as after SRST or SYSRESETREQ. */
+void dap_sim_reset(struct dap_sim *sim);
+/** SWD line reset or JTAG-to-SWD switch. */
+void dap_sim_line_reset(struct dap_sim *sim);
+
+/**
+ * Run one SWD transaction. @a cmd is built with swd_cmd(); for writes
+ * @a value holds the data, for reads it receives it. AP reads are posted,
+ * like on the wire: the value returned is the one of the previous AP read
+ * and the current one is fetched from DP RDBUFF.
+ * @returns SWD_ACK_OK, or SWD_ACK_FAULT for an AP access while a sticky
+ *	error is pending.
+ */
+int dap_sim_transaction(struct dap_sim *sim, uint8_t cmd, uint32_t *value);
+
+void dap_sim_get_stats(struct dap_sim *sim, struct dap_sim_stats *stats);
+void dap_sim_reset_stats(struct dap_sim *sim);
+
+#endif /* OPENOCD_JTAG_DRIVERS_DAP_SIM_H */
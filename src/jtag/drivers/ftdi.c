@@ -886,6 +886,34 @@ COMMAND_HANDLER(ftdi_handle_get_signal_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(ftdi_handle_stats_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1) {
+		if (strcmp(CMD_ARGV[0], "reset") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		mpsse_reset_stats(mpsse_ctx);
+		return ERROR_OK;
+	}
+
+	struct mpsse_stats stats;
+	mpsse_get_stats(mpsse_ctx, &stats);
+
+	float seconds = stats.elapsed_ms > 0 ? stats.elapsed_ms / 1000.0 : 1;
+	command_print(CMD_CTX, "%" PRIu64 " batches, %" PRIu64 " sent while queuing",
+			stats.batches, stats.overlapped_batches);
+	command_print(CMD_CTX, "%" PRIu64 " bytes written (%.3f KiB/s), %" PRIu64
+			" bytes read (%.3f KiB/s) in %.3f s",
+			stats.bytes_written, stats.bytes_written / 1024.0 / seconds,
+			stats.bytes_read, stats.bytes_read / 1024.0 / seconds, seconds);
+	command_print(CMD_CTX, "%.3f s spent waiting for the adapter",
+			stats.wait_us / 1000000.0);
+
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(ftdi_handle_vid_pid_command)
 {
 	if (CMD_ARGC > MAX_USB_IDS * 2) {
@@ -1000,6 +1028,13 @@ static const struct command_registration ftdi_command_handlers[] = {
 		.help = "read the value of a layout-specific signal",
 		.usage = "name",
 	},
+	{
+		.name = "ftdi_stats",
+		.handler = &ftdi_handle_stats_command,
+		.mode = COMMAND_EXEC,
+		.help = "show or reset the MPSSE transfer statistics",
+		.usage = "['reset']",
+	},
 	{
 		.name = "ftdi_vid_pid",
 		.handler = &ftdi_handle_vid_pid_command,
@@ -156,6 +156,87 @@ int jtag_libusb_bulk_read(jtag_libusb_device_handle *dev, int ep, char *bytes,
 	return transferred;
 }
 
+static void LIBUSB_CALL jtag_libusb_xfer_done(struct libusb_transfer *transfer)
+{
+	int *completed = transfer->user_data;
+	*completed = 1;
+}
+
+/* completion of a transfer given up on, nobody waits for it anymore */
+static void LIBUSB_CALL jtag_libusb_xfer_abandoned(struct libusb_transfer *transfer)
+{
+	libusb_free_transfer(transfer);
+}
+
+int jtag_libusb_bulk_transfer_n(jtag_libusb_device_handle *dev,
+		struct jtag_xfer *transfers, size_t n_transfers, int timeout)
+{
+	int retval = ERROR_OK;
+	size_t submitted = 0;
+
+	for (size_t i = 0; i < n_transfers; i++) {
+		transfers[i].transfer = libusb_alloc_transfer(0);
+		transfers[i].completed = 0;
+		transfers[i].transferred = 0;
+		if (transfers[i].transfer == NULL) {
+			retval = ERROR_FAIL;
+			break;
+		}
+		libusb_fill_bulk_transfer(transfers[i].transfer, dev,
+				transfers[i].ep, transfers[i].buf, transfers[i].size,
+				jtag_libusb_xfer_done, &transfers[i].completed, timeout);
+		if (libusb_submit_transfer(transfers[i].transfer) != 0) {
+			retval = ERROR_FAIL;
+			break;
+		}
+		submitted++;
+	}
+
+	/* on a failed submit, cancel what is already on the bus */
+	if (retval != ERROR_OK) {
+		for (size_t i = 0; i < submitted; i++)
+			libusb_cancel_transfer(transfers[i].transfer);
+	}
+
+	/* wait for every submitted transfer to complete, in order */
+	for (size_t i = 0; i < submitted; i++) {
+		while (!transfers[i].completed) {
+			int ret = libusb_handle_events_completed(jtag_libusb_context,
+					&transfers[i].completed);
+			if (ret == 0)
+				continue;
+
+			/* The transfers still outstanding can't be waited for. Cancel
+			 * them and let them free themselves if they ever complete. */
+			LOG_ERROR("libusb_handle_events() failed with %d", ret);
+			for (size_t j = i; j < submitted; j++) {
+				if (transfers[j].completed)
+					continue;
+				libusb_cancel_transfer(transfers[j].transfer);
+				transfers[j].transfer->callback = jtag_libusb_xfer_abandoned;
+				transfers[j].transfer->user_data = NULL;
+				transfers[j].transfer = NULL;
+			}
+			retval = ERROR_FAIL;
+			goto done;
+		}
+
+		transfers[i].transferred = transfers[i].transfer->actual_length;
+		if (transfers[i].transfer->status != LIBUSB_TRANSFER_COMPLETED)
+			retval = ERROR_FAIL;
+	}
+
+done:
+	for (size_t i = 0; i < n_transfers; i++) {
+		if (transfers[i].transfer) {
+			libusb_free_transfer(transfers[i].transfer);
+			transfers[i].transfer = NULL;
+		}
+	}
+
+	return retval;
+}
+
 int jtag_libusb_set_configuration(jtag_libusb_device_handle *devh,
 		int configuration)
 {
@@ -56,6 +56,29 @@ int jtag_libusb_bulk_write(struct jtag_libusb_device_handle *dev, int ep,
 		char *bytes,	int size, int timeout);
 int jtag_libusb_bulk_read(struct jtag_libusb_device_handle *dev, int ep,
 		char *bytes, int size, int timeout);
+/** One bulk transfer of a batch handed to jtag_libusb_bulk_transfer_n(). */
+struct jtag_xfer {
+	/** Endpoint, including the direction bit. */
+	int ep;
+	uint8_t *buf;
+	int size;
+	/** Number of bytes actually moved, filled in on return. */
+	int transferred;
+	/* private to jtag_libusb_bulk_transfer_n() */
+	struct libusb_transfer *transfer;
+	int completed;
+};
+
+/**
+ * Submit a batch of bulk transfers at once and wait for all of them.
+ *
+ * The transfers are queued to the device back to back, so e.g. a command
+ * and its data phase do not each cost a full USB round trip.
+ * @returns ERROR_OK if every transfer completed, ERROR_FAIL otherwise.
+ *	The caller still has to check the transferred byte counts.
+ */
+int jtag_libusb_bulk_transfer_n(jtag_libusb_device_handle *dev,
+		struct jtag_xfer *transfers, size_t n_transfers, int timeout);
 int jtag_libusb_set_configuration(jtag_libusb_device_handle *devh,
 		int configuration);
 /**
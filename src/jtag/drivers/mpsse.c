@@ -22,6 +22,7 @@
 
 #include "mpsse.h"
 #include "helper/log.h"
+#include "helper/time_support.h"
 #include <libusb.h>
 
 /* Compatibility define for older libusb-1.0 */
@@ -64,6 +65,31 @@
 #define SIO_RESET_PURGE_RX 1
 #define SIO_RESET_PURGE_TX 2
 
+/* Context needed by the callbacks */
+struct transfer_result {
+	struct mpsse_ctx *ctx;
+	bool done;
+	unsigned transferred;
+};
+
+/* A flushed batch of commands. It is transferred to and from the adapter
+ * while the next batch is queued in the context's other pair of buffers,
+ * and must be waited for before that one can be submitted. */
+struct mpsse_batch {
+	uint8_t *write_buffer;
+	unsigned write_count;
+	uint8_t *read_buffer;
+	unsigned read_count;
+	struct bit_copy_queue *read_queue;
+	struct transfer_result write_result;
+	struct transfer_result read_result;
+	/* libusb status of submitting the transfers */
+	int submit_status;
+	bool in_flight;
+	/* submitted because the buffer filled up, not by mpsse_flush() */
+	bool overlapped;
+};
+
 struct mpsse_ctx {
 	libusb_context *usb_ctx;
 	libusb_device_handle *usb_dev;
@@ -75,18 +101,29 @@ struct mpsse_ctx {
 	uint16_t index;
 	uint8_t interface;
 	enum ftdi_chip_type type;
+	/* Buffers being filled by the command queuing functions */
 	uint8_t *write_buffer;
 	unsigned write_size;
 	unsigned write_count;
 	uint8_t *read_buffer;
 	unsigned read_size;
 	unsigned read_count;
+	struct bit_copy_queue *read_queue;
+	/* The other pair of buffers belongs to the batch sent last */
+	struct mpsse_batch batch;
+	struct bit_copy_queue read_queues[2];
 	uint8_t *read_chunk;
 	unsigned read_chunk_size;
-	struct bit_copy_queue read_queue;
+	/* Allocated once and reused by every batch */
+	struct libusb_transfer *write_transfer;
+	struct libusb_transfer *read_transfer;
+	struct mpsse_stats stats;
+	int64_t stats_start;
 	int retval;
 };
 
+static void mpsse_batch_cancel(struct mpsse_ctx *ctx);
+
 /* Returns true if the string descriptor indexed by str_index in device matches string */
 static bool string_descriptor_equal(libusb_device_handle *device, uint8_t str_index,
 	const char *string)
@@ -329,14 +366,25 @@ struct mpsse_ctx *mpsse_open(const uint16_t *vid, const uint16_t *pid, const cha
 	if (!ctx)
 		return 0;
 
-	bit_copy_queue_init(&ctx->read_queue);
+	bit_copy_queue_init(&ctx->read_queues[0]);
+	bit_copy_queue_init(&ctx->read_queues[1]);
+	ctx->read_queue = &ctx->read_queues[0];
+	ctx->batch.read_queue = &ctx->read_queues[1];
 	ctx->read_chunk_size = 16384;
 	ctx->read_size = 16384;
 	ctx->write_size = 16384;
 	ctx->read_chunk = malloc(ctx->read_chunk_size);
 	ctx->read_buffer = malloc(ctx->read_size);
 	ctx->write_buffer = malloc(ctx->write_size);
-	if (!ctx->read_chunk || !ctx->read_buffer || !ctx->write_buffer)
+	ctx->batch.read_buffer = malloc(ctx->read_size);
+	ctx->batch.write_buffer = malloc(ctx->write_size);
+	if (!ctx->read_chunk || !ctx->read_buffer || !ctx->write_buffer
+			|| !ctx->batch.read_buffer || !ctx->batch.write_buffer)
+		goto error;
+
+	ctx->write_transfer = libusb_alloc_transfer(0);
+	ctx->read_transfer = libusb_alloc_transfer(0);
+	if (!ctx->write_transfer || !ctx->read_transfer)
 		goto error;
 
 	ctx->interface = channel;
@@ -387,6 +435,7 @@ struct mpsse_ctx *mpsse_open(const uint16_t *vid, const uint16_t *pid, const cha
 	}
 
 	mpsse_purge(ctx);
+	mpsse_reset_stats(ctx);
 
 	return ctx;
 error:
@@ -396,15 +445,26 @@ error:
 
 void mpsse_close(struct mpsse_ctx *ctx)
 {
+	if (ctx->batch.in_flight)
+		mpsse_batch_cancel(ctx);
+	if (ctx->write_transfer)
+		libusb_free_transfer(ctx->write_transfer);
+	if (ctx->read_transfer)
+		libusb_free_transfer(ctx->read_transfer);
 	if (ctx->usb_dev)
 		libusb_close(ctx->usb_dev);
 	if (ctx->usb_ctx)
 		libusb_exit(ctx->usb_ctx);
-	bit_copy_discard(&ctx->read_queue);
+	bit_copy_discard(&ctx->read_queues[0]);
+	bit_copy_discard(&ctx->read_queues[1]);
 	if (ctx->write_buffer)
 		free(ctx->write_buffer);
 	if (ctx->read_buffer)
 		free(ctx->read_buffer);
+	if (ctx->batch.write_buffer)
+		free(ctx->batch.write_buffer);
+	if (ctx->batch.read_buffer)
+		free(ctx->batch.read_buffer);
 	if (ctx->read_chunk)
 		free(ctx->read_chunk);
 
@@ -420,10 +480,14 @@ void mpsse_purge(struct mpsse_ctx *ctx)
 {
 	int err;
 	LOG_DEBUG("-");
+	if (ctx->batch.in_flight)
+		mpsse_batch_cancel(ctx);
+	ctx->batch.in_flight = false;
 	ctx->write_count = 0;
 	ctx->read_count = 0;
 	ctx->retval = ERROR_OK;
-	bit_copy_discard(&ctx->read_queue);
+	bit_copy_discard(&ctx->read_queues[0]);
+	bit_copy_discard(&ctx->read_queues[1]);
 	err = libusb_control_transfer(ctx->usb_dev, FTDI_DEVICE_OUT_REQTYPE, SIO_RESET_REQUEST,
 			SIO_RESET_PURGE_RX, ctx->index, NULL, 0, ctx->usb_write_timeout);
 	if (err < 0) {
@@ -472,12 +536,14 @@ static unsigned buffer_add_read(struct mpsse_ctx *ctx, uint8_t *in, unsigned in_
 {
 	DEBUG_IO("%d bits, offset %d", bit_count, offset);
 	assert(ctx->read_count + DIV_ROUND_UP(bit_count, 8) <= ctx->read_size);
-	bit_copy_queued(&ctx->read_queue, in, in_offset, ctx->read_buffer + ctx->read_count, offset,
+	bit_copy_queued(ctx->read_queue, in, in_offset, ctx->read_buffer + ctx->read_count, offset,
 		bit_count);
 	ctx->read_count += DIV_ROUND_UP(bit_count, 8);
 	return bit_count;
 }
 
+static int mpsse_flush_async(struct mpsse_ctx *ctx);
+
 void mpsse_clock_data_out(struct mpsse_ctx *ctx, const uint8_t *out, unsigned out_offset,
 	unsigned length, uint8_t mode)
 {
@@ -511,7 +577,7 @@ void mpsse_clock_data(struct mpsse_ctx *ctx, const uint8_t *out, unsigned out_of
 		/* Guarantee buffer space enough for a minimum size transfer */
 		if (buffer_write_space(ctx) + (length < 8) < (out || (!out && !in) ? 4 : 3)
 				|| (in && buffer_read_space(ctx) < 1))
-			ctx->retval = mpsse_flush(ctx);
+			ctx->retval = mpsse_flush_async(ctx);
 
 		if (length < 8) {
 			/* Transfer remaining bits in bit mode */
@@ -585,7 +651,7 @@ void mpsse_clock_tms_cs(struct mpsse_ctx *ctx, const uint8_t *out, unsigned out_
 	while (length > 0) {
 		/* Guarantee buffer space enough for a minimum size transfer */
 		if (buffer_write_space(ctx) < 3 || (in && buffer_read_space(ctx) < 1))
-			ctx->retval = mpsse_flush(ctx);
+			ctx->retval = mpsse_flush_async(ctx);
 
 		/* Byte transfer */
 		unsigned this_bits = length;
@@ -628,7 +694,7 @@ void mpsse_set_data_bits_low_byte(struct mpsse_ctx *ctx, uint8_t data, uint8_t d
 	}
 
 	if (buffer_write_space(ctx) < 3)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, 0x80);
 	buffer_write_byte(ctx, data);
@@ -645,7 +711,7 @@ void mpsse_set_data_bits_high_byte(struct mpsse_ctx *ctx, uint8_t data, uint8_t
 	}
 
 	if (buffer_write_space(ctx) < 3)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, 0x82);
 	buffer_write_byte(ctx, data);
@@ -662,7 +728,7 @@ void mpsse_read_data_bits_low_byte(struct mpsse_ctx *ctx, uint8_t *data)
 	}
 
 	if (buffer_write_space(ctx) < 1 || buffer_read_space(ctx) < 1)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, 0x81);
 	buffer_add_read(ctx, data, 0, 8, 0);
@@ -678,7 +744,7 @@ void mpsse_read_data_bits_high_byte(struct mpsse_ctx *ctx, uint8_t *data)
 	}
 
 	if (buffer_write_space(ctx) < 1 || buffer_read_space(ctx) < 1)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, 0x83);
 	buffer_add_read(ctx, data, 0, 8, 0);
@@ -693,7 +759,7 @@ static void single_byte_boolean_helper(struct mpsse_ctx *ctx, bool var, uint8_t
 	}
 
 	if (buffer_write_space(ctx) < 1)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, var ? val_if_true : val_if_false);
 }
@@ -714,7 +780,7 @@ void mpsse_set_divisor(struct mpsse_ctx *ctx, uint16_t divisor)
 	}
 
 	if (buffer_write_space(ctx) < 3)
-		ctx->retval = mpsse_flush(ctx);
+		ctx->retval = mpsse_flush_async(ctx);
 
 	buffer_write_byte(ctx, 0x86);
 	buffer_write_byte(ctx, divisor & 0xff);
@@ -774,22 +840,21 @@ int mpsse_set_frequency(struct mpsse_ctx *ctx, int frequency)
 	return frequency;
 }
 
-/* Context needed by the callbacks */
-struct transfer_result {
-	struct mpsse_ctx *ctx;
-	bool done;
-	unsigned transferred;
-};
-
 static LIBUSB_CALL void read_cb(struct libusb_transfer *transfer)
 {
 	struct transfer_result *res = transfer->user_data;
 	struct mpsse_ctx *ctx = res->ctx;
+	struct mpsse_batch *batch = &ctx->batch;
 
 	unsigned packet_size = ctx->max_packet_size;
 
 	DEBUG_PRINT_BUF(transfer->buffer, transfer->actual_length);
 
+	if (transfer->status == LIBUSB_TRANSFER_CANCELLED) {
+		res->done = true;
+		return;
+	}
+
 	/* Strip the two status bytes sent at the beginning of each USB packet
 	 * while copying the chunk buffer to the read buffer */
 	unsigned num_packets = DIV_ROUND_UP(transfer->actual_length, packet_size);
@@ -798,21 +863,21 @@ static LIBUSB_CALL void read_cb(struct libusb_transfer *transfer)
 		unsigned this_size = packet_size - 2;
 		if (this_size > chunk_remains - 2)
 			this_size = chunk_remains - 2;
-		if (this_size > ctx->read_count - res->transferred)
-			this_size = ctx->read_count - res->transferred;
-		memcpy(ctx->read_buffer + res->transferred,
+		if (this_size > batch->read_count - res->transferred)
+			this_size = batch->read_count - res->transferred;
+		memcpy(batch->read_buffer + res->transferred,
 			ctx->read_chunk + packet_size * i + 2,
 			this_size);
 		res->transferred += this_size;
 		chunk_remains -= this_size + 2;
-		if (res->transferred == ctx->read_count) {
+		if (res->transferred == batch->read_count) {
 			res->done = true;
 			break;
 		}
 	}
 
 	DEBUG_IO("raw chunk %d, transferred %d of %d", transfer->actual_length, res->transferred,
-		ctx->read_count);
+		batch->read_count);
 
 	if (!res->done)
 		if (libusb_submit_transfer(transfer) != LIBUSB_SUCCESS)
@@ -822,71 +887,121 @@ static LIBUSB_CALL void read_cb(struct libusb_transfer *transfer)
 static LIBUSB_CALL void write_cb(struct libusb_transfer *transfer)
 {
 	struct transfer_result *res = transfer->user_data;
-	struct mpsse_ctx *ctx = res->ctx;
+	struct mpsse_batch *batch = &res->ctx->batch;
 
 	res->transferred += transfer->actual_length;
 
-	DEBUG_IO("transferred %d of %d", res->transferred, ctx->write_count);
+	DEBUG_IO("transferred %d of %d", res->transferred, batch->write_count);
 
 	DEBUG_PRINT_BUF(transfer->buffer, transfer->actual_length);
 
-	if (res->transferred == ctx->write_count)
+	if (res->transferred == batch->write_count || transfer->status == LIBUSB_TRANSFER_CANCELLED)
 		res->done = true;
 	else {
-		transfer->length = ctx->write_count - res->transferred;
-		transfer->buffer = ctx->write_buffer + res->transferred;
+		transfer->length = batch->write_count - res->transferred;
+		transfer->buffer = batch->write_buffer + res->transferred;
 		if (libusb_submit_transfer(transfer) != LIBUSB_SUCCESS)
 			res->done = true;
 	}
 }
 
-int mpsse_flush(struct mpsse_ctx *ctx)
+/* Cancel whatever is left of the batch in flight and wait for libusb to
+ * give the transfers back */
+static void mpsse_batch_cancel(struct mpsse_ctx *ctx)
 {
-	int retval = ctx->retval;
+	struct mpsse_batch *batch = &ctx->batch;
 
-	if (retval != ERROR_OK) {
-		DEBUG_IO("Ignoring flush due to previous error");
-		assert(ctx->write_count == 0 && ctx->read_count == 0);
-		ctx->retval = ERROR_OK;
-		return retval;
+	if (!batch->write_result.done)
+		libusb_cancel_transfer(ctx->write_transfer);
+	if (!batch->read_result.done)
+		libusb_cancel_transfer(ctx->read_transfer);
+
+	while (!batch->write_result.done || !batch->read_result.done) {
+		struct timeval timeout_usb;
+
+		timeout_usb.tv_sec = 1;
+		timeout_usb.tv_usec = 0;
+
+		if (libusb_handle_events_timeout_completed(ctx->usb_ctx,
+					&timeout_usb, NULL) != LIBUSB_SUCCESS)
+			break;
 	}
+}
 
-	DEBUG_IO("write %d%s, read %d", ctx->write_count, ctx->read_count ? "+1" : "",
-			ctx->read_count);
-	assert(ctx->write_count > 0 || ctx->read_count == 0); /* No read data without write data */
+/* Move the queued commands into the batch and start transferring them,
+ * without waiting for the transfers to complete. A previous batch must
+ * not be in flight. */
+static void mpsse_batch_submit(struct mpsse_ctx *ctx, bool overlapped)
+{
+	struct mpsse_batch *batch = &ctx->batch;
+	uint8_t *buffer;
+	struct bit_copy_queue *queue;
 
-	if (ctx->write_count == 0)
-		return retval;
+	assert(!batch->in_flight);
 
-	struct libusb_transfer *read_transfer = 0;
-	struct transfer_result read_result = { .ctx = ctx, .done = true };
 	if (ctx->read_count) {
 		buffer_write_byte(ctx, 0x87); /* SEND_IMMEDIATE */
-		read_result.done = false;
 		/* delay read transaction to ensure the FTDI chip can support us with data
 		   immediately after processing the MPSSE commands in the write transaction */
 	}
 
-	struct transfer_result write_result = { .ctx = ctx, .done = false };
-	struct libusb_transfer *write_transfer = libusb_alloc_transfer(0);
-	libusb_fill_bulk_transfer(write_transfer, ctx->usb_dev, ctx->out_ep, ctx->write_buffer,
-		ctx->write_count, write_cb, &write_result, ctx->usb_write_timeout);
-	retval = libusb_submit_transfer(write_transfer);
-	if (retval != LIBUSB_SUCCESS)
-		goto error_check;
+	/* Swap buffers with the batch, the context is free to be refilled */
+	buffer = batch->write_buffer;
+	batch->write_buffer = ctx->write_buffer;
+	ctx->write_buffer = buffer;
+	buffer = batch->read_buffer;
+	batch->read_buffer = ctx->read_buffer;
+	ctx->read_buffer = buffer;
+	queue = batch->read_queue;
+	batch->read_queue = ctx->read_queue;
+	ctx->read_queue = queue;
+
+	batch->write_count = ctx->write_count;
+	batch->read_count = ctx->read_count;
+	ctx->write_count = 0;
+	ctx->read_count = 0;
 
-	if (ctx->read_count) {
-		read_transfer = libusb_alloc_transfer(0);
-		libusb_fill_bulk_transfer(read_transfer, ctx->usb_dev, ctx->in_ep, ctx->read_chunk,
-			ctx->read_chunk_size, read_cb, &read_result,
+	batch->write_result = (struct transfer_result) { .ctx = ctx, .done = false };
+	batch->read_result = (struct transfer_result) { .ctx = ctx, .done = batch->read_count == 0 };
+	batch->overlapped = overlapped;
+	batch->in_flight = true;
+
+	libusb_fill_bulk_transfer(ctx->write_transfer, ctx->usb_dev, ctx->out_ep, batch->write_buffer,
+		batch->write_count, write_cb, &batch->write_result, ctx->usb_write_timeout);
+	batch->submit_status = libusb_submit_transfer(ctx->write_transfer);
+	if (batch->submit_status != LIBUSB_SUCCESS) {
+		batch->write_result.done = true;
+		batch->read_result.done = true;
+		return;
+	}
+
+	if (batch->read_count) {
+		libusb_fill_bulk_transfer(ctx->read_transfer, ctx->usb_dev, ctx->in_ep, ctx->read_chunk,
+			ctx->read_chunk_size, read_cb, &batch->read_result,
 			ctx->usb_read_timeout);
-		retval = libusb_submit_transfer(read_transfer);
-		if (retval != LIBUSB_SUCCESS)
-			goto error_check;
+		batch->submit_status = libusb_submit_transfer(ctx->read_transfer);
+		if (batch->submit_status != LIBUSB_SUCCESS) {
+			batch->read_result.done = true;
+			mpsse_batch_cancel(ctx);
+		}
 	}
+}
+
+/* Wait for the batch in flight, if any, and deliver its read data */
+static int mpsse_batch_wait(struct mpsse_ctx *ctx)
+{
+	struct mpsse_batch *batch = &ctx->batch;
+	struct duration wait;
+	int retval;
+
+	if (!batch->in_flight)
+		return ERROR_OK;
+
+	duration_start(&wait);
+	retval = batch->submit_status;
 
 	/* Polling loop, more or less taken from libftdi */
-	while (!write_result.done || !read_result.done) {
+	while (retval == LIBUSB_SUCCESS && (!batch->write_result.done || !batch->read_result.done)) {
 		struct timeval timeout_usb;
 
 		timeout_usb.tv_sec = 1;
@@ -897,50 +1012,96 @@ int mpsse_flush(struct mpsse_ctx *ctx)
 		if (retval == LIBUSB_ERROR_NO_DEVICE || retval == LIBUSB_ERROR_INTERRUPTED)
 			break;
 
-		if (retval != LIBUSB_SUCCESS) {
-			libusb_cancel_transfer(write_transfer);
-			if (read_transfer)
-				libusb_cancel_transfer(read_transfer);
-			while (!write_result.done || !read_result.done) {
-				retval = libusb_handle_events_timeout_completed(ctx->usb_ctx,
-								&timeout_usb, NULL);
-				if (retval != LIBUSB_SUCCESS)
-					break;
-			}
-		}
+		if (retval != LIBUSB_SUCCESS)
+			mpsse_batch_cancel(ctx);
 	}
 
-error_check:
+	duration_measure(&wait);
+	ctx->stats.wait_us += wait.elapsed.tv_sec * 1000000ULL + wait.elapsed.tv_usec;
+	batch->in_flight = false;
+
 	if (retval != LIBUSB_SUCCESS) {
 		LOG_ERROR("libusb_handle_events() failed with %s", libusb_error_name(retval));
 		retval = ERROR_FAIL;
-	} else if (write_result.transferred < ctx->write_count) {
+	} else if (batch->write_result.transferred < batch->write_count) {
 		LOG_ERROR("ftdi device did not accept all data: %d, tried %d",
-			write_result.transferred,
-			ctx->write_count);
+			batch->write_result.transferred,
+			batch->write_count);
 		retval = ERROR_FAIL;
-	} else if (read_result.transferred < ctx->read_count) {
+	} else if (batch->read_result.transferred < batch->read_count) {
 		LOG_ERROR("ftdi device did not return all data: %d, expected %d",
-			read_result.transferred,
-			ctx->read_count);
+			batch->read_result.transferred,
+			batch->read_count);
 		retval = ERROR_FAIL;
-	} else if (ctx->read_count) {
-		ctx->write_count = 0;
-		ctx->read_count = 0;
-		bit_copy_execute(&ctx->read_queue);
-		retval = ERROR_OK;
 	} else {
-		ctx->write_count = 0;
-		bit_copy_discard(&ctx->read_queue);
+		if (batch->read_count)
+			bit_copy_execute(batch->read_queue);
+		else
+			bit_copy_discard(batch->read_queue);
+		ctx->stats.batches++;
+		if (batch->overlapped)
+			ctx->stats.overlapped_batches++;
+		ctx->stats.bytes_written += batch->write_count;
+		ctx->stats.bytes_read += batch->read_count;
 		retval = ERROR_OK;
 	}
 
-	libusb_free_transfer(write_transfer);
-	if (read_transfer)
-		libusb_free_transfer(read_transfer);
-
 	if (retval != ERROR_OK)
 		mpsse_purge(ctx);
 
 	return retval;
 }
+
+/* Used when the buffers fill up while commands are being queued: send them
+ * off and return, so the caller can go on queuing while the adapter works.
+ * Only the batch sent before has to be finished first. */
+static int mpsse_flush_async(struct mpsse_ctx *ctx)
+{
+	int retval = mpsse_batch_wait(ctx);
+
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (ctx->write_count > 0)
+		mpsse_batch_submit(ctx, true);
+
+	return ERROR_OK;
+}
+
+int mpsse_flush(struct mpsse_ctx *ctx)
+{
+	int retval = ctx->retval;
+
+	if (retval != ERROR_OK) {
+		DEBUG_IO("Ignoring flush due to previous error");
+		assert(ctx->write_count == 0 && ctx->read_count == 0);
+		ctx->retval = ERROR_OK;
+		return retval;
+	}
+
+	DEBUG_IO("write %d%s, read %d", ctx->write_count, ctx->read_count ? "+1" : "",
+			ctx->read_count);
+	assert(ctx->write_count > 0 || ctx->read_count == 0); /* No read data without write data */
+
+	retval = mpsse_batch_wait(ctx);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (ctx->write_count == 0)
+		return retval;
+
+	mpsse_batch_submit(ctx, false);
+	return mpsse_batch_wait(ctx);
+}
+
+void mpsse_get_stats(struct mpsse_ctx *ctx, struct mpsse_stats *stats)
+{
+	*stats = ctx->stats;
+	stats->elapsed_ms = timeval_ms() - ctx->stats_start;
+}
+
+void mpsse_reset_stats(struct mpsse_ctx *ctx)
+{
+	memset(&ctx->stats, 0, sizeof(ctx->stats));
+	ctx->stats_start = timeval_ms();
+}
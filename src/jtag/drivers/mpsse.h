@@ -71,8 +71,24 @@ int mpsse_rtck_config(struct mpsse_ctx *ctx, bool enable);
  * Frequency 0 means RTCK. */
 int mpsse_set_frequency(struct mpsse_ctx *ctx, int frequency);
 
-/* Queue handling */
+/* Queue handling. Queued commands are sent to the adapter in the background whenever the buffer
+ * fills up; mpsse_flush() sends the rest and waits until everything has been transferred. */
 int mpsse_flush(struct mpsse_ctx *ctx);
 void mpsse_purge(struct mpsse_ctx *ctx);
 
+/* Transfer statistics since mpsse_open() or the last mpsse_reset_stats() */
+struct mpsse_stats {
+	uint64_t batches;
+	/* batches sent while more commands were being queued */
+	uint64_t overlapped_batches;
+	uint64_t bytes_written;
+	uint64_t bytes_read;
+	/* time spent waiting for the adapter to finish a batch */
+	uint64_t wait_us;
+	int64_t elapsed_ms;
+};
+
+void mpsse_get_stats(struct mpsse_ctx *ctx, struct mpsse_stats *stats);
+void mpsse_reset_stats(struct mpsse_ctx *ctx);
+
 #endif /* OPENOCD_JTAG_DRIVERS_MPSSE_H */
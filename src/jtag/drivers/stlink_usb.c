@@ -132,6 +132,11 @@ struct stlink_usb_handle_s {
 	/** reconnect is needed next time we try to query the
 	 * status */
 	bool reconnect_pending;
+	/** status of the last memory access, already fetched together
+	 * with its command by stlink_usb_xfer_mem() */
+	bool rw_status_valid;
+	/** */
+	uint8_t rw_status[2];
 };
 
 #define STLINK_SWIM_ERR_OK             0x00
@@ -328,6 +333,25 @@ static int stlink_usb_xfer_rw(void *handle, int cmdsize, const uint8_t *buf, int
 
 	assert(handle != NULL);
 
+#ifdef HAVE_LIBUSB1
+	/* queue the command and its data phase back to back */
+	if (h->direction != STLINK_NULL_EP && size) {
+		struct jtag_xfer transfers[2] = {
+			{ .ep = h->tx_ep, .buf = h->cmdbuf, .size = cmdsize },
+			{ .ep = h->direction, .buf = (uint8_t *)buf, .size = size },
+		};
+
+		if (jtag_libusb_bulk_transfer_n(h->fd, transfers, 2,
+				STLINK_WRITE_TIMEOUT) != ERROR_OK
+				|| transfers[0].transferred != cmdsize
+				|| transfers[1].transferred != size) {
+			LOG_DEBUG("bulk transfer failed");
+			return ERROR_FAIL;
+		}
+		return ERROR_OK;
+	}
+#endif
+
 	if (jtag_libusb_bulk_write(h->fd, h->tx_ep, (char *)h->cmdbuf, cmdsize,
 			STLINK_WRITE_TIMEOUT) != cmdsize) {
 		return ERROR_FAIL;
@@ -415,6 +439,51 @@ static int stlink_usb_xfer(void *handle, const uint8_t *buf, int size)
 	return ERROR_OK;
 }
 
+/*
+	transfers a memory access command in cmdbuf, its data phase and,
+	where possible, the GETLASTRWSTATUS query that has to follow it
+	in a single batch. The status is then picked up by
+	stlink_usb_get_rw_status() without another round trip.
+*/
+static int stlink_usb_xfer_mem(void *handle, const uint8_t *buf, int size)
+{
+	struct stlink_usb_handle_s *h = handle;
+
+	assert(handle != NULL);
+
+	h->rw_status_valid = false;
+
+#ifdef HAVE_LIBUSB1
+	if (h->version.stlink != 1 && h->jtag_api != STLINK_JTAG_API_V1 && size) {
+		uint8_t status_cmd[STLINK_CMD_SIZE_V2] = {
+			STLINK_DEBUG_COMMAND, STLINK_DEBUG_APIV2_GETLASTRWSTATUS
+		};
+		struct jtag_xfer transfers[4] = {
+			{ .ep = h->tx_ep, .buf = h->cmdbuf, .size = STLINK_CMD_SIZE_V2 },
+			{ .ep = h->direction, .buf = (uint8_t *)buf, .size = size },
+			{ .ep = h->tx_ep, .buf = status_cmd, .size = STLINK_CMD_SIZE_V2 },
+			{ .ep = h->rx_ep, .buf = h->rw_status, .size = 2 },
+		};
+
+		if (jtag_libusb_bulk_transfer_n(h->fd, transfers, 4,
+				STLINK_WRITE_TIMEOUT) != ERROR_OK)
+			return ERROR_FAIL;
+
+		for (unsigned int i = 0; i < ARRAY_SIZE(transfers); i++) {
+			if (transfers[i].transferred != transfers[i].size) {
+				LOG_DEBUG("bulk transfer %u short", i);
+				return ERROR_FAIL;
+			}
+		}
+
+		h->rw_status_valid = true;
+		return ERROR_OK;
+	}
+#endif
+
+	return stlink_usb_xfer(handle, buf, size);
+}
+
 /**
     Converts an STLINK status code held in the first byte of a response
     to an openocd error, logs any error/wait status as debug output.
@@ -588,6 +657,7 @@ static void stlink_usb_init_buffer(void *handle, uint8_t direction, uint32_t siz
 	struct stlink_usb_handle_s *h = handle;
 
 	h->direction = direction;
+	h->rw_status_valid = false;
 
 	h->cmdidx = 0;
 
@@ -1572,6 +1642,12 @@ static int stlink_usb_get_rw_status(void *handle)
 	if (h->jtag_api == STLINK_JTAG_API_V1)
 		return ERROR_OK;
 
+	if (h->rw_status_valid) {
+		h->rw_status_valid = false;
+		memcpy(h->databuf, h->rw_status, sizeof(h->rw_status));
+		return stlink_usb_error_check(h);
+	}
+
 	stlink_usb_init_buffer(handle, h->rx_ep, 2);
 
 	h->cmdbuf[h->cmdidx++] = STLINK_DEBUG_COMMAND;
@@ -1614,7 +1690,7 @@ static int stlink_usb_read_mem8(void *handle, uint32_t addr, uint16_t len,
 	if (read_len == 1)
 		read_len++;
 
-	res = stlink_usb_xfer(handle, h->databuf, read_len);
+	res = stlink_usb_xfer_mem(handle, h->databuf, read_len);
 
 	if (res != ERROR_OK)
 		return res;
@@ -1648,7 +1724,7 @@ static int stlink_usb_write_mem8(void *handle, uint32_t addr, uint16_t len,
 	h_u16_to_le(h->cmdbuf+h->cmdidx, len);
 	h->cmdidx += 2;
 
-	res = stlink_usb_xfer(handle, buffer, len);
+	res = stlink_usb_xfer_mem(handle, buffer, len);
 
 	if (res != ERROR_OK)
 		return res;
@@ -1680,7 +1756,7 @@ static int stlink_usb_read_mem32(void *handle, uint32_t addr, uint16_t len,
 	h_u16_to_le(h->cmdbuf+h->cmdidx, len);
 	h->cmdidx += 2;
 
-	res = stlink_usb_xfer(handle, h->databuf, len);
+	res = stlink_usb_xfer_mem(handle, h->databuf, len);
 
 	if (res != ERROR_OK)
 		return res;
@@ -1714,7 +1790,7 @@ static int stlink_usb_write_mem32(void *handle, uint32_t addr, uint16_t len,
 	h_u16_to_le(h->cmdbuf+h->cmdidx, len);
 	h->cmdidx += 2;
 
-	res = stlink_usb_xfer(handle, buffer, len);
+	res = stlink_usb_xfer_mem(handle, buffer, len);
 
 	if (res != ERROR_OK)
 		return res;
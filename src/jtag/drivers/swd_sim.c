@@ -0,0 +1,347 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+/*
+ * Simulated SWD adapter.
+ *
+ * Implements the swd_driver interface on top of the SW-DP, AHB-AP and
+ * Cortex-M model in dap_sim.c, with a memory map of RAM and read-only flash.
+ *
+ * Each run of the queue counts as one round trip to the adapter and each
+ * queued DP/AP access as one transaction. Both can be given a latency, so
+ * the effect of batching in the upper layers can be measured without a
+ * probe.
+ *
+ * Nothing in the tree runs it automatically; it is meant to be used by
+ * hand, with tcl/interface/swdsim.cfg and a target configuration.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <jtag/interface.h>
+#include <jtag/swd.h>
+#include <jtag/commands.h>
+#include <helper/time_support.h>
+#include <target/arm_adi_v5.h>
+
+#include "dap_sim.h"
+
+static struct {
+	/* the model, created by the first memory command or at init */
+	struct dap_sim *dap;
+	bool in_reset;
+
+	/* queue status, as in the other SWD drivers */
+	int queued_retval;
+
+	/* latency model, in microseconds */
+	uint32_t round_trip_us;
+	uint32_t transaction_us;
+
+	/* statistics */
+	uint64_t round_trips;
+	int64_t stats_start;
+} sim;
+
+/* one SWD packet */
+static void sim_transaction(uint8_t cmd, uint32_t *value)
+{
+	if (sim.queued_retval != ERROR_OK)
+		return;
+
+	if (sim.transaction_us)
+		jtag_sleep(sim.transaction_us);
+
+	if (dap_sim_transaction(sim.dap, cmd, value) != SWD_ACK_OK)
+		sim.queued_retval = ERROR_FAIL;
+}
+
+/* swd_driver */
+
+static int sim_swd_init(void)
+{
+	return ERROR_OK;
+}
+
+static int_least32_t sim_swd_frequency(int_least32_t hz)
+{
+	return hz < 0 ? 1000000 : hz;
+}
+
+static int sim_swd_switch_seq(enum swd_special_seq seq)
+{
+	switch (seq) {
+	case LINE_RESET:
+	case JTAG_TO_SWD:
+	case DORMANT_TO_SWD:
+		dap_sim_line_reset(sim.dap);
+		break;
+	case SWD_TO_JTAG:
+	case SWD_TO_DORMANT:
+		break;
+	default:
+		LOG_ERROR("Sequence %d not supported", seq);
+		return ERROR_FAIL;
+	}
+	return ERROR_OK;
+}
+
+static void sim_swd_read_reg(uint8_t cmd, uint32_t *value, uint32_t ap_delay_clk)
+{
+	assert(cmd & SWD_CMD_RnW);
+	sim_transaction(cmd, value);
+}
+
+static void sim_swd_write_reg(uint8_t cmd, uint32_t value, uint32_t ap_delay_clk)
+{
+	assert(!(cmd & SWD_CMD_RnW));
+	sim_transaction(cmd, &value);
+}
+
+static int sim_swd_run_queue(void)
+{
+	int retval = sim.queued_retval;
+
+	sim.round_trips++;
+	if (sim.round_trip_us)
+		jtag_sleep(sim.round_trip_us);
+
+	sim.queued_retval = ERROR_OK;
+	return retval;
+}
+
+static const struct swd_driver sim_swd_driver = {
+	.init = sim_swd_init,
+	.frequency = sim_swd_frequency,
+	.switch_seq = sim_swd_switch_seq,
+	.read_reg = sim_swd_read_reg,
+	.write_reg = sim_swd_write_reg,
+	.run = sim_swd_run_queue,
+};
+
+/* jtag_interface */
+
+static int sim_execute_queue(void)
+{
+	for (struct jtag_command *cmd = jtag_command_queue; cmd; cmd = cmd->next) {
+		switch (cmd->type) {
+		case JTAG_RESET:
+			if (cmd->cmd.reset->srst) {
+				sim.in_reset = true;
+			} else if (sim.in_reset) {
+				sim.in_reset = false;
+				dap_sim_reset(sim.dap);
+			}
+			break;
+		case JTAG_SLEEP:
+			jtag_sleep(cmd->cmd.sleep->us);
+			break;
+		default:
+			LOG_ERROR("BUG: unsupported JTAG command type 0x%X", cmd->type);
+			return ERROR_FAIL;
+		}
+	}
+
+	return ERROR_OK;
+}
+
+static int sim_add_region(uint32_t base, uint32_t size, bool read_only)
+{
+	if (sim.dap == NULL) {
+		sim.dap = dap_sim_new();
+		if (sim.dap == NULL) {
+			LOG_ERROR("Out of memory");
+			return ERROR_FAIL;
+		}
+	}
+
+	return dap_sim_add_region(sim.dap, base, size, read_only);
+}
+
+static int sim_init(void)
+{
+	int retval;
+
+	if (sim.dap == NULL || dap_sim_num_regions(sim.dap) == 0) {
+		retval = sim_add_region(0x08000000, 128 * 1024, true);
+		if (retval == ERROR_OK)
+			retval = sim_add_region(0x20000000, 64 * 1024, false);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	sim.stats_start = timeval_ms();
+	dap_sim_reset(sim.dap);
+
+	LOG_INFO("SWD simulator, %u memory region(s), round trip %" PRIu32 " us, "
+			"transaction %" PRIu32 " us", dap_sim_num_regions(sim.dap),
+			sim.round_trip_us, sim.transaction_us);
+
+	return ERROR_OK;
+}
+
+static int sim_quit(void)
+{
+	dap_sim_free(sim.dap);
+	sim.dap = NULL;
+
+	return ERROR_OK;
+}
+
+static int sim_speed(int speed)
+{
+	return ERROR_OK;
+}
+
+static int sim_khz(int khz, int *jtag_speed)
+{
+	*jtag_speed = khz;
+	return ERROR_OK;
+}
+
+static int sim_speed_div(int speed, int *khz)
+{
+	*khz = speed;
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(sim_handle_memory_command)
+{
+	uint32_t base, size;
+	bool read_only = false;
+
+	if (CMD_ARGC < 2 || CMD_ARGC > 3)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], base);
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], size);
+
+	if (CMD_ARGC == 3) {
+		if (strcmp(CMD_ARGV[2], "ro") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		read_only = true;
+	}
+
+	if (base % 4 || size % 4 || size == 0) {
+		command_print(CMD_CTX, "base and size must be non-zero multiples of 4");
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+
+	return sim_add_region(base, size, read_only);
+}
+
+COMMAND_HANDLER(sim_handle_latency_command)
+{
+	if (CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC > 0)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], sim.round_trip_us);
+	if (CMD_ARGC > 1)
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], sim.transaction_us);
+
+	command_print(CMD_CTX, "round trip %" PRIu32 " us, transaction %" PRIu32 " us",
+			sim.round_trip_us, sim.transaction_us);
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(sim_handle_stats_command)
+{
+	struct dap_sim_stats stats;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (sim.dap == NULL)
+		return ERROR_FAIL;
+
+	if (CMD_ARGC == 1) {
+		if (strcmp(CMD_ARGV[0], "reset") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		dap_sim_reset_stats(sim.dap);
+		sim.round_trips = 0;
+		sim.stats_start = timeval_ms();
+		return ERROR_OK;
+	}
+
+	dap_sim_get_stats(sim.dap, &stats);
+	command_print(CMD_CTX, "transactions %" PRIu64 " round_trips %" PRIu64
+			" ap_reads %" PRIu64 " ap_writes %" PRIu64 " faults %" PRIu64 " ms %" PRId64,
+			stats.transactions, sim.round_trips, stats.ap_reads, stats.ap_writes,
+			stats.faults, timeval_ms() - sim.stats_start);
+
+	if (sim.round_trips)
+		command_print(CMD_CTX, "%.2f transactions per round trip",
+				(double)stats.transactions / sim.round_trips);
+
+	return ERROR_OK;
+}
+
+static const struct command_registration sim_subcommand_handlers[] = {
+	{
+		.name = "memory",
+		.handler = &sim_handle_memory_command,
+		.mode = COMMAND_CONFIG,
+		.help = "add a simulated memory region; the first region holds "
+			"the vector table used on reset",
+		.usage = "base size ['ro']",
+	},
+	{
+		.name = "latency",
+		.handler = &sim_handle_latency_command,
+		.mode = COMMAND_ANY,
+		.help = "set or show the simulated latency per queue run "
+			"and per transaction in microseconds",
+		.usage = "[round_trip_us [transaction_us]]",
+	},
+	{
+		.name = "stats",
+		.handler = &sim_handle_stats_command,
+		.mode = COMMAND_EXEC,
+		.help = "show or reset the transaction and round trip counters",
+		.usage = "['reset']",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration sim_command_handlers[] = {
+	{
+		.name = "swdsim",
+		.mode = COMMAND_ANY,
+		.help = "simulated SWD adapter commands",
+		.usage = "",
+		.chain = sim_subcommand_handlers,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const char * const sim_transports[] = { "swd", NULL };
+
+struct jtag_interface swdsim_interface = {
+	.name = "swdsim",
+	.commands = sim_command_handlers,
+	.swd = &sim_swd_driver,
+	.transports = sim_transports,
+
+	.execute_queue = sim_execute_queue,
+	.speed = sim_speed,
+	.khz = sim_khz,
+	.speed_div = sim_speed_div,
+	.init = sim_init,
+	.quit = sim_quit,
+};
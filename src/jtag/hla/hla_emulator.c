@@ -0,0 +1,375 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+/*
+ * A software stand-in for an ST-Link with a Cortex-M attached. It speaks the
+ * hla_layout API without any USB device, so hla_target and the target code
+ * above it can be exercised on any host.
+ *
+ * It replaces stlink_usb.c as a whole: the ST-Link protocol and its USB
+ * transfers are not emulated, and the transaction counts and latency below
+ * are a rough model of one exchange per packet, not a measurement of them.
+ * In particular it says nothing about the batched transfers of stlink_usb.c.
+ * Nothing is executed either: run and halt only flip DHCSR, and a step just
+ * moves the PC over one instruction.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <jtag/interface.h>
+#include <helper/command.h>
+#include <target/target.h>
+#include <target/cortex_m.h>
+
+#include <jtag/hla/hla_layout.h>
+#include <jtag/hla/hla_transport.h>
+#include <jtag/hla/hla_interface.h>
+
+/* same as the ST-Link idcode of an STM32F1 SW-DP */
+#define EMU_IDCODE		0x1BA01477
+/* Cortex-M3 r1p1 */
+#define EMU_CPUID		0x411FC231
+
+/* bytes moved per emulated USB transaction, as stlink max_mem_packet */
+#define EMU_PACKET_SIZE		1024
+
+#define EMU_NUM_REGS		32
+
+struct emu_region {
+	const char *name;
+	uint32_t base;
+	uint32_t size;
+	uint8_t *data;
+};
+
+struct hla_emu_handle_s {
+	struct emu_region regions[3];
+	uint32_t regs[EMU_NUM_REGS];
+	bool halted;
+	/** emulated round trip latency per transaction in microseconds */
+	uint32_t latency_us;
+	/** statistics reported by the "stats" custom command */
+	uint64_t transactions;
+	uint64_t bytes_read;
+	uint64_t bytes_written;
+};
+
+static struct emu_region *hla_emu_find_region(struct hla_emu_handle_s *h,
+		uint32_t addr, uint32_t len)
+{
+	for (unsigned int i = 0; i < ARRAY_SIZE(h->regions); i++) {
+		struct emu_region *r = &h->regions[i];
+		if (addr >= r->base && len <= r->size && addr - r->base <= r->size - len)
+			return r;
+	}
+	return NULL;
+}
+
+/* account for one command/response exchange with the "adapter" */
+static void hla_emu_transaction(struct hla_emu_handle_s *h)
+{
+	h->transactions++;
+	if (h->latency_us)
+		jtag_sleep(h->latency_us);
+}
+
+static uint32_t hla_emu_get_u32(struct hla_emu_handle_s *h, uint32_t addr)
+{
+	struct emu_region *r = hla_emu_find_region(h, addr, 4);
+	if (r == NULL)
+		return 0;
+	return le_to_h_u32(r->data + addr - r->base);
+}
+
+static void hla_emu_set_u32(struct hla_emu_handle_s *h, uint32_t addr, uint32_t val)
+{
+	struct emu_region *r = hla_emu_find_region(h, addr, 4);
+	if (r != NULL)
+		h_u32_to_le(r->data + addr - r->base, val);
+}
+
+static void hla_emu_set_halted(struct hla_emu_handle_s *h, bool halted)
+{
+	uint32_t dhcsr = hla_emu_get_u32(h, DCB_DHCSR);
+
+	h->halted = halted;
+	if (halted)
+		dhcsr |= S_HALT | S_REGRDY;
+	else
+		dhcsr &= ~(S_HALT | S_REGRDY);
+	hla_emu_set_u32(h, DCB_DHCSR, dhcsr);
+}
+
+static int hla_emu_open(struct hl_interface_param_s *param, void **fd)
+{
+	struct hla_emu_handle_s *h = calloc(1, sizeof(*h));
+
+	if (h == NULL)
+		return ERROR_FAIL;
+
+	h->regions[0] = (struct emu_region) { "flash", 0x08000000, 128 * 1024, NULL };
+	h->regions[1] = (struct emu_region) { "sram", 0x20000000, 64 * 1024, NULL };
+	h->regions[2] = (struct emu_region) { "ppb", 0xE0000000, 64 * 1024, NULL };
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(h->regions); i++) {
+		h->regions[i].data = calloc(1, h->regions[i].size);
+		if (h->regions[i].data == NULL) {
+			while (i--)
+				free(h->regions[i].data);
+			free(h);
+			return ERROR_FAIL;
+		}
+	}
+
+	/* erased flash */
+	memset(h->regions[0].data, 0xff, h->regions[0].size);
+
+	hla_emu_set_u32(h, CPUID, EMU_CPUID);
+	hla_emu_set_halted(h, true);
+
+	LOG_INFO("emulated adapter, flash at 0x%08" PRIx32 ", sram at 0x%08" PRIx32,
+			h->regions[0].base, h->regions[1].base);
+
+	*fd = h;
+	return ERROR_OK;
+}
+
+static int hla_emu_close(void *handle)
+{
+	struct hla_emu_handle_s *h = handle;
+
+	if (h == NULL)
+		return ERROR_OK;
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(h->regions); i++)
+		free(h->regions[i].data);
+	free(h);
+
+	return ERROR_OK;
+}
+
+static int hla_emu_idcode(void *handle, uint32_t *idcode)
+{
+	hla_emu_transaction(handle);
+	*idcode = EMU_IDCODE;
+	return ERROR_OK;
+}
+
+static enum target_state hla_emu_state(void *handle)
+{
+	struct hla_emu_handle_s *h = handle;
+
+	hla_emu_transaction(h);
+	return h->halted ? TARGET_HALTED : TARGET_RUNNING;
+}
+
+static int hla_emu_reset(void *handle)
+{
+	struct hla_emu_handle_s *h = handle;
+
+	hla_emu_transaction(h);
+	memset(h->regs, 0, sizeof(h->regs));
+	/* initial SP and PC from the vector table at the start of flash */
+	h->regs[13] = hla_emu_get_u32(h, h->regions[0].base);
+	h->regs[15] = hla_emu_get_u32(h, h->regions[0].base + 4) & ~1;
+	h->regs[16] = 0x01000000;
+	return ERROR_OK;
+}
+
+static int hla_emu_assert_srst(void *handle, int srst)
+{
+	hla_emu_transaction(handle);
+	return ERROR_OK;
+}
+
+static int hla_emu_run(void *handle)
+{
+	hla_emu_transaction(handle);
+	hla_emu_set_halted(handle, false);
+	return ERROR_OK;
+}
+
+static int hla_emu_halt(void *handle)
+{
+	hla_emu_transaction(handle);
+	hla_emu_set_halted(handle, true);
+	return ERROR_OK;
+}
+
+static int hla_emu_step(void *handle)
+{
+	struct hla_emu_handle_s *h = handle;
+
+	hla_emu_transaction(h);
+	/* No instruction set model: the instruction isn't executed, the PC
+	 * only moves over it. A first halfword of 0b11101, 0b11110 or 0b11111
+	 * starts a 32 bit Thumb-2 instruction. */
+	uint32_t pc = h->regs[15];
+	struct emu_region *r = hla_emu_find_region(h, pc, 2);
+	uint16_t insn = r ? le_to_h_u16(r->data + pc - r->base) : 0;
+	h->regs[15] += (insn & 0xF800) >= 0xE800 ? 4 : 2;
+	hla_emu_set_halted(h, true);
+	return ERROR_OK;
+}
+
+static int hla_emu_read_regs(void *handle)
+{
+	hla_emu_transaction(handle);
+	return ERROR_OK;
+}
+
+static int hla_emu_read_reg(void *handle, int num, uint32_t *val)
+{
+	struct hla_emu_handle_s *h = handle;
+
+	if (num < 0 || num >= EMU_NUM_REGS)
+		return ERROR_FAIL;
+
+	hla_emu_transaction(h);
+	*val = h->regs[num];
+	return ERROR_OK;
+}
+
+static int hla_emu_write_reg(void *handle, int num, uint32_t val)
+{
+	struct hla_emu_handle_s *h = handle;
+
+	if (num < 0 || num >= EMU_NUM_REGS)
+		return ERROR_FAIL;
+
+	hla_emu_transaction(h);
+	h->regs[num] = val;
+	return ERROR_OK;
+}
+
+static int hla_emu_read_mem(void *handle, uint32_t addr, uint32_t size,
+		uint32_t count, uint8_t *buffer)
+{
+	struct hla_emu_handle_s *h = handle;
+	uint32_t len = size * count;
+	struct emu_region *r = hla_emu_find_region(h, addr, len);
+
+	if (r == NULL) {
+		LOG_DEBUG("read of unmapped memory at 0x%08" PRIx32, addr);
+		hla_emu_transaction(h);
+		return ERROR_FAIL;
+	}
+
+	for (uint32_t done = 0; done < len; done += EMU_PACKET_SIZE)
+		hla_emu_transaction(h);
+
+	memcpy(buffer, r->data + addr - r->base, len);
+	h->bytes_read += len;
+	return ERROR_OK;
+}
+
+static int hla_emu_write_mem(void *handle, uint32_t addr, uint32_t size,
+		uint32_t count, const uint8_t *buffer)
+{
+	struct hla_emu_handle_s *h = handle;
+	uint32_t len = size * count;
+	struct emu_region *r = hla_emu_find_region(h, addr, len);
+
+	if (r == NULL) {
+		LOG_DEBUG("write of unmapped memory at 0x%08" PRIx32, addr);
+		hla_emu_transaction(h);
+		return ERROR_FAIL;
+	}
+
+	for (uint32_t done = 0; done < len; done += EMU_PACKET_SIZE)
+		hla_emu_transaction(h);
+
+	uint32_t old_dhcsr = hla_emu_get_u32(h, DCB_DHCSR);
+
+	memcpy(r->data + addr - r->base, buffer, len);
+	h->bytes_written += len;
+
+	if (addr < DCB_DHCSR + 4 && addr + len > DCB_DHCSR) {
+		uint32_t dhcsr = hla_emu_get_u32(h, DCB_DHCSR);
+
+		/* the upper half reads as status, writes without the key are
+		 * ignored; only the control bits are kept */
+		if ((dhcsr & 0xFFFF0000) != DBGKEY)
+			dhcsr = old_dhcsr;
+		hla_emu_set_u32(h, DCB_DHCSR, dhcsr & 0xFFFF);
+		hla_emu_set_halted(h, (dhcsr & C_HALT) != 0);
+	}
+
+	return ERROR_OK;
+}
+
+static int hla_emu_write_debug_reg(void *handle, uint32_t addr, uint32_t val)
+{
+	uint8_t buf[4];
+
+	h_u32_to_le(buf, val);
+	return hla_emu_write_mem(handle, addr, 4, 1, buf);
+}
+
+static int hla_emu_speed(void *handle, int khz, bool query)
+{
+	return khz;
+}
+
+static int hla_emu_custom_command(void *handle, const char *command)
+{
+	struct hla_emu_handle_s *h = handle;
+	unsigned int latency;
+
+	if (sscanf(command, "latency %u", &latency) == 1) {
+		h->latency_us = latency;
+		LOG_INFO("emulated round trip latency %" PRIu32 " us", h->latency_us);
+		return ERROR_OK;
+	}
+
+	if (strcmp(command, "stats") == 0) {
+		LOG_INFO("%" PRIu64 " transactions, %" PRIu64 " bytes read, %" PRIu64
+				" bytes written", h->transactions, h->bytes_read, h->bytes_written);
+		return ERROR_OK;
+	}
+
+	if (strcmp(command, "reset_stats") == 0) {
+		h->transactions = 0;
+		h->bytes_read = 0;
+		h->bytes_written = 0;
+		return ERROR_OK;
+	}
+
+	LOG_ERROR("unknown emulator command '%s', expected 'latency <us>', "
+			"'stats' or 'reset_stats'", command);
+	return ERROR_COMMAND_SYNTAX_ERROR;
+}
+
+struct hl_layout_api_s hla_emulator_layout_api = {
+	.open = hla_emu_open,
+	.close = hla_emu_close,
+	.idcode = hla_emu_idcode,
+	.state = hla_emu_state,
+	.reset = hla_emu_reset,
+	.assert_srst = hla_emu_assert_srst,
+	.run = hla_emu_run,
+	.halt = hla_emu_halt,
+	.step = hla_emu_step,
+	.read_regs = hla_emu_read_regs,
+	.read_reg = hla_emu_read_reg,
+	.write_reg = hla_emu_write_reg,
+	.read_mem = hla_emu_read_mem,
+	.write_mem = hla_emu_write_mem,
+	.write_debug_reg = hla_emu_write_debug_reg,
+	.speed = hla_emu_speed,
+	.custom_command = hla_emu_custom_command,
+};
@@ -304,6 +304,61 @@ COMMAND_HANDLER(interface_handle_hla_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(interface_handle_hla_bench_command)
+{
+	uint32_t address, length;
+	int64_t start, read_ms, write_ms = 0;
+	uint8_t *buffer;
+	int retval;
+
+	if (CMD_ARGC != 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], address);
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], length);
+
+	if (address % 4 || length % 4 || length == 0) {
+		LOG_ERROR("address and length must be non-zero multiples of 4");
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+
+	if (hl_if.handle == NULL) {
+		LOG_ERROR("adapter not initialized");
+		return ERROR_FAIL;
+	}
+
+	buffer = malloc(length);
+	if (buffer == NULL) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
+
+	/* read the area, then write the same data back so it is left intact */
+	start = timeval_ms();
+	retval = hl_if.layout->api->read_mem(hl_if.handle, address, 4, length / 4, buffer);
+	read_ms = timeval_ms() - start;
+
+	if (retval == ERROR_OK) {
+		start = timeval_ms();
+		retval = hl_if.layout->api->write_mem(hl_if.handle, address, 4, length / 4, buffer);
+		write_ms = timeval_ms() - start;
+	}
+
+	free(buffer);
+
+	if (retval != ERROR_OK) {
+		LOG_ERROR("memory access at 0x%08" PRIx32 " failed", address);
+		return retval;
+	}
+
+	command_print(CMD_CTX, "read %" PRIu32 " bytes in %" PRId64 " ms (%.3f KiB/s)",
+			length, read_ms, length / 1.024 / (read_ms ? read_ms : 1));
+	command_print(CMD_CTX, "wrote %" PRIu32 " bytes in %" PRId64 " ms (%.3f KiB/s)",
+			length, write_ms, length / 1.024 / (write_ms ? write_ms : 1));
+
+	return ERROR_OK;
+}
+
 static const struct command_registration hl_interface_command_handlers[] = {
 	{
 	 .name = "hla_device_desc",
@@ -340,6 +395,14 @@ static const struct command_registration hl_interface_command_handlers[] = {
 	 .help = "execute a custom adapter-specific command",
 	 .usage = "hla_command <command>",
 	 },
+	{
+	 .name = "hla_bench",
+	 .handler = &interface_handle_hla_bench_command,
+	 .mode = COMMAND_EXEC,
+	 .help = "measure adapter memory read and write throughput; "
+		"the memory content is read and written back unchanged",
+	 .usage = "address length",
+	 },
 	COMMAND_REGISTRATION_DONE
 };
 
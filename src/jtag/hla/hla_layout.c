@@ -69,6 +69,12 @@ static const struct hl_layout hl_layouts[] = {
 	 .close = hl_layout_close,
 	 .api = &icdi_usb_layout_api,
 	},
+	{
+	 .name = "emulator",
+	 .open = hl_layout_open,
+	 .close = hl_layout_close,
+	 .api = &hla_emulator_layout_api,
+	},
 	{.name = NULL, /* END OF TABLE */ },
 };
 
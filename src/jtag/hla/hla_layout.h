@@ -31,6 +31,7 @@ struct hl_interface_param_s;
 /** */
 extern struct hl_layout_api_s stlink_usb_layout_api;
 extern struct hl_layout_api_s icdi_usb_layout_api;
+extern struct hl_layout_api_s hla_emulator_layout_api;
 
 /** */
 struct hl_layout_api_s {
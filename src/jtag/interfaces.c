@@ -51,6 +51,9 @@ extern struct jtag_interface parport_interface;
 #if BUILD_DUMMY == 1
 extern struct jtag_interface dummy_interface;
 #endif
+#if BUILD_SWDSIM == 1
+extern struct jtag_interface swdsim_interface;
+#endif
 #if BUILD_FTDI == 1
 extern struct jtag_interface ftdi_interface;
 #endif
@@ -150,6 +153,9 @@ struct jtag_interface *jtag_interfaces[] = {
 #if BUILD_DUMMY == 1
 		&dummy_interface,
 #endif
+#if BUILD_SWDSIM == 1
+		&swdsim_interface,
+#endif
 #if BUILD_FTDI == 1
 		&ftdi_interface,
 #endif
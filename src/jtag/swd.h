@@ -193,6 +193,14 @@ struct swd_driver {
 	 */
 	int (*run)(void);
 
+	/**
+	 * Optional: report how many transactions the driver can queue
+	 * before it has to run the queue on its own.
+	 *
+	 * @return The queue depth, or 0 if there is no fixed limit.
+	 */
+	unsigned int (*queue_size)(void);
+
 	/**
 	 * Configures data collection from the Single-wire
 	 * trace (SWO) signal.
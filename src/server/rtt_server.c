@@ -0,0 +1,225 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "rtt_server.h"
+#include <target/rtt.h>
+
+/**
+ * @file
+ * Serves RTT channels over TCP: data drained from an up channel is
+ * forwarded unmodified to every client connected to the channel's port,
+ * data received from a client is written to the down channel with the
+ * same index.
+ *
+ * A client is only read from once its previous data fitted into the
+ * down buffer, so TCP flow control throttles clients that send faster
+ * than the target consumes. Data left over is retried on every RTT poll.
+ * Without RTT running there is no down buffer, and client data is
+ * dropped right away, so a client is never left paused.
+ */
+
+#define RTT_SERVER_BUFFER_SIZE	1024
+
+struct rtt_service {
+	unsigned int channel;
+};
+
+struct rtt_connection {
+	uint8_t buffer[RTT_SERVER_BUFFER_SIZE];
+	size_t length;
+};
+
+static int rtt_connection_write(unsigned int channel, const uint8_t *buf,
+		size_t length, void *priv)
+{
+	struct connection *connection = priv;
+
+	if (connection_write(connection, buf, length) != (int)length)
+		LOG_DEBUG("rtt: dropped data for a '%s' client", connection->service->name);
+
+	return ERROR_OK;
+}
+
+/* Write pending client data to the down channel, keep what did not fit. */
+static void rtt_flush_connection(struct connection *connection)
+{
+	struct rtt_service *service = connection->service->priv;
+	struct rtt_connection *rtt_connection = connection->priv;
+
+	size_t length = rtt_connection->length;
+	if (rtt_write_channel(service->channel, rtt_connection->buffer, &length) != ERROR_OK) {
+		LOG_DEBUG("rtt: no down channel %u, dropped %zu bytes", service->channel,
+				rtt_connection->length);
+		length = rtt_connection->length;
+	}
+
+	rtt_connection->length -= length;
+	memmove(rtt_connection->buffer, rtt_connection->buffer + length, rtt_connection->length);
+
+	/* leave further data in the socket until the rest went out from the
+	 * RTT poll, rather than retrying from every server loop iteration */
+	connection->input_paused = rtt_connection->length != 0;
+}
+
+static void rtt_connection_poll(unsigned int channel, void *priv)
+{
+	struct connection *connection = priv;
+	struct rtt_connection *rtt_connection = connection->priv;
+
+	if (rtt_connection->length != 0)
+		rtt_flush_connection(connection);
+}
+
+static int rtt_new_connection(struct connection *connection)
+{
+	struct rtt_service *service = connection->service->priv;
+
+	LOG_DEBUG("rtt: new connection for channel %u", service->channel);
+
+	struct rtt_connection *rtt_connection = malloc(sizeof(*rtt_connection));
+	if (rtt_connection == NULL) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
+	rtt_connection->length = 0;
+	connection->priv = rtt_connection;
+
+	int retval = rtt_register_sink(service->channel, rtt_connection_write,
+			rtt_connection_poll, connection);
+	if (retval != ERROR_OK) {
+		free(rtt_connection);
+		connection->priv = NULL;
+	}
+
+	return retval;
+}
+
+static int rtt_connection_closed(struct connection *connection)
+{
+	struct rtt_service *service = connection->service->priv;
+
+	LOG_DEBUG("rtt: connection for channel %u closed", service->channel);
+
+	free(connection->priv);
+	connection->priv = NULL;
+
+	return rtt_unregister_sink(service->channel, rtt_connection_write, connection);
+}
+
+static int rtt_input(struct connection *connection)
+{
+	struct rtt_connection *rtt_connection = connection->priv;
+
+	if (rtt_connection->length == 0) {
+		int length = connection_read(connection, rtt_connection->buffer,
+				sizeof(rtt_connection->buffer));
+		if (length == 0)
+			return ERROR_SERVER_REMOTE_CLOSED;
+		if (length < 0) {
+			LOG_ERROR("error during read: %s", strerror(errno));
+			return ERROR_SERVER_REMOTE_CLOSED;
+		}
+		rtt_connection->length = length;
+	}
+
+	rtt_flush_connection(connection);
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_rtt_server_start_command)
+{
+	if (CMD_ARGC != 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	unsigned int channel;
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[1], channel);
+
+	struct rtt_service *service = malloc(sizeof(*service));
+	if (service == NULL) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
+	service->channel = channel;
+
+	int retval = add_service("rtt", CMD_ARGV[0], CONNECTION_LIMIT_UNLIMITED,
+			rtt_new_connection, rtt_input, rtt_connection_closed, service);
+	if (retval != ERROR_OK)
+		free(service);
+
+	return retval;
+}
+
+COMMAND_HANDLER(handle_rtt_server_stop_command)
+{
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (remove_service("rtt", CMD_ARGV[0]) != ERROR_OK) {
+		command_print(CMD_CTX, "no rtt server on port %s", CMD_ARGV[0]);
+		return ERROR_FAIL;
+	}
+
+	return ERROR_OK;
+}
+
+static const struct command_registration rtt_server_subcommand_handlers[] = {
+	{
+		.name = "start",
+		.handler = handle_rtt_server_start_command,
+		.mode = COMMAND_ANY,
+		.help = "serve an RTT channel on a TCP port",
+		.usage = "port channel",
+	},
+	{
+		.name = "stop",
+		.handler = handle_rtt_server_stop_command,
+		.mode = COMMAND_ANY,
+		.help = "stop serving the RTT channel on a TCP port",
+		.usage = "port",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration rtt_server_command_handlers[] = {
+	{
+		.name = "server",
+		.mode = COMMAND_ANY,
+		.help = "RTT server commands",
+		.usage = "",
+		.chain = rtt_server_subcommand_handlers,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration rtt_command_handlers[] = {
+	{
+		.name = "rtt",
+		.mode = COMMAND_ANY,
+		.help = "RTT ring buffer channel commands",
+		.usage = "",
+		.chain = rtt_server_command_handlers,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+int rtt_server_register_commands(struct command_context *cmd_ctx)
+{
+	return register_commands(cmd_ctx, NULL, rtt_command_handlers);
+}
@@ -29,10 +29,12 @@
 #include "server.h"
 #include <target/target.h>
 #include <target/target_request.h>
+#include <target/rtt.h>
 #include <target/openrisc/jsp_server.h>
 #include "openocd.h"
 #include "tcl_server.h"
 #include "telnet_server.h"
+#include "rtt_server.h"
 
 #include <signal.h>
 
@@ -73,6 +75,7 @@ static int add_connection(struct service *service, struct command_context *cmd_c
 	c->cmd_ctx = copy_command_context(cmd_ctx);
 	c->service = service;
 	c->input_pending = 0;
+	c->input_paused = false;
 	c->priv = NULL;
 	c->next = NULL;
 
@@ -344,6 +347,34 @@ int add_service(char *name,
 	return ERROR_OK;
 }
 
+int remove_service(const char *name, const char *port)
+{
+	struct service **p;
+
+	for (p = &services; *p; p = &(*p)->next) {
+		struct service *c = *p;
+
+		if (strcmp(c->name, name) || strcmp(c->port, port))
+			continue;
+
+		while (c->connections)
+			remove_connection(c, c->connections);
+
+		if (c->type == CONNECTION_TCP && c->fd != -1)
+			close_socket(c->fd);
+		else if (c->type == CONNECTION_PIPE && c->fd != -1)
+			close(c->fd);
+
+		*p = c->next;
+		free(c->priv);
+		free_service(c);
+
+		return ERROR_OK;
+	}
+
+	return ERROR_FAIL;
+}
+
 static int remove_services(void)
 {
 	struct service *c = services;
@@ -414,6 +445,9 @@ int server_loop(struct command_context *command_context)
 				struct connection *c;
 
 				for (c = service->connections; c; c = c->next) {
+					if (c->input_paused)
+						continue;
+
 					/* check for activity on the connection */
 					FD_SET(c->fd, &read_fds);
 					if (c->fd > fd_max)
@@ -435,6 +469,7 @@ int server_loop(struct command_context *command_context)
 			/* Only while we're sleeping we'll let others run */
 			openocd_sleep_prelude();
 			kept_alive();
+			log_flush();
 			retval = socket_select(fd_max + 1, &read_fds, NULL, NULL, &tv);
 			openocd_sleep_postlude();
 		}
@@ -480,9 +515,9 @@ int server_loop(struct command_context *command_context)
 		/* This is a simple back-off algorithm where we immediately
 		 * re-poll if we did something this time around.
 		 *
-		 * This greatly improves performance of DCC.
+		 * This greatly improves performance of DCC and RTT.
 		 */
-		poll_ok = poll_ok || target_got_message();
+		poll_ok = poll_ok || target_got_message() || rtt_got_data();
 
 		for (service = services; service; service = service->next) {
 			/* handle new connections on listeners */
@@ -737,6 +772,10 @@ int server_register_commands(struct command_context *cmd_ctx)
 	if (ERROR_OK != retval)
 		return retval;
 
+	retval = rtt_server_register_commands(cmd_ctx);
+	if (ERROR_OK != retval)
+		return retval;
+
 	return register_commands(cmd_ctx, NULL, server_command_handlers);
 }
 
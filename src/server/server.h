@@ -46,6 +46,8 @@ struct connection {
 	struct command_context *cmd_ctx;
 	struct service *service;
 	int input_pending;
+	/* not read from while set, e.g. while the service can take no input */
+	bool input_paused;
 	void *priv;
 	struct connection *next;
 };
@@ -74,6 +76,7 @@ int add_service(char *name, const char *port,
 		int max_connections, new_connection_handler_t new_connection_handler,
 		input_handler_t in_handler, connection_closed_handler_t close_handler,
 		void *priv);
+int remove_service(const char *name, const char *port);
 
 int server_preinit(void);
 int server_init(struct command_context *cmd_ctx);
@@ -1739,6 +1739,111 @@ static int aarch64_write_cpu_memory_slow(struct target *target,
 	return ERROR_OK;
 }
 
+/* Load X0, or R0 in AArch32 state, with the address of a memory access. */
+static int aarch64_set_address_reg(struct target *target, uint64_t address)
+{
+	struct armv8_common *armv8 = target_to_armv8(target);
+	struct arm_dpm *dpm = &armv8->dpm;
+
+	if (armv8->arm.core_state == ARM_STATE_AARCH64)
+		return dpm->instr_write_data_dcc_64(dpm,
+				ARMV8_MRS(SYSTEM_DBG_DBGDTR_EL0, 0), address);
+	else
+		return dpm->instr_write_data_dcc(dpm,
+				ARMV4_5_MRC(14, 0, 0, 0, 5, 0), address);
+}
+
+static int aarch64_write_cpu_memory_pipelined(struct target *target,
+	uint64_t address, uint32_t size, uint32_t count, const uint8_t *buffer,
+	uint32_t *dscr)
+{
+	/* Like aarch64_write_cpu_memory_slow, but the transactions for a batch
+	 * of objects are queued and run at once instead of waiting for every
+	 * instruction to complete. ARMv8 has no DCC stall mode; if the core
+	 * falls behind the debug link EDSCR reports an ITR or DTRRX overrun,
+	 * and the batch is redone with the polled path from its start address.
+	 * Address must be in X0/R0.
+	 */
+	struct armv8_common *armv8 = target_to_armv8(target);
+	struct arm_dpm *dpm = &armv8->dpm;
+	struct arm *arm = &armv8->arm;
+	uint32_t move, store;
+	int retval;
+
+	armv8_reg_current(arm, 1)->dirty = true;
+
+	if (size == 1)
+		store = armv8_opcode(armv8, ARMV8_OPC_STRB_IP);
+	else if (size == 2)
+		store = armv8_opcode(armv8, ARMV8_OPC_STRH_IP);
+	else
+		store = armv8_opcode(armv8, ARMV8_OPC_STRW_IP);
+	if (arm->core_state == ARM_STATE_AARCH64)
+		move = ARMV8_MRS(SYSTEM_DBG_DTRRX_EL0, 1);
+	else
+		move = ARMV4_5_MRC(14, 0, 1, 0, 5, 0);
+	if (armv8_dpm_get_core_state(dpm) != ARM_STATE_AARCH64) {
+		store = T32_FMTITR(store);
+		move = T32_FMTITR(move);
+	}
+
+	while (count) {
+		uint32_t batch = MIN(count, AARCH64_DCC_BATCH);
+		const uint8_t *p = buffer;
+
+		for (uint32_t i = 0; i < batch; i++) {
+			uint32_t data;
+
+			if (size == 1)
+				data = *p;
+			else if (size == 2)
+				data = target_buffer_get_u16(target, p);
+			else
+				data = target_buffer_get_u32(target, p);
+			retval = mem_ap_write_u32(armv8->debug_ap,
+					armv8->debug_base + CPUV8_DBG_DTRRX, data);
+			if (retval == ERROR_OK)
+				retval = mem_ap_write_u32(armv8->debug_ap,
+						armv8->debug_base + CPUV8_DBG_ITR, move);
+			if (retval == ERROR_OK)
+				retval = mem_ap_write_u32(armv8->debug_ap,
+						armv8->debug_base + CPUV8_DBG_ITR, store);
+			if (retval != ERROR_OK)
+				return retval;
+			p += size;
+		}
+
+		retval = mem_ap_read_u32(armv8->debug_ap,
+				armv8->debug_base + CPUV8_DBG_DSCR, dscr);
+		if (retval == ERROR_OK)
+			retval = dap_run(armv8->debug_ap->dap);
+		if (retval != ERROR_OK)
+			return retval;
+
+		if (*dscr & (DSCR_ITO | DSCR_RTO)) {
+			LOG_DEBUG("DCC overrun, dscr = 0x%08" PRIx32 ", redoing %" PRIu32 " objects",
+					*dscr, batch);
+			retval = mem_ap_write_atomic_u32(armv8->debug_ap,
+					armv8->debug_base + CPUV8_DBG_DRCR, DRCR_CSE);
+			if (retval == ERROR_OK)
+				retval = aarch64_set_address_reg(target, address);
+			if (retval == ERROR_OK)
+				retval = aarch64_write_cpu_memory_slow(target, size, batch, buffer, dscr);
+			if (retval != ERROR_OK)
+				return retval;
+		} else if (*dscr & DSCR_ERR) {
+			/* a fault, reported by the caller */
+			return ERROR_OK;
+		}
+
+		buffer += batch * size;
+		address += batch * size;
+		count -= batch;
+	}
+
+	return ERROR_OK;
+}
+
 static int aarch64_write_cpu_memory_fast(struct target *target,
 	uint32_t count, const uint8_t *buffer, uint32_t *dscr)
 {
@@ -1778,6 +1883,7 @@ static int aarch64_write_cpu_memory(struct target *target,
 {
 	/* write memory through APB-AP */
 	int retval = ERROR_COMMAND_SYNTAX_ERROR;
+	struct aarch64_common *aarch64 = target_to_aarch64(target);
 	struct armv8_common *armv8 = target_to_armv8(target);
 	struct arm_dpm *dpm = &armv8->dpm;
 	struct arm *arm = &armv8->arm;
@@ -1808,22 +1914,14 @@ static int aarch64_write_cpu_memory(struct target *target,
 	retval = mem_ap_write_atomic_u32(armv8->debug_ap,
 			armv8->debug_base + CPUV8_DBG_DSCR, dscr);
 
-	if (arm->core_state == ARM_STATE_AARCH64) {
-		/* Write X0 with value 'address' using write procedure */
-		/* Step 1.a+b - Write the address for read access into DBGDTR_EL0 */
-		/* Step 1.c   - Copy value from DTR to R0 using instruction mrs DBGDTR_EL0, x0 */
-		retval = dpm->instr_write_data_dcc_64(dpm,
-				ARMV8_MRS(SYSTEM_DBG_DBGDTR_EL0, 0), address);
-	} else {
-		/* Write R0 with value 'address' using write procedure */
-		/* Step 1.a+b - Write the address for read access into DBGDTRRX */
-		/* Step 1.c   - Copy value from DTR to R0 using instruction mrc DBGDTRTXint, r0 */
-		dpm->instr_write_data_dcc(dpm,
-				ARMV4_5_MRC(14, 0, 0, 0, 5, 0), address);
-	}
+	/* Step 1.a+b - Write the address for write access into DBGDTR_EL0/DBGDTRRX */
+	/* Step 1.c   - Copy value from DTR to X0/R0 */
+	retval = aarch64_set_address_reg(target, address);
 
 	if (size == 4 && (address % 4) == 0)
 		retval = aarch64_write_cpu_memory_fast(target, count, buffer, &dscr);
+	else if (aarch64->dcc_pipeline_mode == AARCH64_DCC_PIPELINE_ON)
+		retval = aarch64_write_cpu_memory_pipelined(target, address, size, count, buffer, &dscr);
 	else
 		retval = aarch64_write_cpu_memory_slow(target, size, count, buffer, &dscr);
 
@@ -1913,6 +2011,95 @@ static int aarch64_read_cpu_memory_slow(struct target *target,
 	return ERROR_OK;
 }
 
+static int aarch64_read_cpu_memory_pipelined(struct target *target,
+	uint64_t address, uint32_t size, uint32_t count, uint8_t *buffer,
+	uint32_t *dscr)
+{
+	/* Like aarch64_read_cpu_memory_slow, but pipelined the same way as
+	 * aarch64_write_cpu_memory_pipelined. After a DTRTX underrun or ITR
+	 * overrun the rest of the transfer, starting with the failed batch,
+	 * is read with the polled path.
+	 * Address must be in X0/R0.
+	 */
+	struct armv8_common *armv8 = target_to_armv8(target);
+	struct arm_dpm *dpm = &armv8->dpm;
+	struct arm *arm = &armv8->arm;
+	uint32_t data[AARCH64_DCC_BATCH];
+	uint32_t load, move;
+	int retval;
+
+	armv8_reg_current(arm, 1)->dirty = true;
+
+	if (size == 1)
+		load = armv8_opcode(armv8, ARMV8_OPC_LDRB_IP);
+	else if (size == 2)
+		load = armv8_opcode(armv8, ARMV8_OPC_LDRH_IP);
+	else
+		load = armv8_opcode(armv8, ARMV8_OPC_LDRW_IP);
+	if (arm->core_state == ARM_STATE_AARCH64)
+		move = ARMV8_MSR_GP(SYSTEM_DBG_DTRTX_EL0, 1);
+	else
+		move = ARMV4_5_MCR(14, 0, 1, 0, 5, 0);
+	if (armv8_dpm_get_core_state(dpm) != ARM_STATE_AARCH64) {
+		load = T32_FMTITR(load);
+		move = T32_FMTITR(move);
+	}
+
+	while (count) {
+		uint32_t batch = MIN(count, AARCH64_DCC_BATCH);
+
+		for (uint32_t i = 0; i < batch; i++) {
+			retval = mem_ap_write_u32(armv8->debug_ap,
+					armv8->debug_base + CPUV8_DBG_ITR, load);
+			if (retval == ERROR_OK)
+				retval = mem_ap_write_u32(armv8->debug_ap,
+						armv8->debug_base + CPUV8_DBG_ITR, move);
+			if (retval == ERROR_OK)
+				retval = mem_ap_read_u32(armv8->debug_ap,
+						armv8->debug_base + CPUV8_DBG_DTRTX, &data[i]);
+			if (retval != ERROR_OK)
+				return retval;
+		}
+
+		retval = mem_ap_read_u32(armv8->debug_ap,
+				armv8->debug_base + CPUV8_DBG_DSCR, dscr);
+		if (retval == ERROR_OK)
+			retval = dap_run(armv8->debug_ap->dap);
+		if (retval != ERROR_OK)
+			return retval;
+
+		if (*dscr & (DSCR_ITO | DSCR_TXU)) {
+			LOG_DEBUG("DCC underrun, dscr = 0x%08" PRIx32 ", reading the last %" PRIu32
+					" objects without pipelining", *dscr, count);
+			retval = mem_ap_write_atomic_u32(armv8->debug_ap,
+					armv8->debug_base + CPUV8_DBG_DRCR, DRCR_CSE);
+			if (retval == ERROR_OK)
+				retval = aarch64_set_address_reg(target, address);
+			if (retval == ERROR_OK)
+				retval = aarch64_read_cpu_memory_slow(target, size, count, buffer, dscr);
+			return retval;
+		} else if (*dscr & DSCR_ERR) {
+			/* a fault, reported by the caller */
+			return ERROR_OK;
+		}
+
+		for (uint32_t i = 0; i < batch; i++) {
+			if (size == 1)
+				*buffer = (uint8_t)data[i];
+			else if (size == 2)
+				target_buffer_set_u16(target, buffer, (uint16_t)data[i]);
+			else
+				target_buffer_set_u32(target, buffer, data[i]);
+			buffer += size;
+		}
+
+		address += batch * size;
+		count -= batch;
+	}
+
+	return ERROR_OK;
+}
+
 static int aarch64_read_cpu_memory_fast(struct target *target,
 	uint32_t count, uint8_t *buffer, uint32_t *dscr)
 {
@@ -1980,6 +2167,7 @@ static int aarch64_read_cpu_memory(struct target *target,
 {
 	/* read memory through APB-AP */
 	int retval = ERROR_COMMAND_SYNTAX_ERROR;
+	struct aarch64_common *aarch64 = target_to_aarch64(target);
 	struct armv8_common *armv8 = target_to_armv8(target);
 	struct arm_dpm *dpm = &armv8->dpm;
 	struct arm *arm = &armv8->arm;
@@ -2011,22 +2199,14 @@ static int aarch64_read_cpu_memory(struct target *target,
 	retval +=  mem_ap_write_atomic_u32(armv8->debug_ap,
 			armv8->debug_base + CPUV8_DBG_DSCR, dscr);
 
-	if (arm->core_state == ARM_STATE_AARCH64) {
-		/* Write X0 with value 'address' using write procedure */
-		/* Step 1.a+b - Write the address for read access into DBGDTR_EL0 */
-		/* Step 1.c   - Copy value from DTR to R0 using instruction mrs DBGDTR_EL0, x0 */
-		retval += dpm->instr_write_data_dcc_64(dpm,
-				ARMV8_MRS(SYSTEM_DBG_DBGDTR_EL0, 0), address);
-	} else {
-		/* Write R0 with value 'address' using write procedure */
-		/* Step 1.a+b - Write the address for read access into DBGDTRRXint */
-		/* Step 1.c   - Copy value from DTR to R0 using instruction mrc DBGDTRTXint, r0 */
-		retval += dpm->instr_write_data_dcc(dpm,
-				ARMV4_5_MRC(14, 0, 0, 0, 5, 0), address);
-	}
+	/* Step 1.a+b - Write the address for read access into DBGDTR_EL0/DBGDTRRXint */
+	/* Step 1.c   - Copy value from DTR to X0/R0 */
+	retval += aarch64_set_address_reg(target, address);
 
 	if (size == 4 && (address % 4) == 0)
 		retval = aarch64_read_cpu_memory_fast(target, count, buffer, &dscr);
+	else if (aarch64->dcc_pipeline_mode == AARCH64_DCC_PIPELINE_ON)
+		retval = aarch64_read_cpu_memory_pipelined(target, address, size, count, buffer, &dscr);
 	else
 		retval = aarch64_read_cpu_memory_slow(target, size, count, buffer, &dscr);
 
@@ -2345,6 +2525,8 @@ static int aarch64_init_arch_info(struct target *target,
 	armv8->pre_restore_context = NULL;
 	armv8->armv8_mmu.read_physical_memory = aarch64_read_phys_memory;
 
+	aarch64->dcc_pipeline_mode = AARCH64_DCC_PIPELINE_OFF;
+
 	armv8_init_arch_info(target, armv8);
 	target_register_timer_callback(aarch64_handle_target_request, 1, 1, target);
 
@@ -2460,6 +2642,34 @@ COMMAND_HANDLER(aarch64_mask_interrupts_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(aarch64_dcc_pipeline_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct aarch64_common *aarch64 = target_to_aarch64(target);
+
+	static const Jim_Nvp nvp_dcc_pipeline_modes[] = {
+		{ .name = "off", .value = AARCH64_DCC_PIPELINE_OFF },
+		{ .name = "on", .value = AARCH64_DCC_PIPELINE_ON },
+		{ .name = NULL, .value = -1 },
+	};
+	const Jim_Nvp *n;
+
+	if (CMD_ARGC > 0) {
+		n = Jim_Nvp_name2value_simple(nvp_dcc_pipeline_modes, CMD_ARGV[0]);
+		if (n->name == NULL) {
+			LOG_ERROR("Unknown parameter: %s - should be off or on", CMD_ARGV[0]);
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		}
+
+		aarch64->dcc_pipeline_mode = n->value;
+	}
+
+	n = Jim_Nvp_value2name_simple(nvp_dcc_pipeline_modes, aarch64->dcc_pipeline_mode);
+	command_print(CMD_CTX, "aarch64 DCC pipeline %s", n->name);
+
+	return ERROR_OK;
+}
+
 static const struct command_registration aarch64_exec_command_handlers[] = {
 	{
 		.name = "cache_info",
@@ -2495,6 +2705,14 @@ static const struct command_registration aarch64_exec_command_handlers[] = {
 		.help = "mask aarch64 interrupts during single-step",
 		.usage = "['on'|'off']",
 	},
+	{
+		.name = "dcc_pipeline",
+		.handler = aarch64_dcc_pipeline_command,
+		.mode = COMMAND_ANY,
+		.help = "queue byte and halfword memory accesses through "
+			"the CPU without polling after each instruction",
+		.usage = "['on'|'off']",
+	},
 
 	COMMAND_REGISTRATION_DONE
 };
@@ -36,11 +36,19 @@
 
 #define AARCH64_PADDRDBG_CPU_SHIFT 13
 
+/* objects moved per DAP run by the pipelined DCC memory accesses */
+#define AARCH64_DCC_BATCH 256
+
 enum aarch64_isrmasking_mode {
 	AARCH64_ISRMASK_OFF,
 	AARCH64_ISRMASK_ON,
 };
 
+enum aarch64_dcc_pipeline_mode {
+	AARCH64_DCC_PIPELINE_OFF,
+	AARCH64_DCC_PIPELINE_ON,
+};
+
 struct aarch64_brp {
 	int used;
 	int type;
@@ -65,6 +73,8 @@ struct aarch64_common {
 	struct armv8_common armv8_common;
 
 	enum aarch64_isrmasking_mode isrmasking_mode;
+	/* Queue non-word memory accesses through the CPU */
+	enum aarch64_dcc_pipeline_mode dcc_pipeline_mode;
 };
 
 static inline struct aarch64_common *
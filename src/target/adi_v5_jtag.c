@@ -153,14 +153,26 @@ static void log_dap_cmd(const char *header, struct dap_cmd *el)
 #endif
 }
 
-static struct dap_cmd *dap_cmd_new(uint8_t instr,
+/* Journal entries released by flush_journal() are kept for reuse, up to
+ * this many, so bulk transfers don't allocate and free one per word */
+#define DAP_CMD_POOL_MAX	16384
+
+static struct dap_cmd *dap_cmd_new(struct adiv5_dap *dap, uint8_t instr,
 		uint8_t reg_addr, uint8_t RnW,
 		uint8_t *outvalue, uint8_t *invalue,
 		uint32_t memaccess_tck)
 {
 	struct dap_cmd *cmd;
 
-	cmd = (struct dap_cmd *)calloc(1, sizeof(struct dap_cmd));
+	if (!list_empty(&dap->cmd_pool)) {
+		cmd = list_first_entry(&dap->cmd_pool, struct dap_cmd, lh);
+		list_del(&cmd->lh);
+		dap->cmd_pool_count--;
+		memset(cmd, 0, sizeof(struct dap_cmd));
+	} else {
+		cmd = (struct dap_cmd *)calloc(1, sizeof(struct dap_cmd));
+	}
+
 	if (cmd != NULL) {
 		INIT_LIST_HEAD(&cmd->lh);
 		cmd->instr = instr;
@@ -175,14 +187,27 @@ static struct dap_cmd *dap_cmd_new(uint8_t instr,
 	return cmd;
 }
 
-static void flush_journal(struct list_head *lh)
+static void dap_cmd_release(struct adiv5_dap *dap, struct dap_cmd *cmd)
+{
+	if (dap->cmd_pool_count < DAP_CMD_POOL_MAX) {
+		list_add(&cmd->lh, &dap->cmd_pool);
+		dap->cmd_pool_count++;
+	} else {
+		free(cmd);
+	}
+}
+
+static void flush_journal(struct adiv5_dap *dap, struct list_head *lh)
 {
 	struct dap_cmd *el, *tmp;
 
 	list_for_each_entry_safe(el, tmp, lh, lh) {
 		list_del(&el->lh);
-		free(el);
+		dap_cmd_release(dap, el);
 	}
+
+	if (lh == &dap->cmd_journal)
+		dap->cmd_journal_count = 0;
 }
 
 /***************************************************************************
@@ -273,15 +298,20 @@ static int adi_jtag_dp_scan(struct adiv5_dap *dap,
 	struct dap_cmd *cmd;
 	int retval;
 
-	cmd = dap_cmd_new(instr, reg_addr, RnW, outvalue, invalue, memaccess_tck);
+	cmd = dap_cmd_new(dap, instr, reg_addr, RnW, outvalue, invalue, memaccess_tck);
 	if (cmd != NULL)
 		cmd->dp_select = dap->select;
 	else
 		return ERROR_JTAG_DEVICE_ERROR;
 
 	retval = adi_jtag_dp_scan_cmd(dap, cmd, ack);
-	if (retval == ERROR_OK)
+	if (retval == ERROR_OK) {
 		list_add_tail(&cmd->lh,	&dap->cmd_journal);
+		if (++dap->cmd_journal_count > dap->cmd_journal_max)
+			dap->cmd_journal_max = dap->cmd_journal_count;
+	} else {
+		dap_cmd_release(dap, cmd);
+	}
 
 	return retval;
 }
@@ -415,7 +445,7 @@ static int jtagdp_overrun_check(struct adiv5_dap *dap)
 				* To complete the READ, we just keep polling RDBUFF
 				* until the WAIT condition clears
 				*/
-				tmp = dap_cmd_new(JTAG_DP_DPACC,
+				tmp = dap_cmd_new(dap, JTAG_DP_DPACC,
 						DP_RDBUFF, DPAP_READ, NULL, NULL, 0);
 				if (tmp == NULL) {
 					retval = ERROR_JTAG_DEVICE_ERROR;
@@ -459,7 +489,7 @@ static int jtagdp_overrun_check(struct adiv5_dap *dap)
 				}
 
 				/* we're done with this command, release it */
-				free(tmp);
+				dap_cmd_release(dap, tmp);
 
 				if (retval != ERROR_OK)
 					goto done;
@@ -479,7 +509,7 @@ static int jtagdp_overrun_check(struct adiv5_dap *dap)
 	}
 
 	/* we're done with the journal, flush it */
-	flush_journal(&dap->cmd_journal);
+	flush_journal(dap, &dap->cmd_journal);
 
 	/* check for overrun condition in the last batch of transactions */
 	if (found_wait) {
@@ -494,7 +524,7 @@ static int jtagdp_overrun_check(struct adiv5_dap *dap)
 		/* restore SELECT register first */
 		if (!list_empty(&replay_list)) {
 			el = list_first_entry(&replay_list, struct dap_cmd, lh);
-			tmp = dap_cmd_new(JTAG_DP_DPACC,
+			tmp = dap_cmd_new(dap, JTAG_DP_DPACC,
 					  DP_SELECT, DPAP_WRITE, (uint8_t *)&el->dp_select, NULL, 0);
 			if (tmp == NULL) {
 				retval = ERROR_JTAG_DEVICE_ERROR;
@@ -545,8 +575,8 @@ static int jtagdp_overrun_check(struct adiv5_dap *dap)
 	}
 
  done:
-	flush_journal(&replay_list);
-	flush_journal(&dap->cmd_journal);
+	flush_journal(dap, &replay_list);
+	flush_journal(dap, &dap->cmd_journal);
 	return retval;
 }
 
@@ -592,7 +622,7 @@ static int jtagdp_transaction_endcheck(struct adiv5_dap *dap)
 	}
 
  done:
-	flush_journal(&dap->cmd_journal);
+	flush_journal(dap, &dap->cmd_journal);
 	return retval;
 }
 
@@ -691,6 +721,19 @@ static int jtag_dp_sync(struct adiv5_dap *dap)
 /* FIXME don't export ... just initialize as
  * part of DAP setup
 */
+static void jtag_dp_quit(struct adiv5_dap *dap)
+{
+	struct dap_cmd *el, *tmp;
+
+	flush_journal(dap, &dap->cmd_journal);
+
+	list_for_each_entry_safe(el, tmp, &dap->cmd_pool, lh) {
+		list_del(&el->lh);
+		free(el);
+	}
+	dap->cmd_pool_count = 0;
+}
+
 const struct dap_ops jtag_dp_ops = {
 	.queue_dp_read       = jtag_dp_q_read,
 	.queue_dp_write      = jtag_dp_q_write,
@@ -699,6 +742,7 @@ const struct dap_ops jtag_dp_ops = {
 	.queue_ap_abort      = jtag_ap_q_abort,
 	.run                 = jtag_dp_run,
 	.sync                = jtag_dp_sync,
+	.quit                = jtag_dp_quit,
 };
 
 
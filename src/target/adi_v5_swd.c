@@ -85,7 +85,9 @@ static int swd_run_inner(struct adiv5_dap *dap)
 	const struct swd_driver *swd = jtag_interface->swd;
 	int retval;
 
+	TRACELOG(TRACELOG_SWD_RUN, TRACELOG_BEGIN, 0);
 	retval = swd->run();
+	TRACELOG(TRACELOG_SWD_RUN, TRACELOG_END, retval);
 
 	if (retval != ERROR_OK) {
 		/* fault response */
@@ -278,6 +280,13 @@ static int swd_run(struct adiv5_dap *dap)
 	return swd_run_inner(dap);
 }
 
+static unsigned int swd_queue_size(struct adiv5_dap *dap)
+{
+	const struct swd_driver *swd = jtag_interface->swd;
+
+	return swd->queue_size ? swd->queue_size() : 0;
+}
+
 const struct dap_ops swd_dap_ops = {
 	.queue_dp_read = swd_queue_dp_read,
 	.queue_dp_write = swd_queue_dp_write,
@@ -285,6 +294,7 @@ const struct dap_ops swd_dap_ops = {
 	.queue_ap_write = swd_queue_ap_write,
 	.queue_ap_abort = swd_queue_ap_abort,
 	.run = swd_run,
+	.queue_size = swd_queue_size,
 };
 
 /*
@@ -168,6 +168,10 @@ struct arm {
 	/** Handle for the Embedded Trace Module, if one is present. */
 	struct etm_context *etm;
 
+	/** Opcodes fetched and decoded by arm_simulate_step(), if any;
+	 * released by arm_simulate_free(). */
+	struct arm_sim_cache *sim_cache;
+
 	/* FIXME all these methods should take "struct arm *" not target */
 
 	/** Retrieve all core registers, for display. */
@@ -261,6 +265,9 @@ int arm_checksum_memory(struct target *target,
 		target_addr_t address, uint32_t count, uint32_t *checksum);
 int arm_blank_check_memory(struct target *target,
 		target_addr_t address, uint32_t count, uint32_t *blank, uint8_t erased_value);
+int arm_blank_check_memory_blocks(struct target *target,
+		struct target_memory_check_block *blocks, unsigned int num_blocks,
+		uint8_t erased_value);
 
 void arm_set_cpsr(struct arm *arm, uint32_t cpsr);
 struct reg *arm_reg_current(struct arm *arm, unsigned regnum);
@@ -1131,6 +1131,11 @@ static int arm11_init_target(struct command_context *cmd_ctx,
 	return ERROR_OK;
 }
 
+static void arm11_deinit_target(struct target *target)
+{
+	arm_simulate_free(target_to_arm(target));
+}
+
 /* talk to the target and set things up */
 static int arm11_examine(struct target *target)
 {
@@ -1369,6 +1374,7 @@ struct target_type arm11_target = {
 
 	.checksum_memory = arm_checksum_memory,
 	.blank_check_memory = arm_blank_check_memory,
+	.blank_check_memory_blocks = arm_blank_check_memory_blocks,
 
 	.add_breakpoint = arm11_add_breakpoint,
 	.remove_breakpoint = arm11_remove_breakpoint,
@@ -1378,5 +1384,6 @@ struct target_type arm11_target = {
 	.commands = arm11_command_handlers,
 	.target_create = arm11_target_create,
 	.init_target = arm11_init_target,
+	.deinit_target = arm11_deinit_target,
 	.examine = arm11_examine,
 };
@@ -1840,6 +1840,11 @@ int arm7_9_resume(struct target *target,
 	return ERROR_OK;
 }
 
+void arm7_9_deinit_target(struct target *target)
+{
+	arm_simulate_free(target_to_arm(target));
+}
+
 void arm7_9_enable_eice_step(struct target *target, uint32_t next_pc)
 {
 	struct arm7_9_common *arm7_9 = target_to_arm7_9(target);
@@ -1704,6 +1704,7 @@ struct target_type arm920t_target = {
 
 	.checksum_memory = arm_checksum_memory,
 	.blank_check_memory = arm_blank_check_memory,
+	.blank_check_memory_blocks = arm_blank_check_memory_blocks,
 
 	.run_algorithm = armv4_5_run_algorithm,
 
@@ -1715,6 +1716,7 @@ struct target_type arm920t_target = {
 	.commands = arm920t_command_handlers,
 	.target_create = arm920t_target_create,
 	.init_target = arm9tdmi_init_target,
+	.deinit_target = arm7_9_deinit_target,
 	.examine = arm7_9_examine,
 	.check_reset = arm7_9_check_reset,
 };
@@ -811,6 +811,7 @@ struct target_type arm926ejs_target = {
 
 	.checksum_memory = arm_checksum_memory,
 	.blank_check_memory = arm_blank_check_memory,
+	.blank_check_memory_blocks = arm_blank_check_memory_blocks,
 
 	.run_algorithm = armv4_5_run_algorithm,
 
@@ -822,6 +823,7 @@ struct target_type arm926ejs_target = {
 	.commands = arm926ejs_command_handlers,
 	.target_create = arm926ejs_target_create,
 	.init_target = arm9tdmi_init_target,
+	.deinit_target = arm7_9_deinit_target,
 	.examine = arm7_9_examine,
 	.check_reset = arm7_9_check_reset,
 	.virt2phys = arm926ejs_virt2phys,
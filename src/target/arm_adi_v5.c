@@ -159,20 +159,52 @@ static uint32_t mem_ap_get_tar_increment(struct adiv5_ap *ap)
 	return 0;
 }
 
-/* mem_ap_update_tar_cache is called after an access to MEM_AP_REG_DRW
+/* mem_ap_update_tar_cache is called after @a transfers accesses to MEM_AP_REG_DRW
  */
-static void mem_ap_update_tar_cache(struct adiv5_ap *ap)
+static void mem_ap_update_tar_cache(struct adiv5_ap *ap, uint32_t transfers)
 {
 	if (!ap->tar_valid)
 		return;
 
-	uint32_t inc = mem_ap_get_tar_increment(ap);
+	uint32_t inc = mem_ap_get_tar_increment(ap) * transfers;
 	if (inc >= max_tar_block_size(ap->tar_autoincr_block, ap->tar_value))
 		ap->tar_valid = false;
 	else
 		ap->tar_value += inc;
 }
 
+/* Number of DRW accesses of @a this_size bytes, at most @a nbytes worth, that can
+ * be queued from @a address before the TAR has to be written again. At least one
+ * access is returned even if it crosses the autoincrement boundary, the TAR cache
+ * then forces a rewrite for the next one. */
+static uint32_t mem_ap_block_transfers(struct adiv5_ap *ap, uint32_t address,
+		size_t nbytes, uint32_t this_size, bool addrinc)
+{
+	size_t block = nbytes;
+
+	if (addrinc && max_tar_block_size(ap->tar_autoincr_block, address) < block)
+		block = max_tar_block_size(ap->tar_autoincr_block, address);
+
+	return block >= this_size ? block / this_size : 1;
+}
+
+/* Number of AP accesses to queue before running them, keeping room for the
+ * final RDBUFF read. A run spans as many TAR blocks as fit in the adapter's
+ * queue; each block is charged MEM_AP_BLOCK_SETUP accesses for the CSW and TAR
+ * writes it may need on top of its DRW accesses, so that a run never overflows
+ * the queue and an error ends the transfer without queueing the rest of it.
+ * Without a fixed queue size the whole transfer is a single run. */
+#define MEM_AP_BLOCK_SETUP	2
+
+static uint32_t mem_ap_run_size(struct adiv5_dap *dap)
+{
+	unsigned int queue_size = dap_queue_size(dap);
+
+	if (queue_size <= MEM_AP_BLOCK_SETUP + 1)
+		return UINT32_MAX;
+	return queue_size - 1;
+}
+
 /**
  * Queue transactions setting up transfer parameters for the
  * currently selected MEM-AP.
@@ -356,9 +388,22 @@ static int mem_ap_write(struct adiv5_ap *ap, const uint8_t *buffer, uint32_t siz
 	if (ap->unaligned_access_bad && (address % size != 0))
 		return ERROR_TARGET_UNALIGNED_ACCESS;
 
+	uint32_t run_size = mem_ap_run_size(dap);
+	uint32_t run_left = run_size;
+
+	retval = ERROR_OK;
 	while (nbytes > 0) {
 		uint32_t this_size = size;
 
+		/* Start a new run unless there is room for the block setup and a DRW access */
+		if (run_left <= MEM_AP_BLOCK_SETUP) {
+			retval = dap_run(dap);
+			if (retval != ERROR_OK)
+				break;
+			run_left = run_size;
+		}
+		run_left -= MEM_AP_BLOCK_SETUP;
+
 		/* Select packed transfer if possible */
 		if (addrinc && ap->packed_transfers && nbytes >= 4
 				&& max_tar_block_size(ap->tar_autoincr_block, address) >= 4) {
@@ -375,49 +420,64 @@ static int mem_ap_write(struct adiv5_ap *ap, const uint8_t *buffer, uint32_t siz
 		if (retval != ERROR_OK)
 			return retval;
 
-		/* How many source bytes each transfer will consume, and their location in the DRW,
-		 * depends on the type of transfer and alignment. See ARM document IHI0031C. */
-		uint32_t outvalue = 0;
-		uint32_t drw_byte_idx = address;
-		if (dap->ti_be_32_quirks) {
-			switch (this_size) {
-			case 4:
-				outvalue |= (uint32_t)*buffer++ << 8 * (3 ^ (drw_byte_idx++ & 3) ^ addr_xor);
-				outvalue |= (uint32_t)*buffer++ << 8 * (3 ^ (drw_byte_idx++ & 3) ^ addr_xor);
-				outvalue |= (uint32_t)*buffer++ << 8 * (3 ^ (drw_byte_idx++ & 3) ^ addr_xor);
-				outvalue |= (uint32_t)*buffer++ << 8 * (3 ^ (drw_byte_idx & 3) ^ addr_xor);
-				break;
-			case 2:
-				outvalue |= (uint32_t)*buffer++ << 8 * (1 ^ (drw_byte_idx++ & 3) ^ addr_xor);
-				outvalue |= (uint32_t)*buffer++ << 8 * (1 ^ (drw_byte_idx & 3) ^ addr_xor);
-				break;
-			case 1:
-				outvalue |= (uint32_t)*buffer++ << 8 * (0 ^ (drw_byte_idx & 3) ^ addr_xor);
-				break;
-			}
-		} else {
-			switch (this_size) {
-			case 4:
-				outvalue |= (uint32_t)*buffer++ << 8 * (drw_byte_idx++ & 3);
-				outvalue |= (uint32_t)*buffer++ << 8 * (drw_byte_idx++ & 3);
-				/* fallthrough */
-			case 2:
-				outvalue |= (uint32_t)*buffer++ << 8 * (drw_byte_idx++ & 3);
-				/* fallthrough */
-			case 1:
-				outvalue |= (uint32_t)*buffer++ << 8 * (drw_byte_idx & 3);
+		/* Stream the rest of the TAR block, or as much of it as is left in this run,
+		 * without touching CSW or TAR. The BE-32 quirks need TAR set for every access. */
+		uint32_t transfers = mem_ap_block_transfers(ap, address, nbytes, this_size, addrinc);
+		if (addr_xor)
+			transfers = 1;
+		if (transfers > run_left)
+			transfers = run_left;
+
+		for (uint32_t i = 0; i < transfers; i++) {
+			/* How many source bytes each transfer will consume, and their location in the DRW,
+			 * depends on the type of transfer and alignment. See ARM document IHI0031C. */
+			uint32_t outvalue = 0;
+			uint32_t drw_byte_idx = address;
+			if (dap->ti_be_32_quirks) {
+				switch (this_size) {
+				case 4:
+					outvalue |= (uint32_t)*buffer++ << 8 * (3 ^ (drw_byte_idx++ & 3) ^ addr_xor);
+					outvalue |= (uint32_t)*buffer++ << 8 * (3 ^ (drw_byte_idx++ & 3) ^ addr_xor);
+					outvalue |= (uint32_t)*buffer++ << 8 * (3 ^ (drw_byte_idx++ & 3) ^ addr_xor);
+					outvalue |= (uint32_t)*buffer++ << 8 * (3 ^ (drw_byte_idx & 3) ^ addr_xor);
+					break;
+				case 2:
+					outvalue |= (uint32_t)*buffer++ << 8 * (1 ^ (drw_byte_idx++ & 3) ^ addr_xor);
+					outvalue |= (uint32_t)*buffer++ << 8 * (1 ^ (drw_byte_idx & 3) ^ addr_xor);
+					break;
+				case 1:
+					outvalue |= (uint32_t)*buffer++ << 8 * (0 ^ (drw_byte_idx & 3) ^ addr_xor);
+					break;
+				}
+			} else {
+				switch (this_size) {
+				case 4:
+					outvalue |= (uint32_t)*buffer++ << 8 * (drw_byte_idx++ & 3);
+					outvalue |= (uint32_t)*buffer++ << 8 * (drw_byte_idx++ & 3);
+					/* fallthrough */
+				case 2:
+					outvalue |= (uint32_t)*buffer++ << 8 * (drw_byte_idx++ & 3);
+					/* fallthrough */
+				case 1:
+					outvalue |= (uint32_t)*buffer++ << 8 * (drw_byte_idx & 3);
+				}
 			}
-		}
 
-		nbytes -= this_size;
+			nbytes -= this_size;
+
+			retval = dap_queue_ap_write(ap, MEM_AP_REG_DRW, outvalue);
+			if (retval != ERROR_OK)
+				break;
 
-		retval = dap_queue_ap_write(ap, MEM_AP_REG_DRW, outvalue);
+			if (addrinc)
+				address += this_size;
+		}
 		if (retval != ERROR_OK)
 			break;
 
-		mem_ap_update_tar_cache(ap);
-		if (addrinc)
-			address += this_size;
+		mem_ap_update_tar_cache(ap, transfers);
+
+		run_left -= transfers;
 	}
 
 	/* REVISIT: Might want to have a queued version of this function that does not run. */
@@ -486,12 +546,26 @@ static int mem_ap_read(struct adiv5_ap *ap, uint8_t *buffer, uint32_t size, uint
 		return ERROR_FAIL;
 	}
 
-	/* Queue up all reads. Each read will store the entire DRW word in the read buffer. How many
-	 * useful bytes it contains, and their location in the word, depends on the type of transfer
-	 * and alignment. */
+	/* Queue up all reads, a TAR block at a time and in runs sized to the adapter's
+	 * queue. Each read will store the entire DRW word in the read buffer. How many
+	 * useful bytes it contains, and their location in the word, depends on the type
+	 * of transfer and alignment. */
+	uint32_t run_size = mem_ap_run_size(dap);
+	uint32_t run_left = run_size;
+
+	retval = ERROR_OK;
 	while (nbytes > 0) {
 		uint32_t this_size = size;
 
+		/* Start a new run unless there is room for the block setup and a DRW access */
+		if (run_left <= MEM_AP_BLOCK_SETUP) {
+			retval = dap_run(dap);
+			if (retval != ERROR_OK)
+				break;
+			run_left = run_size;
+		}
+		run_left -= MEM_AP_BLOCK_SETUP;
+
 		/* Select packed transfer if possible */
 		if (addrinc && ap->packed_transfers && nbytes >= 4
 				&& max_tar_block_size(ap->tar_autoincr_block, address) >= 4) {
@@ -507,15 +581,25 @@ static int mem_ap_read(struct adiv5_ap *ap, uint8_t *buffer, uint32_t size, uint
 		if (retval != ERROR_OK)
 			break;
 
-		retval = dap_queue_ap_read(ap, MEM_AP_REG_DRW, read_ptr++);
+		uint32_t transfers = mem_ap_block_transfers(ap, address, nbytes, this_size, addrinc);
+		if (transfers > run_left)
+			transfers = run_left;
+
+		for (uint32_t i = 0; i < transfers; i++) {
+			retval = dap_queue_ap_read(ap, MEM_AP_REG_DRW, read_ptr++);
+			if (retval != ERROR_OK)
+				break;
+		}
 		if (retval != ERROR_OK)
 			break;
 
-		nbytes -= this_size;
+		nbytes -= transfers * this_size;
 		if (addrinc)
-			address += this_size;
+			address += transfers * this_size;
 
-		mem_ap_update_tar_cache(ap);
+		mem_ap_update_tar_cache(ap, transfers);
+
+		run_left -= transfers;
 	}
 
 	if (retval == ERROR_OK)
@@ -637,9 +721,18 @@ struct adiv5_dap *dap_init(void)
 		dap->ap[i].tar_autoincr_block = (1<<10);
 	}
 	INIT_LIST_HEAD(&dap->cmd_journal);
+	INIT_LIST_HEAD(&dap->cmd_pool);
 	return dap;
 }
 
+void dap_free(struct adiv5_dap *dap)
+{
+	if (dap->ops && dap->ops->quit)
+		dap->ops->quit(dap);
+
+	free(dap);
+}
+
 /**
  * Invalidate cached DP select and cached TAR and CSW of all APs
  */
@@ -1595,6 +1688,30 @@ COMMAND_HANDLER(dap_apsel_command)
 	return retval;
 }
 
+COMMAND_HANDLER(dap_journal_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct arm *arm = target_to_arm(target);
+	struct adiv5_dap *dap = arm->dap;
+
+	switch (CMD_ARGC) {
+	case 0:
+		break;
+	case 1:
+		if (strcmp(CMD_ARGV[0], "reset") != 0)
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		dap->cmd_journal_max = dap->cmd_journal_count;
+		return ERROR_OK;
+	default:
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	command_print(CMD_CTX, "journal high-water mark %u transactions, %u entries pooled",
+			dap->cmd_journal_max, dap->cmd_pool_count);
+
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(dap_apcsw_command)
 {
 	struct target *target = get_current_target(CMD_CTX);
@@ -1785,6 +1902,14 @@ static const struct command_registration dap_commands[] = {
 			"bus access [0-255]",
 		.usage = "[cycles]",
 	},
+	{
+		.name = "journal",
+		.handler = dap_journal_command,
+		.mode = COMMAND_EXEC,
+		.help = "show or reset the high-water mark of the JTAG-DP "
+			"transaction journal",
+		.usage = "['reset']",
+	},
 	{
 		.name = "ti_be_32_quirks",
 		.handler = dap_ti_be_32_quirks_command,
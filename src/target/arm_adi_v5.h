@@ -30,6 +30,7 @@
  */
 
 #include <helper/list.h>
+#include <helper/tracelog.h>
 #include "arm_jtag.h"
 
 /* three-bit ACK values for SWD access (sent LSB first) */
@@ -208,6 +209,12 @@ struct adiv5_dap {
 
 	/* dap transaction list for WAIT support */
 	struct list_head cmd_journal;
+	/* released journal entries, kept for reuse */
+	struct list_head cmd_pool;
+	unsigned int cmd_pool_count;
+	/* current journal length and its high-water mark */
+	unsigned int cmd_journal_count;
+	unsigned int cmd_journal_max;
 
 	struct jtag_tap *tap;
 	/* Control config */
@@ -277,6 +284,13 @@ struct dap_ops {
 	/** Executes all queued DAP operations but doesn't check
 	 * sticky error conditions */
 	int (*sync)(struct adiv5_dap *dap);
+
+	/** Optional: number of AP/DP transactions the adapter runs at
+	 * once, or 0 if it has no fixed limit. */
+	unsigned int (*queue_size)(struct adiv5_dap *dap);
+
+	/** Optional: release what the transport keeps for the DAP. */
+	void (*quit)(struct adiv5_dap *dap);
 };
 
 /*
@@ -397,7 +411,21 @@ static inline int dap_queue_ap_abort(struct adiv5_dap *dap, uint8_t *ack)
 static inline int dap_run(struct adiv5_dap *dap)
 {
 	assert(dap->ops != NULL);
-	return dap->ops->run(dap);
+
+	TRACELOG(TRACELOG_DAP_RUN, TRACELOG_BEGIN, 0);
+	int retval = dap->ops->run(dap);
+	TRACELOG(TRACELOG_DAP_RUN, TRACELOG_END, retval);
+
+	return retval;
+}
+
+/** Number of transactions the adapter runs at once, 0 if unlimited. */
+static inline unsigned int dap_queue_size(struct adiv5_dap *dap)
+{
+	assert(dap->ops != NULL);
+	if (dap->ops->queue_size)
+		return dap->ops->queue_size(dap);
+	return 0;
 }
 
 static inline int dap_sync(struct adiv5_dap *dap)
@@ -475,6 +503,7 @@ int mem_ap_write_buf_noincr(struct adiv5_ap *ap,
 
 /* Create DAP struct */
 struct adiv5_dap *dap_init(void);
+void dap_free(struct adiv5_dap *dap);
 
 /* Initialisation of the debug system, power domains and registers */
 int dap_dp_init(struct adiv5_dap *dap);
@@ -112,6 +112,83 @@ static int post_result(struct target *target)
 	return ERROR_OK;
 }
 
+/* String reads are done in aligned chunks; a chunk never crosses a
+ * page boundary, so reading past the terminating NUL cannot fault. */
+#define SEMIHOSTING_STRING_CHUNK	64
+
+/* Console output of SYS_WRITEC and SYS_WRITE0 is collected here and
+ * written out a line at a time, and whenever the target stops running
+ * or OpenOCD is about to do other I/O for it. */
+#define SEMIHOSTING_CONSOLE_SIZE	256
+
+static uint8_t console_buf[SEMIHOSTING_CONSOLE_SIZE];
+static size_t console_len;
+
+static void console_flush(void)
+{
+	if (console_len == 0)
+		return;
+
+	fwrite(console_buf, 1, console_len, stdout);
+	fflush(stdout);
+	console_len = 0;
+}
+
+static void console_write(const uint8_t *data, size_t len)
+{
+	bool eol = memchr(data, '\n', len) != NULL;
+
+	while (len > 0) {
+		size_t n = MIN(len, sizeof(console_buf) - console_len);
+
+		memcpy(console_buf + console_len, data, n);
+		console_len += n;
+		data += n;
+		len -= n;
+		if (console_len == sizeof(console_buf))
+			console_flush();
+	}
+
+	if (eol)
+		console_flush();
+}
+
+/**
+ * Read a NUL terminated string from target memory a chunk at a time
+ * instead of a byte per round trip.
+ *
+ * @param target The target to read from.
+ * @param addr Address of the string in target memory.
+ * @param print If true, the string (without its NUL) goes to the console.
+ * @param len If not NULL, receives the string length.
+ * @return ERROR_OK on success, else the error of the failing read.
+ */
+static int read_string(struct target *target, uint32_t addr, bool print, size_t *len)
+{
+	uint8_t chunk[SEMIHOSTING_STRING_CHUNK];
+	size_t count = 0;
+
+	while (1) {
+		uint32_t n = SEMIHOSTING_STRING_CHUNK - (addr % SEMIHOSTING_STRING_CHUNK);
+		int retval = target_read_buffer(target, addr, n, chunk);
+		if (retval != ERROR_OK)
+			return retval;
+
+		uint8_t *nul = memchr(chunk, 0, n);
+		uint32_t l = nul ? (uint32_t)(nul - chunk) : n;
+		if (print)
+			console_write(chunk, l);
+		count += l;
+		addr += l;
+		if (nul != NULL)
+			break;
+	}
+
+	if (len != NULL)
+		*len = count;
+	return ERROR_OK;
+}
+
 static int do_semihosting(struct target *target)
 {
 	struct arm *arm = target_to_arm(target);
@@ -140,7 +217,7 @@ static int do_semihosting(struct target *target)
 			uint32_t m = target_buffer_get_u32(target, params+4);
 			uint32_t l = target_buffer_get_u32(target, params+8);
 			uint8_t fn[256];
-			retval = target_read_memory(target, a, 1, l, fn);
+			retval = target_read_buffer(target, a, l, fn);
 			if (retval != ERROR_OK)
 				return retval;
 			fn[l] = 0;
@@ -202,42 +279,30 @@ static int do_semihosting(struct target *target)
 			fileio_info->param_2 = r1;
 			fileio_info->param_3 = 1;
 		} else {
-			unsigned char c;
+			uint8_t c;
 			retval = target_read_memory(target, r1, 1, 1, &c);
 			if (retval != ERROR_OK)
 				return retval;
-			putchar(c);
+			console_write(&c, 1);
 			arm->semihosting_result = 0;
 		}
 		break;
 
 	case 0x04:	/* SYS_WRITE0 */
 		if (arm->is_semihosting_fileio) {
-			size_t count = 0;
-			for (uint32_t a = r1;; a++) {
-				unsigned char c;
-				retval = target_read_memory(target, a, 1, 1, &c);
-				if (retval != ERROR_OK)
-					return retval;
-				if (c == '\0')
-					break;
-				count++;
-			}
+			size_t count;
+			retval = read_string(target, r1, false, &count);
+			if (retval != ERROR_OK)
+				return retval;
 			arm->semihosting_hit_fileio = true;
 			fileio_info->identifier = "write";
 			fileio_info->param_1 = 1;
 			fileio_info->param_2 = r1;
 			fileio_info->param_3 = count;
 		} else {
-			do {
-				unsigned char c;
-				retval = target_read_memory(target, r1++, 1, 1, &c);
-				if (retval != ERROR_OK)
-					return retval;
-				if (!c)
-					break;
-				putchar(c);
-			} while (1);
+			retval = read_string(target, r1, true, NULL);
+			if (retval != ERROR_OK)
+				return retval;
 			arm->semihosting_result = 0;
 		}
 		break;
@@ -258,6 +323,8 @@ static int do_semihosting(struct target *target)
 				fileio_info->param_3 = l;
 			} else {
 				uint8_t *buf = malloc(l);
+				/* ":tt" is a dup() of stdout, keep the order */
+				console_flush();
 				if (!buf) {
 					arm->semihosting_result = -1;
 					arm->semihosting_errno = ENOMEM;
@@ -293,6 +360,8 @@ static int do_semihosting(struct target *target)
 				fileio_info->param_3 = l;
 			} else {
 				uint8_t *buf = malloc(l);
+				/* show any prompt before waiting for input */
+				console_flush();
 				if (!buf) {
 					arm->semihosting_result = -1;
 					arm->semihosting_errno = ENOMEM;
@@ -318,6 +387,7 @@ static int do_semihosting(struct target *target)
 			LOG_ERROR("SYS_READC not supported by semihosting fileio");
 			return ERROR_FAIL;
 		}
+		console_flush();
 		arm->semihosting_result = getchar();
 		break;
 
@@ -399,7 +469,7 @@ static int do_semihosting(struct target *target)
 			} else {
 				if (l <= 255) {
 					uint8_t fn[256];
-					retval = target_read_memory(target, a, 1, l, fn);
+					retval = target_read_buffer(target, a, l, fn);
 					if (retval != ERROR_OK)
 						return retval;
 					fn[l] = 0;
@@ -432,10 +502,10 @@ static int do_semihosting(struct target *target)
 			} else {
 				if (l1 <= 255 && l2 <= 255) {
 					uint8_t fn1[256], fn2[256];
-					retval = target_read_memory(target, a1, 1, l1, fn1);
+					retval = target_read_buffer(target, a1, l1, fn1);
 					if (retval != ERROR_OK)
 						return retval;
-					retval = target_read_memory(target, a2, 1, l2, fn2);
+					retval = target_read_buffer(target, a2, l2, fn2);
 					if (retval != ERROR_OK)
 						return retval;
 					fn1[l1] = 0;
@@ -494,6 +564,7 @@ static int do_semihosting(struct target *target)
 		break;
 
 	case 0x18:	/* angel_SWIreason_ReportException */
+		console_flush();
 		switch (r1) {
 		case 0x20026:	/* ADP_Stopped_ApplicationExit */
 			fprintf(stderr, "semihosting: *** application exited ***\n");
@@ -545,11 +616,11 @@ static int do_semihosting(struct target *target)
 					arm->semihosting_errno = EINVAL;
 				} else {
 					memset(cmd, 0x0, 256);
-					retval = target_read_memory(target, c_ptr, 1, len, cmd);
+					retval = target_read_buffer(target, c_ptr, len, cmd);
 					if (retval != ERROR_OK)
 						return retval;
-					else
-						arm->semihosting_result = system((const char *)cmd);
+					console_flush();
+					arm->semihosting_result = system((const char *)cmd);
 				}
 			}
 		}
@@ -642,20 +713,7 @@ int arm_semihosting_init(struct target *target)
 	return ERROR_OK;
 }
 
-/**
- * Checks for and processes an ARM semihosting request.  This is meant
- * to be called when the target is stopped due to a debug mode entry.
- * If the value 0 is returned then there was nothing to process. A non-zero
- * return value signifies that a request was processed and the target resumed,
- * or an error was encountered, in which case the caller must return
- * immediately.
- *
- * @param target Pointer to the ARM target to process.  This target must
- *	not represent an ARMv6-M or ARMv7-M processor.
- * @param retval Pointer to a location where the return code will be stored
- * @return non-zero value if a request was processed or an error encountered
- */
-int arm_semihosting(struct target *target, int *retval)
+static int semihosting_trap(struct target *target, int *retval)
 {
 	struct arm *arm = target_to_arm(target);
 	struct armv7a_common *armv7a = target_to_armv7a(target);
@@ -795,3 +853,27 @@ int arm_semihosting(struct target *target, int *retval)
 
 	return 0;
 }
+
+/**
+ * Checks for and processes an ARM semihosting request.  This is meant
+ * to be called when the target is stopped due to a debug mode entry.
+ * If the value 0 is returned then there was nothing to process. A non-zero
+ * return value signifies that a request was processed and the target resumed,
+ * or an error was encountered, in which case the caller must return
+ * immediately.
+ *
+ * @param target Pointer to the ARM target to process.  This target must
+ *	not represent an ARMv6-M or ARMv7-M processor.
+ * @param retval Pointer to a location where the return code will be stored
+ * @return non-zero value if a request was processed or an error encountered
+ */
+int arm_semihosting(struct target *target, int *retval)
+{
+	int processed = semihosting_trap(target, retval);
+
+	/* the target stays halted, show what it printed so far */
+	if (!processed || *retval != ERROR_OK)
+		console_flush();
+
+	return processed;
+}
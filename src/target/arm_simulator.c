@@ -232,32 +232,191 @@ static int thumb_pass_branch_condition(uint32_t cpsr, uint16_t opcode)
 	return pass_condition(cpsr, (opcode & 0x0f00) << 20);
 }
 
+/* Stepping through a loop simulates the same few instructions over and
+ * over. Code is fetched a line at a time and decoded instructions are
+ * kept, both until target->memory_generation says memory may have changed.
+ */
+#define ARM_SIM_LINE_SIZE	64
+#define ARM_SIM_LINES		16
+#define ARM_SIM_DECODED		64
+
+struct arm_sim_line {
+	bool valid;
+	uint32_t address;
+	uint8_t data[ARM_SIM_LINE_SIZE];
+};
+
+struct arm_sim_decoded {
+	bool valid;
+	enum arm_state state;
+	uint32_t address;
+	/* ARM opcode, or the first halfword of a Thumb instruction */
+	uint32_t opcode;
+	struct arm_instruction instruction;
+};
+
+struct arm_sim_cache {
+	uint32_t generation;
+	struct arm_sim_line lines[ARM_SIM_LINES];
+	struct arm_sim_decoded decoded[ARM_SIM_DECODED];
+};
+
+static void arm_sim_cache_check(struct target *target, struct arm_sim_cache *cache)
+{
+	if (cache->generation == target->memory_generation)
+		return;
+
+	for (int i = 0; i < ARM_SIM_LINES; i++)
+		cache->lines[i].valid = false;
+	for (int i = 0; i < ARM_SIM_DECODED; i++)
+		cache->decoded[i].valid = false;
+	cache->generation = target->memory_generation;
+}
+
+/* Read an aligned 2 or 4 byte opcode, through the line cache if there is one. */
+static int arm_sim_read_code(struct target *target, struct arm_sim_cache *cache,
+	uint32_t address, unsigned int size, uint32_t *opcode)
+{
+	int retval;
+
+	if (cache) {
+		uint32_t base = address & ~(ARM_SIM_LINE_SIZE - 1);
+		struct arm_sim_line *line = &cache->lines[(base / ARM_SIM_LINE_SIZE) % ARM_SIM_LINES];
+
+		if (!line->valid || line->address != base) {
+			line->valid = target_read_memory(target, base, 4,
+					ARM_SIM_LINE_SIZE / 4, line->data) == ERROR_OK;
+			line->address = base;
+		}
+
+		/* a line can fail to read if it runs into unmapped memory,
+		 * then only the opcode itself is read below */
+		if (line->valid) {
+			if (size == 4)
+				*opcode = target_buffer_get_u32(target, line->data + address - base);
+			else
+				*opcode = target_buffer_get_u16(target, line->data + address - base);
+			return ERROR_OK;
+		}
+	}
+
+	if (size == 4) {
+		retval = target_read_u32(target, address, opcode);
+	} else {
+		uint16_t halfword;
+		retval = target_read_u16(target, address, &halfword);
+		*opcode = halfword;
+	}
+
+	return retval;
+}
+
+/* Fetch and decode the instruction at address, including both halves of a
+ * Thumb BL/BLX pair.
+ */
+static int arm_sim_decode(struct target *target, struct arm_sim_cache *cache,
+	uint32_t address, enum arm_state state,
+	uint32_t *opcode, struct arm_instruction *instruction)
+{
+	struct arm_sim_decoded *entry = NULL;
+	int retval;
+
+	if (cache) {
+		entry = &cache->decoded[(address >> 1) % ARM_SIM_DECODED];
+		if (entry->valid && entry->address == address && entry->state == state) {
+			*opcode = entry->opcode;
+			*instruction = entry->instruction;
+			return ERROR_OK;
+		}
+	}
+
+	if (state == ARM_STATE_ARM) {
+		retval = arm_sim_read_code(target, cache, address, 4, opcode);
+		if (retval != ERROR_OK)
+			return retval;
+		retval = arm_evaluate_opcode(*opcode, address, instruction);
+		if (retval != ERROR_OK)
+			return retval;
+	} else {
+		retval = arm_sim_read_code(target, cache, address, 2, opcode);
+		if (retval != ERROR_OK)
+			return retval;
+		retval = thumb_evaluate_opcode(*opcode, address, instruction);
+		if (retval != ERROR_OK)
+			return retval;
+
+		/* Deal with 32-bit BL/BLX */
+		if ((*opcode & 0xf800) == 0xf000) {
+			uint32_t high = instruction->info.b_bl_bx_blx.target_address;
+			uint32_t low;
+
+			retval = arm_sim_read_code(target, cache, address + 2, 2, &low);
+			if (retval != ERROR_OK)
+				return retval;
+			retval = thumb_evaluate_opcode(low, address, instruction);
+			if (retval != ERROR_OK)
+				return retval;
+			instruction->info.b_bl_bx_blx.target_address += high;
+		}
+	}
+
+	if (entry) {
+		entry->valid = true;
+		entry->state = state;
+		entry->address = address;
+		entry->opcode = *opcode;
+		entry->instruction = *instruction;
+	}
+
+	return ERROR_OK;
+}
+
+/* Whether executing the instruction leaves memory alone. Anything not
+ * known to be free of stores, exceptions or coprocessor operations counts
+ * as possibly writing memory.
+ */
+static bool arm_sim_no_store(const struct arm_instruction *instruction)
+{
+	enum arm_instruction_type type = instruction->type;
+
+	return (type >= ARM_B && type <= ARM_MVN)	/* branches, data processing */
+		|| (type >= ARM_LDR && type <= ARM_LDM)
+		|| (type >= ARM_MRS && type <= ARM_CLZ)	/* PSR access, multiplies */
+		|| type == ARM_MRC || type == ARM_MRRC
+		|| (type >= ARM_PLD && type <= ARM_LDRD);
+}
+
 /* simulate a single step (if possible)
  * if the dry_run_pc argument is provided, no state is changed,
  * but the new pc is stored in the variable pointed at by the argument
  */
 static int arm_simulate_step_core(struct target *target,
-	uint32_t *dry_run_pc, struct arm_sim_interface *sim)
+	uint32_t *dry_run_pc, struct arm_sim_interface *sim,
+	struct arm_sim_cache *cache)
 {
 	uint32_t current_pc = sim->get_reg(sim, 15);
 	struct arm_instruction instruction;
 	int instruction_size;
 	int retval = ERROR_OK;
 
+	if (cache)
+		arm_sim_cache_check(target, cache);
+
 	if (sim->get_state(sim) == ARM_STATE_ARM) {
 		uint32_t opcode;
 
 		/* get current instruction, and identify it */
-		retval = target_read_u32(target, current_pc, &opcode);
-		if (retval != ERROR_OK)
-			return retval;
-		retval = arm_evaluate_opcode(opcode, current_pc, &instruction);
+		retval = arm_sim_decode(target, cache, current_pc, ARM_STATE_ARM,
+				&opcode, &instruction);
 		if (retval != ERROR_OK)
 			return retval;
 		instruction_size = 4;
+		target->step_without_store = arm_sim_no_store(&instruction);
 
 		/* check condition code (for all instructions) */
 		if (!pass_condition(sim->get_cpsr(sim, 0, 32), opcode)) {
+			/* not executed, so nothing stored either */
+			target->step_without_store = true;
 			if (dry_run_pc)
 				*dry_run_pc = current_pc + instruction_size;
 			else
@@ -266,15 +425,14 @@ static int arm_simulate_step_core(struct target *target,
 			return ERROR_OK;
 		}
 	} else {
-		uint16_t opcode;
+		uint32_t opcode;
 
-		retval = target_read_u16(target, current_pc, &opcode);
-		if (retval != ERROR_OK)
-			return retval;
-		retval = thumb_evaluate_opcode(opcode, current_pc, &instruction);
+		retval = arm_sim_decode(target, cache, current_pc, ARM_STATE_THUMB,
+				&opcode, &instruction);
 		if (retval != ERROR_OK)
 			return retval;
 		instruction_size = 2;
+		target->step_without_store = arm_sim_no_store(&instruction);
 
 		/* check condition code (only for branch (1) instructions) */
 		if ((opcode & 0xf000) == 0xd000
@@ -287,18 +445,6 @@ static int arm_simulate_step_core(struct target *target,
 
 			return ERROR_OK;
 		}
-
-		/* Deal with 32-bit BL/BLX */
-		if ((opcode & 0xf800) == 0xf000) {
-			uint32_t high = instruction.info.b_bl_bx_blx.target_address;
-			retval = target_read_u16(target, current_pc+2, &opcode);
-			if (retval != ERROR_OK)
-				return retval;
-			retval = thumb_evaluate_opcode(opcode, current_pc, &instruction);
-			if (retval != ERROR_OK)
-				return retval;
-			instruction.info.b_bl_bx_blx.target_address += high;
-		}
 	}
 
 	/* examine instruction type */
@@ -718,5 +864,16 @@ int arm_simulate_step(struct target *target, uint32_t *dry_run_pc)
 	sim.get_state = &armv4_5_get_state;
 	sim.set_state = &armv4_5_set_state;
 
-	return arm_simulate_step_core(target, dry_run_pc, &sim);
+	/* without memory for the cache, every step reads the target */
+	if (!arm->sim_cache)
+		arm->sim_cache = calloc(1, sizeof(struct arm_sim_cache));
+
+	return arm_simulate_step_core(target, dry_run_pc, &sim, arm->sim_cache);
+}
+
+/* Release the opcode cache of arm_simulate_step(), on target teardown. */
+void arm_simulate_free(struct arm *arm)
+{
+	free(arm->sim_cache);
+	arm->sim_cache = NULL;
 }
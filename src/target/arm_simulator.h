@@ -35,5 +35,6 @@ struct arm_sim_interface {
 
 /* armv4_5 version */
 int arm_simulate_step(struct target *target, uint32_t *dry_run_pc);
+void arm_simulate_free(struct arm *arm);
 
 #endif /* OPENOCD_TARGET_ARM_SIMULATOR_H */
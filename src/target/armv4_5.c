@@ -582,7 +582,7 @@ static const struct reg_arch_type arm_reg_type = {
 struct reg_cache *arm_build_reg_cache(struct target *target, struct arm *arm)
 {
 	int num_regs = ARRAY_SIZE(arm_core_regs);
-	struct reg_cache *cache = malloc(sizeof(struct reg_cache));
+	struct reg_cache *cache = calloc(1, sizeof(struct reg_cache));
 	struct reg *reg_list = calloc(num_regs, sizeof(struct reg));
 	struct arm_reg *reg_arch_info = calloc(num_regs, sizeof(struct arm_reg));
 	int i;
@@ -1645,6 +1645,115 @@ cleanup:
 	return retval;
 }
 
+/** Blank check as many of the blocks as fit the working area in one
+ * algorithm run, see target_blank_check_memory_blocks(). */
+int arm_blank_check_memory_blocks(struct target *target,
+	struct target_memory_check_block *blocks, unsigned int num_blocks,
+	uint8_t erased_value)
+{
+	struct working_area *check_algorithm;
+	struct working_area *check_params;
+	struct reg_param reg_params[3];
+	struct arm_algorithm arm_algo;
+	struct arm *arm = target_to_arm(target);
+	uint8_t *params;
+	uint32_t total_size = 0;
+	unsigned int i;
+	int retval;
+	uint32_t exit_var = 0;
+
+	static const uint8_t check_code_le[] = {
+#include "../../contrib/loaders/erase_check/armv4_5_erase_check_blocks.inc"
+	};
+
+	assert(sizeof(check_code_le) % 4 == 0);
+
+	/* make sure we have a working area */
+	retval = target_alloc_working_area(target,
+			sizeof(check_code_le), &check_algorithm);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* the rest of it holds the block list, 12 bytes per block */
+	num_blocks = MIN(num_blocks, target_get_working_area_avail(target) / 12);
+	if (num_blocks == 0 || target_alloc_working_area(target, num_blocks * 12,
+			&check_params) != ERROR_OK) {
+		target_free_working_area(target, check_algorithm);
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+	}
+
+	params = malloc(num_blocks * 12);
+	if (!params) {
+		retval = ERROR_FAIL;
+		goto cleanup;
+	}
+
+	for (i = 0; i < num_blocks; i++) {
+		target_buffer_set_u32(target, params + i * 12, blocks[i].address);
+		target_buffer_set_u32(target, params + i * 12 + 4, blocks[i].size);
+		target_buffer_set_u32(target, params + i * 12 + 8, 0);
+		total_size += blocks[i].size;
+	}
+
+	/* convert code into a buffer in target endianness */
+	for (i = 0; i < ARRAY_SIZE(check_code_le) / 4; i++) {
+		retval = target_write_u32(target,
+				check_algorithm->address
+				+ i * sizeof(uint32_t),
+				le_to_h_u32(&check_code_le[i * 4]));
+		if (retval != ERROR_OK)
+			goto cleanup;
+	}
+
+	retval = target_write_buffer(target, check_params->address,
+			num_blocks * 12, params);
+	if (retval != ERROR_OK)
+		goto cleanup;
+
+	arm_algo.common_magic = ARM_COMMON_MAGIC;
+	arm_algo.core_mode = ARM_MODE_SVC;
+	arm_algo.core_state = ARM_STATE_ARM;
+
+	init_reg_param(&reg_params[0], "r0", 32, PARAM_OUT);
+	buf_set_u32(reg_params[0].value, 0, 32, check_params->address);
+
+	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT);
+	buf_set_u32(reg_params[1].value, 0, 32, num_blocks);
+
+	init_reg_param(&reg_params[2], "r2", 32, PARAM_OUT);
+	buf_set_u32(reg_params[2].value, 0, 32, erased_value);
+
+	/* armv4 must exit using a hardware breakpoint */
+	if (arm->is_armv4)
+		exit_var = check_algorithm->address + sizeof(check_code_le) - 4;
+
+	/* allow for a slow core reading a lot of flash */
+	retval = target_run_algorithm(target, 0, NULL, 3, reg_params,
+			check_algorithm->address,
+			exit_var,
+			10000 + total_size / 1024, &arm_algo);
+
+	destroy_reg_param(&reg_params[0]);
+	destroy_reg_param(&reg_params[1]);
+	destroy_reg_param(&reg_params[2]);
+
+	if (retval == ERROR_OK)
+		retval = target_read_buffer(target, check_params->address,
+				num_blocks * 12, params);
+	if (retval == ERROR_OK) {
+		for (i = 0; i < num_blocks; i++)
+			blocks[i].result = target_buffer_get_u32(target, params + i * 12 + 8);
+		retval = num_blocks;
+	}
+
+cleanup:
+	free(params);
+	target_free_working_area(target, check_params);
+	target_free_working_area(target, check_algorithm);
+
+	return retval;
+}
+
 static int arm_full_context(struct target *target)
 {
 	struct arm *arm = target_to_arm(target);
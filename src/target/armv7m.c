@@ -570,7 +570,7 @@ struct reg_cache *armv7m_build_reg_cache(struct target *target)
 	struct arm *arm = &armv7m->arm;
 	int num_regs = ARMV7M_NUM_REGS;
 	struct reg_cache **cache_p = register_get_last_cache_p(&target->reg_cache);
-	struct reg_cache *cache = malloc(sizeof(struct reg_cache));
+	struct reg_cache *cache = calloc(1, sizeof(struct reg_cache));
 	struct reg *reg_list = calloc(num_regs, sizeof(struct reg));
 	struct arm_reg *arch_info = calloc(num_regs, sizeof(struct arm_reg));
 	struct reg_feature *feature;
@@ -648,6 +648,7 @@ void armv7m_free_reg_cache(struct target *target)
 
 	free(cache->reg_list[0].arch_info);
 	free(cache->reg_list);
+	register_cache_free_index(cache);
 	free(cache);
 
 	arm->core_cache = NULL;
@@ -805,6 +806,103 @@ cleanup:
 	return retval;
 }
 
+/** Blank check as many of the blocks as fit the working area in one
+ * algorithm run, see target_blank_check_memory_blocks(). */
+int armv7m_blank_check_memory_blocks(struct target *target,
+	struct target_memory_check_block *blocks, unsigned int num_blocks,
+	uint8_t erased_value)
+{
+	struct working_area *erase_check_algorithm;
+	struct working_area *erase_check_params;
+	struct reg_param reg_params[3];
+	struct armv7m_algorithm armv7m_info;
+	uint8_t *params;
+	uint32_t total_size = 0;
+	unsigned int i;
+	int retval;
+
+	static const uint8_t erase_check_code[] = {
+#include "../../contrib/loaders/erase_check/armv7m_erase_check_blocks.inc"
+	};
+
+	/* make sure we have a working area */
+	if (target_alloc_working_area(target, sizeof(erase_check_code),
+		&erase_check_algorithm) != ERROR_OK)
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+
+	/* the rest of it holds the block list, 12 bytes per block */
+	num_blocks = MIN(num_blocks, target_get_working_area_avail(target) / 12);
+	if (num_blocks == 0 || target_alloc_working_area(target, num_blocks * 12,
+			&erase_check_params) != ERROR_OK) {
+		target_free_working_area(target, erase_check_algorithm);
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+	}
+
+	params = malloc(num_blocks * 12);
+	if (!params) {
+		retval = ERROR_FAIL;
+		goto cleanup;
+	}
+
+	for (i = 0; i < num_blocks; i++) {
+		target_buffer_set_u32(target, params + i * 12, blocks[i].address);
+		target_buffer_set_u32(target, params + i * 12 + 4, blocks[i].size);
+		target_buffer_set_u32(target, params + i * 12 + 8, 0);
+		total_size += blocks[i].size;
+	}
+
+	retval = target_write_buffer(target, erase_check_algorithm->address,
+			sizeof(erase_check_code), erase_check_code);
+	if (retval == ERROR_OK)
+		retval = target_write_buffer(target, erase_check_params->address,
+				num_blocks * 12, params);
+	if (retval != ERROR_OK)
+		goto cleanup;
+
+	armv7m_info.common_magic = ARMV7M_COMMON_MAGIC;
+	armv7m_info.core_mode = ARM_MODE_THREAD;
+
+	init_reg_param(&reg_params[0], "r0", 32, PARAM_OUT);
+	buf_set_u32(reg_params[0].value, 0, 32, erase_check_params->address);
+
+	init_reg_param(&reg_params[1], "r1", 32, PARAM_OUT);
+	buf_set_u32(reg_params[1].value, 0, 32, num_blocks);
+
+	init_reg_param(&reg_params[2], "r2", 32, PARAM_OUT);
+	buf_set_u32(reg_params[2].value, 0, 32, erased_value);
+
+	/* allow for a slow core reading a lot of flash */
+	retval = target_run_algorithm(target,
+			0,
+			NULL,
+			3,
+			reg_params,
+			erase_check_algorithm->address,
+			erase_check_algorithm->address + (sizeof(erase_check_code) - 2),
+			10000 + total_size / 1024,
+			&armv7m_info);
+
+	destroy_reg_param(&reg_params[0]);
+	destroy_reg_param(&reg_params[1]);
+	destroy_reg_param(&reg_params[2]);
+
+	if (retval == ERROR_OK)
+		retval = target_read_buffer(target, erase_check_params->address,
+				num_blocks * 12, params);
+	if (retval == ERROR_OK) {
+		for (i = 0; i < num_blocks; i++)
+			blocks[i].result = target_buffer_get_u32(target, params + i * 12 + 8);
+		retval = num_blocks;
+	}
+
+cleanup:
+	free(params);
+	target_free_working_area(target, erase_check_params);
+	target_free_working_area(target, erase_check_algorithm);
+
+	return retval;
+}
+
 int armv7m_maybe_skip_bkpt_inst(struct target *target, bool *inst_found)
 {
 	struct armv7m_common *armv7m = target_to_armv7m(target);
@@ -28,9 +28,6 @@
 
 #include "helper/time_support.h"
 
-/* T32 ITR format */
-#define T32_FMTITR(instr) (((instr & 0x0000FFFF) << 16) | ((instr & 0xFFFF0000) >> 16))
-
 /**
  * @file
  * Implements various ARM DPM operations using architectural debug registers.
@@ -63,6 +63,9 @@ void armv8_dpm_report_wfar(struct arm_dpm *, uint64_t wfar);
 
 
 
+/* T32 ITR format */
+#define T32_FMTITR(instr) (((instr & 0x0000FFFF) << 16) | ((instr & 0xFFFF0000) >> 16))
+
 /* Methods of entry into debug mode */
 #define DSCRV8_ENTRY_NON_DEBUG			(0x2)
 #define DSCRV8_ENTRY_RESTARTING			(0x1)
@@ -0,0 +1,496 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+/*
+ * Throughput and latency measurements of the adapter and target, meant for
+ * comparing adapters, adapter firmware and OpenOCD versions on one board.
+ *
+ * Every result is printed as a single line of the form
+ *	bench <test> <operation> key=value ...
+ * so that scripts can collect and compare them.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <helper/log.h>
+#include <helper/command.h>
+#include <helper/time_support.h>
+#include <flash/nor/core.h>
+#include <flash/nor/imp.h>
+
+#include "target.h"
+#include "register.h"
+#include "bench.h"
+
+/* a measurement is repeated until it took at least this long */
+#define BENCH_MIN_US		200000
+#define BENCH_MAX_REPEAT	10000
+
+#define BENCH_DEFAULT_ITERATIONS	100
+
+static const uint32_t bench_block_sizes[] = { 4, 64, 256, 1024, 4096, 16384, 65536 };
+
+static uint64_t bench_elapsed_us(const struct duration *d)
+{
+	return d->elapsed.tv_sec * 1000000ULL + d->elapsed.tv_usec;
+}
+
+static double bench_kibps(uint64_t bytes, uint64_t us)
+{
+	return us ? bytes * 1000000.0 / 1024 / us : 0;
+}
+
+/* min/avg/max of a series of latency samples */
+struct bench_latency {
+	unsigned int n;
+	uint64_t min_us;
+	uint64_t max_us;
+	uint64_t total_us;
+};
+
+static void bench_latency_add(struct bench_latency *l, const struct duration *d)
+{
+	uint64_t us = bench_elapsed_us(d);
+
+	if (l->n == 0 || us < l->min_us)
+		l->min_us = us;
+	if (us > l->max_us)
+		l->max_us = us;
+	l->total_us += us;
+	l->n++;
+}
+
+static void bench_latency_print(struct command_context *cmd_ctx, const char *test,
+		const char *op, const struct bench_latency *l)
+{
+	if (l->n == 0)
+		return;
+
+	command_print(cmd_ctx, "bench %s %s n=%u min_us=%" PRIu64 " avg_us=%" PRIu64
+			" max_us=%" PRIu64, test, op, l->n, l->min_us, l->total_us / l->n, l->max_us);
+}
+
+static int bench_check_halted(struct target *target)
+{
+	if (target->state != TARGET_HALTED) {
+		LOG_ERROR("target must be halted to run a benchmark");
+		return ERROR_TARGET_NOT_HALTED;
+	}
+	return ERROR_OK;
+}
+
+/* Read or write @a block bytes at a time with accesses of @a width, until
+ * enough time has passed for a stable figure */
+static int bench_memory_one(struct command_context *cmd_ctx, struct target *target,
+		target_addr_t address, uint8_t *buffer, uint32_t block, unsigned int width,
+		bool write)
+{
+	struct duration bench;
+	unsigned int repeat = 0;
+	int retval = ERROR_OK;
+
+	duration_start(&bench);
+	do {
+		if (write)
+			retval = target_write_memory(target, address, width, block / width, buffer);
+		else
+			retval = target_read_memory(target, address, width, block / width, buffer);
+		if (retval != ERROR_OK)
+			break;
+		repeat++;
+		duration_measure(&bench);
+		keep_alive();
+	} while (bench_elapsed_us(&bench) < BENCH_MIN_US && repeat < BENCH_MAX_REPEAT);
+
+	if (retval == ERROR_TARGET_UNALIGNED_ACCESS) {
+		command_print(cmd_ctx, "bench memory %s width=%u block=%" PRIu32 " unsupported",
+				write ? "write" : "read", width, block);
+		return ERROR_OK;
+	} else if (retval != ERROR_OK) {
+		LOG_ERROR("memory %s of %" PRIu32 " bytes at " TARGET_ADDR_FMT " failed",
+				write ? "write" : "read", block, address);
+		return retval;
+	}
+
+	uint64_t us = bench_elapsed_us(&bench);
+	uint64_t bytes = (uint64_t)block * repeat;
+	command_print(cmd_ctx, "bench memory %s width=%u block=%" PRIu32 " bytes=%" PRIu64
+			" us=%" PRIu64 " kibps=%.1f", write ? "write" : "read", width, block,
+			bytes, us, bench_kibps(bytes, us));
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_bench_memory_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct working_area *wa = NULL;
+	target_addr_t address;
+	uint32_t size = 4096;
+	uint8_t *buffer, *backup = NULL;
+	int retval;
+
+	if (CMD_ARGC > 2)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	retval = bench_check_halted(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (CMD_ARGC == 2) {
+		COMMAND_PARSE_ADDRESS(CMD_ARGV[0], address);
+		COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], size);
+	} else {
+		if (CMD_ARGC == 1)
+			COMMAND_PARSE_NUMBER(u32, CMD_ARGV[0], size);
+		retval = target_alloc_working_area(target, size, &wa);
+		if (retval != ERROR_OK) {
+			LOG_ERROR("not enough working area for %" PRIu32 " bytes, "
+					"give an address of RAM to use instead", size);
+			return retval;
+		}
+		address = wa->address;
+	}
+
+	if (size < 4) {
+		retval = ERROR_COMMAND_SYNTAX_ERROR;
+		goto out;
+	}
+
+	buffer = malloc(size);
+	backup = malloc(size);
+	if (buffer == NULL || backup == NULL) {
+		LOG_ERROR("out of memory");
+		free(buffer);
+		retval = ERROR_FAIL;
+		goto out;
+	}
+
+	/* the caller's memory is put back afterwards */
+	if (wa == NULL) {
+		retval = target_read_memory(target, address, 1, size, backup);
+		if (retval != ERROR_OK) {
+			LOG_ERROR("failed to read memory at " TARGET_ADDR_FMT, address);
+			goto out_free;
+		}
+	}
+
+	for (uint32_t i = 0; i < size; i++)
+		buffer[i] = rand();
+
+	for (unsigned int i = 0; i < ARRAY_SIZE(bench_block_sizes); i++) {
+		uint32_t block = bench_block_sizes[i];
+
+		if (block > size)
+			break;
+
+		for (unsigned int width = 4; width >= 1; width /= 2) {
+			retval = bench_memory_one(CMD_CTX, target, address, buffer, block, width, true);
+			if (retval != ERROR_OK)
+				goto out_restore;
+			retval = bench_memory_one(CMD_CTX, target, address, buffer, block, width, false);
+			if (retval != ERROR_OK)
+				goto out_restore;
+		}
+	}
+
+out_restore:
+	if (wa == NULL) {
+		int restore_retval = target_write_memory(target, address, 1, size, backup);
+		if (restore_retval != ERROR_OK) {
+			LOG_ERROR("failed to restore memory at " TARGET_ADDR_FMT, address);
+			if (retval == ERROR_OK)
+				retval = restore_retval;
+		}
+	}
+out_free:
+	free(buffer);
+out:
+	free(backup);
+	if (wa != NULL)
+		target_free_working_area(target, wa);
+
+	return retval;
+}
+
+COMMAND_HANDLER(handle_bench_run_control_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	unsigned int iterations = BENCH_DEFAULT_ITERATIONS;
+	struct bench_latency resume = { 0 }, halt = { 0 }, step = { 0 };
+	struct duration bench;
+	int retval;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], iterations);
+
+	retval = bench_check_halted(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* the target runs its own code between the resume and the halt */
+	for (unsigned int i = 0; i < iterations; i++) {
+		duration_start(&bench);
+		retval = target_resume(target, 1, 0, 0, 0);
+		duration_measure(&bench);
+		if (retval != ERROR_OK)
+			goto out;
+		bench_latency_add(&resume, &bench);
+
+		duration_start(&bench);
+		retval = target_halt(target);
+		if (retval == ERROR_OK)
+			retval = target_wait_state(target, TARGET_HALTED, 1000);
+		duration_measure(&bench);
+		if (retval != ERROR_OK)
+			goto out;
+		bench_latency_add(&halt, &bench);
+	}
+
+	for (unsigned int i = 0; i < iterations; i++) {
+		duration_start(&bench);
+		retval = target_step(target, 1, 0, 0);
+		if (retval == ERROR_OK && target->state != TARGET_HALTED)
+			retval = target_wait_state(target, TARGET_HALTED, 1000);
+		duration_measure(&bench);
+		if (retval != ERROR_OK)
+			goto out;
+		bench_latency_add(&step, &bench);
+	}
+
+out:
+	bench_latency_print(CMD_CTX, "run_control", "resume", &resume);
+	bench_latency_print(CMD_CTX, "run_control", "halt", &halt);
+	bench_latency_print(CMD_CTX, "run_control", "step", &step);
+
+	if (retval != ERROR_OK)
+		LOG_ERROR("run control benchmark failed");
+
+	return retval;
+}
+
+COMMAND_HANDLER(handle_bench_registers_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	unsigned int iterations = BENCH_DEFAULT_ITERATIONS;
+	struct bench_latency one = { 0 }, all = { 0 };
+	struct reg **reg_list = NULL;
+	int reg_list_size = 0;
+	struct duration bench;
+	int retval;
+
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	if (CMD_ARGC == 1)
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], iterations);
+
+	retval = bench_check_halted(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	struct reg *pc = register_get_common(target->reg_cache, REG_COMMON_PC);
+	if (pc == NULL || pc->type == NULL) {
+		LOG_ERROR("target has no pc register");
+		return ERROR_FAIL;
+	}
+
+	retval = target_get_gdb_reg_list(target, &reg_list, &reg_list_size, REG_CLASS_GENERAL);
+	if (retval != ERROR_OK)
+		return retval;
+
+	/* Registers are read again by marking them invalid. Modified ones
+	 * are left alone, their new value would be lost. */
+	for (unsigned int i = 0; i < iterations && !pc->dirty; i++) {
+		pc->valid = false;
+		duration_start(&bench);
+		retval = pc->type->get(pc);
+		duration_measure(&bench);
+		if (retval != ERROR_OK)
+			goto out;
+		bench_latency_add(&one, &bench);
+	}
+
+	int num_read = 0;
+	for (unsigned int i = 0; i < iterations; i++) {
+		num_read = 0;
+		duration_start(&bench);
+		for (int r = 0; r < reg_list_size; r++) {
+			struct reg *reg = reg_list[r];
+
+			if (!reg->exist || reg->dirty || reg->type == NULL)
+				continue;
+			reg->valid = false;
+			retval = reg->type->get(reg);
+			if (retval != ERROR_OK)
+				goto out;
+			num_read++;
+		}
+		duration_measure(&bench);
+		bench_latency_add(&all, &bench);
+		keep_alive();
+	}
+
+	bench_latency_print(CMD_CTX, "registers", "pc", &one);
+	if (all.n)
+		command_print(CMD_CTX, "bench registers general n=%u regs=%d min_us=%" PRIu64
+				" avg_us=%" PRIu64 " max_us=%" PRIu64, all.n, num_read, all.min_us,
+				all.total_us / all.n, all.max_us);
+
+out:
+	free(reg_list);
+
+	if (retval != ERROR_OK)
+		LOG_ERROR("register benchmark failed");
+
+	return retval;
+}
+
+COMMAND_HANDLER(handle_bench_flash_command)
+{
+	struct flash_bank *bank;
+	struct duration bench;
+	uint8_t *buffer = NULL, *readback = NULL;
+	unsigned int first, last;
+	int retval;
+
+	if (CMD_ARGC != 3)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	retval = CALL_COMMAND_HANDLER(flash_command_get_bank, 0, &bank);
+	if (retval != ERROR_OK)
+		return retval;
+
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[1], first);
+	COMMAND_PARSE_NUMBER(uint, CMD_ARGV[2], last);
+	if (first > last || last >= (unsigned int)bank->num_sectors) {
+		LOG_ERROR("sector range %u to %u is outside of bank %s", first, last, bank->name);
+		return ERROR_COMMAND_SYNTAX_ERROR;
+	}
+
+	retval = bench_check_halted(bank->target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	uint32_t offset = bank->sectors[first].offset;
+	uint32_t size = bank->sectors[last].offset + bank->sectors[last].size - offset;
+
+	buffer = malloc(size);
+	readback = malloc(size);
+	if (buffer == NULL || readback == NULL) {
+		LOG_ERROR("out of memory");
+		retval = ERROR_FAIL;
+		goto out;
+	}
+
+	for (uint32_t i = 0; i < size; i++)
+		buffer[i] = rand();
+
+	duration_start(&bench);
+	retval = flash_driver_erase(bank, first, last);
+	duration_measure(&bench);
+	if (retval != ERROR_OK)
+		goto out;
+	command_print(CMD_CTX, "bench flash erase sectors=%u bytes=%" PRIu32 " us=%" PRIu64
+			" kibps=%.1f", last - first + 1, size, bench_elapsed_us(&bench),
+			bench_kibps(size, bench_elapsed_us(&bench)));
+
+	duration_start(&bench);
+	retval = flash_driver_write(bank, buffer, offset, size);
+	duration_measure(&bench);
+	if (retval != ERROR_OK)
+		goto out;
+	command_print(CMD_CTX, "bench flash program bytes=%" PRIu32 " us=%" PRIu64
+			" kibps=%.1f", size, bench_elapsed_us(&bench),
+			bench_kibps(size, bench_elapsed_us(&bench)));
+
+	duration_start(&bench);
+	retval = flash_driver_read(bank, readback, offset, size);
+	duration_measure(&bench);
+	if (retval != ERROR_OK)
+		goto out;
+	command_print(CMD_CTX, "bench flash read bytes=%" PRIu32 " us=%" PRIu64
+			" kibps=%.1f", size, bench_elapsed_us(&bench),
+			bench_kibps(size, bench_elapsed_us(&bench)));
+
+	if (memcmp(buffer, readback, size) != 0) {
+		LOG_ERROR("flash contents differ from what was programmed");
+		retval = ERROR_FAIL;
+	}
+
+out:
+	free(buffer);
+	free(readback);
+
+	if (retval != ERROR_OK)
+		LOG_ERROR("flash benchmark failed");
+
+	return retval;
+}
+
+static const struct command_registration bench_subcommand_handlers[] = {
+	{
+		.name = "memory",
+		.handler = handle_bench_memory_command,
+		.mode = COMMAND_EXEC,
+		.help = "measure memory read and write bandwidth for each access "
+			"width and a range of block sizes, in a working area or at "
+			"the given address (contents are restored)",
+		.usage = "[address] [size]",
+	},
+	{
+		.name = "run_control",
+		.handler = handle_bench_run_control_command,
+		.mode = COMMAND_EXEC,
+		.help = "measure resume, halt and step latency, lets the target run",
+		.usage = "[iterations]",
+	},
+	{
+		.name = "registers",
+		.handler = handle_bench_registers_command,
+		.mode = COMMAND_EXEC,
+		.help = "measure the latency of reading the pc and of reading "
+			"all general registers",
+		.usage = "[iterations]",
+	},
+	{
+		.name = "flash",
+		.handler = handle_bench_flash_command,
+		.mode = COMMAND_EXEC,
+		.help = "measure erase, program and read rates of a range of "
+			"flash sectors, destroying their contents",
+		.usage = "bank_id first_sector last_sector",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration bench_command_handlers[] = {
+	{
+		.name = "bench",
+		.mode = COMMAND_EXEC,
+		.help = "adapter and target benchmarks",
+		.usage = "",
+		.chain = bench_subcommand_handlers,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+int bench_register_commands(struct command_context *cmd_ctx)
+{
+	return register_commands(cmd_ctx, NULL, bench_command_handlers);
+}
@@ -2200,12 +2200,93 @@ static int cortex_a_write_cpu_memory_fast(struct target *target,
 			4, count, armv7a->debug_base + CPUDBG_DTRRX);
 }
 
+static int cortex_a_write_cpu_memory_stall(struct target *target,
+	uint32_t size, uint32_t count, const uint8_t *buffer, uint32_t *dscr)
+{
+	/* Writes count objects of size size from *buffer, like
+	 * cortex_a_write_cpu_memory_slow, but with the DCC in stall mode. A write
+	 * to DTRRX then waits until DTRRX is empty and a write to ITR until the
+	 * previous instruction has completed, so the transactions for a whole
+	 * batch of objects are queued and run at once instead of polling DSCR
+	 * after every instruction. DTRRX, ITR and DSCR share a 16-byte block and
+	 * are reached through the banked data registers without TAR updates.
+	 * Once a sticky abort flag is set the core ignores ITR and no longer
+	 * stalls, as fast mode relies on too, so a fault ends the batch early.
+	 * Preconditions:
+	 * - Address is in R0.
+	 * - R0 is marked dirty.
+	 */
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+	struct arm *arm = &armv7a->arm;
+	uint32_t opcode;
+	int retval;
+
+	/* Mark register R1 as dirty, to use for transferring data. */
+	arm_reg_current(arm, 1)->dirty = true;
+
+	/* Switch to stall mode if not already in that mode. */
+	retval = cortex_a_set_dcc_mode(target, DSCR_EXT_DCC_STALL_MODE, dscr);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (size == 1)
+		opcode = ARMV4_5_STRB_IP(1, 0);
+	else if (size == 2)
+		opcode = ARMV4_5_STRH_IP(1, 0);
+	else
+		opcode = ARMV4_5_STRW_IP(1, 0);
+
+	while (count) {
+		uint32_t batch = MIN(count, CORTEX_A_DCC_BATCH);
+
+		for (uint32_t i = 0; i < batch; i++) {
+			/* Write the value to store into DTRRX, transfer it to R1 and
+			 * store R1 to memory. */
+			uint32_t data;
+			if (size == 1)
+				data = *buffer;
+			else if (size == 2)
+				data = target_buffer_get_u16(target, buffer);
+			else
+				data = target_buffer_get_u32(target, buffer);
+			retval = mem_ap_write_u32(armv7a->debug_ap,
+					armv7a->debug_base + CPUDBG_DTRRX, data);
+			if (retval == ERROR_OK)
+				retval = mem_ap_write_u32(armv7a->debug_ap,
+						armv7a->debug_base + CPUDBG_ITR, ARMV4_5_MRC(14, 0, 1, 0, 5, 0));
+			if (retval == ERROR_OK)
+				retval = mem_ap_write_u32(armv7a->debug_ap,
+						armv7a->debug_base + CPUDBG_ITR, opcode);
+			if (retval != ERROR_OK)
+				return retval;
+
+			buffer += size;
+		}
+
+		retval = mem_ap_read_u32(armv7a->debug_ap,
+				armv7a->debug_base + CPUDBG_DSCR, dscr);
+		if (retval == ERROR_OK)
+			retval = dap_run(armv7a->debug_ap->dap);
+		if (retval != ERROR_OK)
+			return retval;
+
+		/* Check for faults and return early. */
+		if (*dscr & (DSCR_STICKY_ABORT_PRECISE | DSCR_STICKY_ABORT_IMPRECISE))
+			return ERROR_OK; /* A data fault is not considered a system failure. */
+
+		count -= batch;
+	}
+
+	return ERROR_OK;
+}
+
 static int cortex_a_write_cpu_memory(struct target *target,
 	uint32_t address, uint32_t size,
 	uint32_t count, const uint8_t *buffer)
 {
 	/* Write memory through the CPU. */
 	int retval, final_retval;
+	struct cortex_a_common *cortex_a = target_to_cortex_a(target);
 	struct armv7a_common *armv7a = target_to_armv7a(target);
 	struct arm *arm = &armv7a->arm;
 	uint32_t dscr, orig_dfar, orig_dfsr, fault_dscr, fault_dfar, fault_dfsr;
@@ -2257,6 +2338,9 @@ static int cortex_a_write_cpu_memory(struct target *target,
 	if (size == 4 && (address % 4) == 0) {
 		/* We are doing a word-aligned transfer, so use fast mode. */
 		retval = cortex_a_write_cpu_memory_fast(target, count, buffer, &dscr);
+	} else if (cortex_a->dcc_pipeline_mode == CORTEX_A_DCC_PIPELINE_ON) {
+		/* Queue the slow path in stall mode. */
+		retval = cortex_a_write_cpu_memory_stall(target, size, count, buffer, &dscr);
 	} else {
 		/* Use slow path. */
 		retval = cortex_a_write_cpu_memory_slow(target, size, count, buffer, &dscr);
@@ -2502,12 +2586,91 @@ static int cortex_a_read_cpu_memory_fast(struct target *target,
 	return ERROR_OK;
 }
 
+static int cortex_a_read_cpu_memory_stall(struct target *target,
+	uint32_t size, uint32_t count, uint8_t *buffer, uint32_t *dscr)
+{
+	/* Reads count objects of size size into *buffer, like
+	 * cortex_a_read_cpu_memory_slow, but with the DCC in stall mode. A write
+	 * to ITR then waits until the previous instruction has completed and a
+	 * read of DTRTX until DTRTX is full, so the transactions for a whole
+	 * batch of objects are queued and run at once; see
+	 * cortex_a_write_cpu_memory_stall.
+	 * Preconditions:
+	 * - Address is in R0.
+	 * - R0 is marked dirty.
+	 */
+	struct armv7a_common *armv7a = target_to_armv7a(target);
+	struct arm *arm = &armv7a->arm;
+	uint32_t data[CORTEX_A_DCC_BATCH];
+	uint32_t opcode;
+	int retval;
+
+	/* Mark register R1 as dirty, to use for transferring data. */
+	arm_reg_current(arm, 1)->dirty = true;
+
+	/* Switch to stall mode if not already in that mode. */
+	retval = cortex_a_set_dcc_mode(target, DSCR_EXT_DCC_STALL_MODE, dscr);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (size == 1)
+		opcode = ARMV4_5_LDRB_IP(1, 0);
+	else if (size == 2)
+		opcode = ARMV4_5_LDRH_IP(1, 0);
+	else
+		opcode = ARMV4_5_LDRW_IP(1, 0);
+
+	while (count) {
+		uint32_t batch = MIN(count, CORTEX_A_DCC_BATCH);
+
+		for (uint32_t i = 0; i < batch; i++) {
+			/* Load R1 from memory, move it to DTRTX and read it. */
+			retval = mem_ap_write_u32(armv7a->debug_ap,
+					armv7a->debug_base + CPUDBG_ITR, opcode);
+			if (retval == ERROR_OK)
+				retval = mem_ap_write_u32(armv7a->debug_ap,
+						armv7a->debug_base + CPUDBG_ITR, ARMV4_5_MCR(14, 0, 1, 0, 5, 0));
+			if (retval == ERROR_OK)
+				retval = mem_ap_read_u32(armv7a->debug_ap,
+						armv7a->debug_base + CPUDBG_DTRTX, &data[i]);
+			if (retval != ERROR_OK)
+				return retval;
+		}
+
+		retval = mem_ap_read_u32(armv7a->debug_ap,
+				armv7a->debug_base + CPUDBG_DSCR, dscr);
+		if (retval == ERROR_OK)
+			retval = dap_run(armv7a->debug_ap->dap);
+		if (retval != ERROR_OK)
+			return retval;
+
+		/* Check for faults and return early. */
+		if (*dscr & (DSCR_STICKY_ABORT_PRECISE | DSCR_STICKY_ABORT_IMPRECISE))
+			return ERROR_OK; /* A data fault is not considered a system failure. */
+
+		for (uint32_t i = 0; i < batch; i++) {
+			if (size == 1)
+				*buffer = (uint8_t) data[i];
+			else if (size == 2)
+				target_buffer_set_u16(target, buffer, (uint16_t) data[i]);
+			else
+				target_buffer_set_u32(target, buffer, data[i]);
+			buffer += size;
+		}
+
+		count -= batch;
+	}
+
+	return ERROR_OK;
+}
+
 static int cortex_a_read_cpu_memory(struct target *target,
 	uint32_t address, uint32_t size,
 	uint32_t count, uint8_t *buffer)
 {
 	/* Read memory through the CPU. */
 	int retval, final_retval;
+	struct cortex_a_common *cortex_a = target_to_cortex_a(target);
 	struct armv7a_common *armv7a = target_to_armv7a(target);
 	struct arm *arm = &armv7a->arm;
 	uint32_t dscr, orig_dfar, orig_dfsr, fault_dscr, fault_dfar, fault_dfsr;
@@ -2559,6 +2722,9 @@ static int cortex_a_read_cpu_memory(struct target *target,
 	if (size == 4 && (address % 4) == 0) {
 		/* We are doing a word-aligned transfer, so use fast mode. */
 		retval = cortex_a_read_cpu_memory_fast(target, count, buffer, &dscr);
+	} else if (cortex_a->dcc_pipeline_mode == CORTEX_A_DCC_PIPELINE_ON) {
+		/* Queue the slow path in stall mode. */
+		retval = cortex_a_read_cpu_memory_stall(target, size, count, buffer, &dscr);
 	} else {
 		/* Use slow path. */
 		retval = cortex_a_read_cpu_memory_slow(target, size, count, buffer, &dscr);
@@ -3136,6 +3302,7 @@ static int cortex_a_init_arch_info(struct target *target,
 	armv7a->arm.dap = tap->dap;
 
 	cortex_a->fast_reg_read = 0;
+	cortex_a->dcc_pipeline_mode = CORTEX_A_DCC_PIPELINE_OFF;
 
 	/* register arch-specific functions */
 	armv7a->examine_debug_reason = NULL;
@@ -3360,6 +3527,33 @@ COMMAND_HANDLER(handle_cortex_a_dacrfixup_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_cortex_a_dcc_pipeline_command)
+{
+	struct target *target = get_current_target(CMD_CTX);
+	struct cortex_a_common *cortex_a = target_to_cortex_a(target);
+
+	static const Jim_Nvp nvp_dcc_pipeline_modes[] = {
+		{ .name = "off", .value = CORTEX_A_DCC_PIPELINE_OFF },
+		{ .name = "on", .value = CORTEX_A_DCC_PIPELINE_ON },
+		{ .name = NULL, .value = -1 },
+	};
+	const Jim_Nvp *n;
+
+	if (CMD_ARGC > 0) {
+		n = Jim_Nvp_name2value_simple(nvp_dcc_pipeline_modes, CMD_ARGV[0]);
+		if (n->name == NULL) {
+			LOG_ERROR("Unknown parameter: %s - should be off or on", CMD_ARGV[0]);
+			return ERROR_COMMAND_SYNTAX_ERROR;
+		}
+		cortex_a->dcc_pipeline_mode = n->value;
+	}
+
+	n = Jim_Nvp_value2name_simple(nvp_dcc_pipeline_modes, cortex_a->dcc_pipeline_mode);
+	command_print(CMD_CTX, "cortex_a DCC pipeline %s", n->name);
+
+	return ERROR_OK;
+}
+
 static const struct command_registration cortex_a_exec_command_handlers[] = {
 	{
 		.name = "cache_info",
@@ -3409,6 +3603,14 @@ static const struct command_registration cortex_a_exec_command_handlers[] = {
 			"on memory access",
 		.usage = "['on'|'off']",
 	},
+	{
+		.name = "dcc_pipeline",
+		.handler = handle_cortex_a_dcc_pipeline_command,
+		.mode = COMMAND_ANY,
+		.help = "queue byte and halfword memory accesses through "
+			"the CPU using DCC stall mode",
+		.usage = "['on'|'off']",
+	},
 
 	COMMAND_REGISTRATION_DONE
 };
@@ -3454,6 +3656,7 @@ struct target_type cortexa_target = {
 
 	.checksum_memory = arm_checksum_memory,
 	.blank_check_memory = arm_blank_check_memory,
+	.blank_check_memory_blocks = arm_blank_check_memory_blocks,
 
 	.run_algorithm = armv4_5_run_algorithm,
 
@@ -3498,6 +3701,14 @@ static const struct command_registration cortex_r4_exec_command_handlers[] = {
 		.help = "mask cortex_r4 interrupts",
 		.usage = "['on'|'off']",
 	},
+	{
+		.name = "dcc_pipeline",
+		.handler = handle_cortex_a_dcc_pipeline_command,
+		.mode = COMMAND_ANY,
+		.help = "queue byte and halfword memory accesses through "
+			"the CPU using DCC stall mode",
+		.usage = "['on'|'off']",
+	},
 
 	COMMAND_REGISTRATION_DONE
 };
@@ -3539,6 +3750,7 @@ struct target_type cortexr4_target = {
 
 	.checksum_memory = arm_checksum_memory,
 	.blank_check_memory = arm_blank_check_memory,
+	.blank_check_memory_blocks = arm_blank_check_memory_blocks,
 
 	.run_algorithm = armv4_5_run_algorithm,
 
@@ -53,6 +53,9 @@
 
 #define CORTEX_A_PADDRDBG_CPU_SHIFT 13
 
+/* objects moved per DAP run by the pipelined DCC memory accesses */
+#define CORTEX_A_DCC_BATCH 256
+
 enum cortex_a_isrmasking_mode {
 	CORTEX_A_ISRMASK_OFF,
 	CORTEX_A_ISRMASK_ON,
@@ -63,6 +66,11 @@ enum cortex_a_dacrfixup_mode {
 	CORTEX_A_DACRFIXUP_ON
 };
 
+enum cortex_a_dcc_pipeline_mode {
+	CORTEX_A_DCC_PIPELINE_OFF,
+	CORTEX_A_DCC_PIPELINE_ON
+};
+
 struct cortex_a_brp {
 	int used;
 	int type;
@@ -101,6 +109,8 @@ struct cortex_a_common {
 
 	enum cortex_a_isrmasking_mode isrmasking_mode;
 	enum cortex_a_dacrfixup_mode dacrfixup_mode;
+	/* Use DCC stall mode for non-word memory accesses through the CPU */
+	enum cortex_a_dcc_pipeline_mode dcc_pipeline_mode;
 
 	struct armv7a_common armv7a_common;
 
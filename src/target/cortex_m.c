@@ -1732,7 +1732,7 @@ int cortex_m_profiling(struct target *target, uint32_t *samples,
 	} else {
 		LOG_INFO("Starting profiling. Halting and resuming the"
 			 " target as often as we can...");
-		reg = register_get_by_name(target->reg_cache, "pc", 1);
+		reg = register_get_common(target->reg_cache, REG_COMMON_PC);
 	}
 
 	/* Make sure the target is running */
@@ -1965,6 +1965,7 @@ static void cortex_m_dwt_free(struct target *target)
 				free(cache->reg_list[i].arch_info);
 			free(cache->reg_list);
 		}
+		register_cache_free_index(cache);
 		free(cache);
 	}
 	cm->dwt_cache = NULL;
@@ -2527,6 +2528,7 @@ struct target_type cortexm_target = {
 	.write_memory = cortex_m_write_memory,
 	.checksum_memory = armv7m_checksum_memory,
 	.blank_check_memory = armv7m_blank_check_memory,
+	.blank_check_memory_blocks = armv7m_blank_check_memory_blocks,
 
 	.run_algorithm = armv7m_run_algorithm,
 	.start_algorithm = armv7m_start_algorithm,
@@ -24,6 +24,7 @@
 #include "etm.h"
 #include "etb.h"
 #include "register.h"
+#include <helper/time_support.h>
 
 static const char * const etb_reg_list[] = {
 	"ETB_identification",
@@ -123,7 +124,7 @@ static const struct reg_arch_type etb_reg_type = {
 
 struct reg_cache *etb_build_reg_cache(struct etb *etb)
 {
-	struct reg_cache *reg_cache = malloc(sizeof(struct reg_cache));
+	struct reg_cache *reg_cache = calloc(1, sizeof(struct reg_cache));
 	struct reg *reg_list = NULL;
 	struct etb_reg *arch_info = NULL;
 	int num_regs = 9;
@@ -156,17 +157,23 @@ struct reg_cache *etb_build_reg_cache(struct etb *etb)
 	return reg_cache;
 }
 
-static void etb_getbuf(jtag_callback_data_t arg)
-{
-	uint8_t *in = (uint8_t *)arg;
-
-	*((uint32_t *)arg) = buf_get_u32(in, 0, 32);
-}
-
+/* Read num_frames words of ETB RAM, starting at the current read pointer.
+ * The read pointer auto-increments, so every frame is one DR scan with the
+ * same register address; they all go into a single JTAG queue and are
+ * captured straight into one buffer, which is converted once at the end.
+ */
 static int etb_read_ram(struct etb *etb, uint32_t *data, int num_frames)
 {
 	struct scan_field fields[3];
-	int i;
+	uint8_t *buf;
+	int i, retval;
+
+	if (num_frames <= 0)
+		return ERROR_OK;
+
+	buf = malloc(4 * num_frames);
+	if (buf == NULL)
+		return ERROR_FAIL;
 
 	etb_scann(etb, 0x0);
 	etb_set_instr(etb, 0xc);
@@ -189,23 +196,29 @@ static int etb_read_ram(struct etb *etb, uint32_t *data, int num_frames)
 
 	jtag_add_dr_scan(etb->tap, 3, fields, TAP_IDLE);
 
+	/* address remains set to 0x4 (RAM data) until we read the last frame,
+	 * and nR/W remains set to read; the queue copies the out values, so
+	 * only the last scan needs a different address
+	 */
 	for (i = 0; i < num_frames; i++) {
-		/* ensure nR/W remains set to read */
-		buf_set_u32(&temp2, 0, 1, 0);
-
-		/* address remains set to 0x4 (RAM data) until we read the last frame */
-		if (i < num_frames - 1)
-			buf_set_u32(&temp1, 0, 7, 4);
-		else
+		if (i == num_frames - 1)
 			buf_set_u32(&temp1, 0, 7, 0);
 
-		fields[0].in_value = (uint8_t *)(data + i);
+		fields[0].in_value = buf + 4 * i;
 		jtag_add_dr_scan(etb->tap, 3, fields, TAP_IDLE);
+	}
 
-		jtag_add_callback(etb_getbuf, (jtag_callback_data_t)(data + i));
+	retval = jtag_execute_queue();
+	if (retval != ERROR_OK) {
+		LOG_ERROR("ETB: reading trace RAM failed");
+		free(buf);
+		return retval;
 	}
 
-	jtag_execute_queue();
+	for (i = 0; i < num_frames; i++)
+		data[i] = buf_get_u32(buf + 4 * i, 0, 32);
+
+	free(buf);
 
 	return ERROR_OK;
 }
@@ -516,13 +529,57 @@ static trace_status_t etb_status(struct etm_context *etm_ctx)
 	return retval;
 }
 
+/* How trace port cycles are packed into one ETB RAM word: each cycle takes
+ * bits bits, holding 3 bits PIPESTAT, packet_bits bits TRACEPKT and the
+ * TRACESYNC bit, in that order from the LSB.
+ */
+struct etb_frame_layout {
+	unsigned int cycles;
+	unsigned int bits;
+	unsigned int packet_bits;
+};
+
+static const struct etb_frame_layout etb_frame_layouts[] = {
+	{ .cycles = 3, .bits = 8, .packet_bits = 4 },	/* 4 bit port */
+	{ .cycles = 2, .bits = 12, .packet_bits = 8 },	/* 8 bit port */
+	{ .cycles = 1, .bits = 20, .packet_bits = 16 },	/* 16 bit port */
+};
+
+static void etb_unpack_frames(const struct etb_frame_layout *layout,
+	const uint32_t *frames, int num_frames, struct etmv1_trace_data *trace)
+{
+	uint32_t packet_mask = (1 << layout->packet_bits) - 1;
+
+	for (int i = 0; i < num_frames; i++) {
+		uint32_t frame = frames[i];
+
+		for (unsigned int k = 0; k < layout->cycles; k++) {
+			trace->pipestat = frame & 0x7;
+			trace->packet = (frame >> 3) & packet_mask;
+			trace->flags = 0;
+			if ((frame >> (3 + layout->packet_bits)) & 1)
+				trace->flags |= ETMV1_TRACESYNC_CYCLE;
+
+			/* on a trigger cycle the real PIPESTAT is in the packet */
+			if (trace->pipestat == STAT_TR) {
+				trace->pipestat = trace->packet & 0x7;
+				trace->flags |= ETMV1_TRIGGER_CYCLE;
+			}
+
+			frame >>= layout->bits;
+			trace++;
+		}
+	}
+}
+
 static int etb_read_trace(struct etm_context *etm_ctx)
 {
 	struct etb *etb = etm_ctx->capture_driver_priv;
 	int first_frame = 0;
 	int num_frames = etb->ram_depth;
 	uint32_t *trace_data = NULL;
-	int i, j;
+	const struct etb_frame_layout *layout;
+	int retval;
 
 	etb_read_reg(&etb->reg_cache->reg_list[ETB_STATUS]);
 	etb_read_reg(&etb->reg_cache->reg_list[ETB_RAM_WRITE_POINTER]);
@@ -541,106 +598,50 @@ static int etb_read_trace(struct etm_context *etm_ctx)
 				0,
 				32);
 
+	if (etm_ctx->trace_depth > 0) {
+		free(etm_ctx->trace_data);
+		etm_ctx->trace_data = NULL;
+		etm_ctx->trace_depth = 0;
+	}
+
+	if (num_frames == 0)
+		return ERROR_OK;
+
 	etb_write_reg(&etb->reg_cache->reg_list[ETB_RAM_READ_POINTER], first_frame);
 
 	/* read data into temporary array for unpacking */
 	trace_data = malloc(sizeof(uint32_t) * num_frames);
-	etb_read_ram(etb, trace_data, num_frames);
+	if (trace_data == NULL)
+		return ERROR_FAIL;
 
-	if (etm_ctx->trace_depth > 0)
-		free(etm_ctx->trace_data);
+	struct duration bench;
+	duration_start(&bench);
+	retval = etb_read_ram(etb, trace_data, num_frames);
+	if (retval != ERROR_OK) {
+		free(trace_data);
+		return retval;
+	}
+	duration_measure(&bench);
+	LOG_DEBUG("read %d ETB frames in %fs", num_frames, duration_elapsed(&bench));
 
 	if ((etm_ctx->control & ETM_PORT_WIDTH_MASK) == ETM_PORT_4BIT)
-		etm_ctx->trace_depth = num_frames * 3;
+		layout = &etb_frame_layouts[0];
 	else if ((etm_ctx->control & ETM_PORT_WIDTH_MASK) == ETM_PORT_8BIT)
-		etm_ctx->trace_depth = num_frames * 2;
+		layout = &etb_frame_layouts[1];
 	else
-		etm_ctx->trace_depth = num_frames;
+		layout = &etb_frame_layouts[2];
 
-	etm_ctx->trace_data = malloc(sizeof(struct etmv1_trace_data) * etm_ctx->trace_depth);
+	etm_ctx->trace_depth = num_frames * layout->cycles;
 
-	for (i = 0, j = 0; i < num_frames; i++) {
-		if ((etm_ctx->control & ETM_PORT_WIDTH_MASK) == ETM_PORT_4BIT) {
-			/* trace word j */
-			etm_ctx->trace_data[j].pipestat = trace_data[i] & 0x7;
-			etm_ctx->trace_data[j].packet = (trace_data[i] & 0x78) >> 3;
-			etm_ctx->trace_data[j].flags = 0;
-			if ((trace_data[i] & 0x80) >> 7)
-				etm_ctx->trace_data[j].flags |= ETMV1_TRACESYNC_CYCLE;
-			if (etm_ctx->trace_data[j].pipestat == STAT_TR) {
-				etm_ctx->trace_data[j].pipestat = etm_ctx->trace_data[j].packet &
-					0x7;
-				etm_ctx->trace_data[j].flags |= ETMV1_TRIGGER_CYCLE;
-			}
-
-			/* trace word j + 1 */
-			etm_ctx->trace_data[j + 1].pipestat = (trace_data[i] & 0x100) >> 8;
-			etm_ctx->trace_data[j + 1].packet = (trace_data[i] & 0x7800) >> 11;
-			etm_ctx->trace_data[j + 1].flags = 0;
-			if ((trace_data[i] & 0x8000) >> 15)
-				etm_ctx->trace_data[j + 1].flags |= ETMV1_TRACESYNC_CYCLE;
-			if (etm_ctx->trace_data[j + 1].pipestat == STAT_TR) {
-				etm_ctx->trace_data[j +
-				1].pipestat = etm_ctx->trace_data[j + 1].packet & 0x7;
-				etm_ctx->trace_data[j + 1].flags |= ETMV1_TRIGGER_CYCLE;
-			}
-
-			/* trace word j + 2 */
-			etm_ctx->trace_data[j + 2].pipestat = (trace_data[i] & 0x10000) >> 16;
-			etm_ctx->trace_data[j + 2].packet = (trace_data[i] & 0x780000) >> 19;
-			etm_ctx->trace_data[j + 2].flags = 0;
-			if ((trace_data[i] & 0x800000) >> 23)
-				etm_ctx->trace_data[j + 2].flags |= ETMV1_TRACESYNC_CYCLE;
-			if (etm_ctx->trace_data[j + 2].pipestat == STAT_TR) {
-				etm_ctx->trace_data[j +
-				2].pipestat = etm_ctx->trace_data[j + 2].packet & 0x7;
-				etm_ctx->trace_data[j + 2].flags |= ETMV1_TRIGGER_CYCLE;
-			}
-
-			j += 3;
-		} else if ((etm_ctx->control & ETM_PORT_WIDTH_MASK) == ETM_PORT_8BIT) {
-			/* trace word j */
-			etm_ctx->trace_data[j].pipestat = trace_data[i] & 0x7;
-			etm_ctx->trace_data[j].packet = (trace_data[i] & 0x7f8) >> 3;
-			etm_ctx->trace_data[j].flags = 0;
-			if ((trace_data[i] & 0x800) >> 11)
-				etm_ctx->trace_data[j].flags |= ETMV1_TRACESYNC_CYCLE;
-			if (etm_ctx->trace_data[j].pipestat == STAT_TR) {
-				etm_ctx->trace_data[j].pipestat = etm_ctx->trace_data[j].packet &
-					0x7;
-				etm_ctx->trace_data[j].flags |= ETMV1_TRIGGER_CYCLE;
-			}
-
-			/* trace word j + 1 */
-			etm_ctx->trace_data[j + 1].pipestat = (trace_data[i] & 0x7000) >> 12;
-			etm_ctx->trace_data[j + 1].packet = (trace_data[i] & 0x7f8000) >> 15;
-			etm_ctx->trace_data[j + 1].flags = 0;
-			if ((trace_data[i] & 0x800000) >> 23)
-				etm_ctx->trace_data[j + 1].flags |= ETMV1_TRACESYNC_CYCLE;
-			if (etm_ctx->trace_data[j + 1].pipestat == STAT_TR) {
-				etm_ctx->trace_data[j +
-				1].pipestat = etm_ctx->trace_data[j + 1].packet & 0x7;
-				etm_ctx->trace_data[j + 1].flags |= ETMV1_TRIGGER_CYCLE;
-			}
-
-			j += 2;
-		} else {
-			/* trace word j */
-			etm_ctx->trace_data[j].pipestat = trace_data[i] & 0x7;
-			etm_ctx->trace_data[j].packet = (trace_data[i] & 0x7fff8) >> 3;
-			etm_ctx->trace_data[j].flags = 0;
-			if ((trace_data[i] & 0x80000) >> 19)
-				etm_ctx->trace_data[j].flags |= ETMV1_TRACESYNC_CYCLE;
-			if (etm_ctx->trace_data[j].pipestat == STAT_TR) {
-				etm_ctx->trace_data[j].pipestat = etm_ctx->trace_data[j].packet &
-					0x7;
-				etm_ctx->trace_data[j].flags |= ETMV1_TRIGGER_CYCLE;
-			}
-
-			j += 1;
-		}
+	etm_ctx->trace_data = malloc(sizeof(struct etmv1_trace_data) * etm_ctx->trace_depth);
+	if (etm_ctx->trace_data == NULL) {
+		etm_ctx->trace_depth = 0;
+		free(trace_data);
+		return ERROR_FAIL;
 	}
 
+	etb_unpack_frames(layout, trace_data, num_frames, etm_ctx->trace_data);
+
 	free(trace_data);
 
 	return ERROR_OK;
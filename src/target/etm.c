@@ -26,6 +26,8 @@
 #include "arm_disassembler.h"
 #include "register.h"
 #include "etm_dummy.h"
+#include "etm_replay.h"
+#include <helper/time_support.h>
 
 #if BUILD_OOCD_TRACE == 1
 #include "oocd_trace.h"
@@ -294,7 +296,7 @@ static void etm_reg_add(unsigned bcd_vers, struct arm_jtag *jtag_info,
 struct reg_cache *etm_build_reg_cache(struct target *target,
 	struct arm_jtag *jtag_info, struct etm_context *etm_ctx)
 {
-	struct reg_cache *reg_cache = malloc(sizeof(struct reg_cache));
+	struct reg_cache *reg_cache = calloc(1, sizeof(struct reg_cache));
 	struct reg *reg_list = NULL;
 	struct etm_reg *arch_info = NULL;
 	unsigned bcd_vers, config;
@@ -642,64 +644,246 @@ static struct etm_capture_driver *etm_capture_drivers[] = {
 	NULL
 };
 
+/*
+ * Trace analysis looks up the same instructions over and over, so the image
+ * is decoded through a cache: the sections are sorted by address for a
+ * binary search, read into memory once, and every instruction is decoded
+ * the first time it is traced. Decoded instructions are kept in pages per
+ * core state, which are only allocated for code that actually executed.
+ */
+#define ETM_DECODE_PAGE_SHIFT	8
+#define ETM_DECODE_PAGE_SIZE	(1 << ETM_DECODE_PAGE_SHIFT)
+
+struct etm_decode_page {
+	uint8_t valid[ETM_DECODE_PAGE_SIZE / 8];
+	struct arm_instruction instructions[ETM_DECODE_PAGE_SIZE];
+};
+
+struct etm_decode_section {
+	uint32_t base_address;
+	uint32_t size;
+	int image_section;
+	/* section contents, read on first use */
+	uint8_t *data;
+	/* decoded instructions, [0] for ARM and [1] for Thumb state */
+	unsigned int num_pages[2];
+	struct etm_decode_page **pages[2];
+};
+
+struct etm_decode_cache {
+	int num_sections;
+	struct etm_decode_section *sections;
+	/* most lookups hit the section of the previous one */
+	struct etm_decode_section *last;
+	uint64_t decoded;
+	uint64_t lookups;
+};
+
+static int etm_decode_section_compare(const void *a, const void *b)
+{
+	const struct etm_decode_section *sa = a, *sb = b;
+
+	if (sa->base_address != sb->base_address)
+		return sa->base_address < sb->base_address ? -1 : 1;
+	/* keep image order, the first section containing an address wins */
+	return sa->image_section - sb->image_section;
+}
+
+static void etm_decode_cache_free(struct etm_context *ctx)
+{
+	struct etm_decode_cache *cache = ctx->decode_cache;
+
+	if (!cache)
+		return;
+
+	for (int i = 0; i < cache->num_sections; i++) {
+		struct etm_decode_section *section = &cache->sections[i];
+
+		for (int state = 0; state < 2; state++) {
+			for (unsigned int j = 0; j < section->num_pages[state]; j++)
+				free(section->pages[state][j]);
+			free(section->pages[state]);
+		}
+		free(section->data);
+	}
+	free(cache->sections);
+	free(cache);
+	ctx->decode_cache = NULL;
+}
+
+static int etm_decode_cache_build(struct etm_context *ctx)
+{
+	struct image *image = ctx->image;
+	struct etm_decode_cache *cache;
+
+	cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return ERROR_FAIL;
+
+	cache->sections = calloc(image->num_sections ? image->num_sections : 1,
+			sizeof(*cache->sections));
+	if (!cache->sections) {
+		free(cache);
+		return ERROR_FAIL;
+	}
+
+	for (int i = 0; i < image->num_sections; i++) {
+		if (image->sections[i].size == 0)
+			continue;
+
+		struct etm_decode_section *section = &cache->sections[cache->num_sections++];
+		section->base_address = image->sections[i].base_address;
+		section->size = image->sections[i].size;
+		section->image_section = i;
+	}
+
+	qsort(cache->sections, cache->num_sections, sizeof(*cache->sections),
+			etm_decode_section_compare);
+
+	ctx->decode_cache = cache;
+	return ERROR_OK;
+}
+
+static struct etm_decode_section *etm_decode_find_section(struct etm_decode_cache *cache,
+		uint32_t address)
+{
+	struct etm_decode_section *last = cache->last;
+
+	if (last && address - last->base_address < last->size)
+		return last;
+
+	/* find the last section starting at or below address */
+	int lo = 0, hi = cache->num_sections;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (cache->sections[mid].base_address <= address)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* a section starting lower may still be large enough to contain it */
+	for (int i = lo - 1; i >= 0; i--) {
+		struct etm_decode_section *section = &cache->sections[i];
+		if (address - section->base_address < section->size) {
+			cache->last = section;
+			return section;
+		}
+	}
+
+	return NULL;
+}
+
 static int etm_read_instruction(struct etm_context *ctx, struct arm_instruction *instruction)
 {
-	int i;
-	int section = -1;
+	struct etm_decode_cache *cache;
+	struct etm_decode_section *section;
+	unsigned int state, width;
 	size_t size_read;
-	uint32_t opcode;
+	uint32_t offset;
 	int retval;
 
 	if (!ctx->image)
 		return ERROR_TRACE_IMAGE_UNAVAILABLE;
 
-	/* search for the section the current instruction belongs to */
-	for (i = 0; i < ctx->image->num_sections; i++) {
-		if ((ctx->image->sections[i].base_address <= ctx->current_pc) &&
-			(ctx->image->sections[i].base_address + ctx->image->sections[i].size >
-			ctx->current_pc)) {
-			section = i;
-			break;
+	if (ctx->core_state == ARM_STATE_ARM) {
+		state = 0;
+		width = 4;
+	} else if (ctx->core_state == ARM_STATE_THUMB) {
+		state = 1;
+		width = 2;
+	} else if (ctx->core_state == ARM_STATE_JAZELLE) {
+		LOG_ERROR("BUG: tracing of jazelle code not supported");
+		return ERROR_FAIL;
+	} else {
+		LOG_ERROR("BUG: unknown core state encountered");
+		return ERROR_FAIL;
+	}
+
+	if (!ctx->decode_cache) {
+		retval = etm_decode_cache_build(ctx);
+		if (retval != ERROR_OK) {
+			LOG_ERROR("Out of memory");
+			return retval;
 		}
 	}
+	cache = ctx->decode_cache;
+	cache->lookups++;
 
-	if (section == -1) {
+	/* search for the section the current instruction belongs to */
+	section = etm_decode_find_section(cache, ctx->current_pc);
+	if (!section) {
 		/* current instruction couldn't be found in the image */
 		return ERROR_TRACE_INSTRUCTION_UNAVAILABLE;
 	}
 
-	if (ctx->core_state == ARM_STATE_ARM) {
-		uint8_t buf[4];
-		retval = image_read_section(ctx->image, section,
-				ctx->current_pc -
-				ctx->image->sections[section].base_address,
-				4, buf, &size_read);
-		if (retval != ERROR_OK) {
-			LOG_ERROR("error while reading instruction");
-			return ERROR_TRACE_INSTRUCTION_UNAVAILABLE;
+	offset = ctx->current_pc - section->base_address;
+	if (section->size - offset < width)
+		return ERROR_TRACE_INSTRUCTION_UNAVAILABLE;
+
+	if (!section->data) {
+		section->data = malloc(section->size);
+		if (!section->data) {
+			LOG_ERROR("Out of memory");
+			return ERROR_FAIL;
 		}
-		opcode = target_buffer_get_u32(ctx->target, buf);
-		arm_evaluate_opcode(opcode, ctx->current_pc, instruction);
-	} else if (ctx->core_state == ARM_STATE_THUMB) {
-		uint8_t buf[2];
-		retval = image_read_section(ctx->image, section,
-				ctx->current_pc -
-				ctx->image->sections[section].base_address,
-				2, buf, &size_read);
-		if (retval != ERROR_OK) {
+		retval = image_read_section(ctx->image, section->image_section, 0,
+				section->size, section->data, &size_read);
+		if (retval != ERROR_OK || size_read != section->size) {
 			LOG_ERROR("error while reading instruction");
+			free(section->data);
+			section->data = NULL;
 			return ERROR_TRACE_INSTRUCTION_UNAVAILABLE;
 		}
-		opcode = target_buffer_get_u16(ctx->target, buf);
-		thumb_evaluate_opcode(opcode, ctx->current_pc, instruction);
-	} else if (ctx->core_state == ARM_STATE_JAZELLE) {
-		LOG_ERROR("BUG: tracing of jazelle code not supported");
-		return ERROR_FAIL;
-	} else {
-		LOG_ERROR("BUG: unknown core state encountered");
-		return ERROR_FAIL;
 	}
 
+	/* Instructions are stored by their index from the start of the section;
+	 * one that isn't aligned to that is decoded without being cached. */
+	struct arm_instruction *slot = NULL;
+	if (offset % width == 0) {
+		uint32_t index = offset / width;
+		uint32_t page = index >> ETM_DECODE_PAGE_SHIFT;
+		uint32_t entry = index & (ETM_DECODE_PAGE_SIZE - 1);
+
+		if (!section->pages[state]) {
+			section->num_pages[state] =
+				((section->size / width) >> ETM_DECODE_PAGE_SHIFT) + 1;
+			section->pages[state] = calloc(section->num_pages[state],
+					sizeof(*section->pages[state]));
+			if (!section->pages[state]) {
+				section->num_pages[state] = 0;
+				LOG_ERROR("Out of memory");
+				return ERROR_FAIL;
+			}
+		}
+		if (!section->pages[state][page]) {
+			section->pages[state][page] = calloc(1, sizeof(struct etm_decode_page));
+			if (!section->pages[state][page]) {
+				LOG_ERROR("Out of memory");
+				return ERROR_FAIL;
+			}
+		}
+
+		struct etm_decode_page *p = section->pages[state][page];
+		slot = &p->instructions[entry];
+		if (p->valid[entry / 8] & (1 << (entry % 8))) {
+			*instruction = *slot;
+			return ERROR_OK;
+		}
+		p->valid[entry / 8] |= 1 << (entry % 8);
+	}
+
+	if (state == 0)
+		arm_evaluate_opcode(target_buffer_get_u32(ctx->target, section->data + offset),
+				ctx->current_pc, instruction);
+	else
+		thumb_evaluate_opcode(target_buffer_get_u16(ctx->target, section->data + offset),
+				ctx->current_pc, instruction);
+	cache->decoded++;
+
+	if (slot)
+		*slot = *instruction;
+
 	return ERROR_OK;
 }
 
@@ -1057,7 +1241,7 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_context *
 				if (shift >= 32)
 					ctx->ptr_ok = 1;
 
-				if (ctx->ptr_ok)
+				if (ctx->ptr_ok && !ctx->replay)
 					command_print(cmd_ctx,
 						"address: 0x%8.8" PRIx32 "",
 						ctx->last_ptr);
@@ -1073,9 +1257,10 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_context *
 							uint32_t data;
 							if (etmv1_data(ctx, 4, &data) != 0)
 								return ERROR_ETM_ANALYSIS_FAILED;
-							command_print(cmd_ctx,
-								"data: 0x%8.8" PRIx32 "",
-								data);
+							if (!ctx->replay)
+								command_print(cmd_ctx,
+									"data: 0x%8.8" PRIx32 "",
+									data);
 						}
 					}
 				} else if ((instruction.type >= ARM_LDR) &&
@@ -1084,7 +1269,8 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_context *
 					if (etmv1_data(ctx, arm_access_size(&instruction),
 						&data) != 0)
 						return ERROR_ETM_ANALYSIS_FAILED;
-					command_print(cmd_ctx, "data: 0x%8.8" PRIx32 "", data);
+					if (!ctx->replay)
+						command_print(cmd_ctx, "data: 0x%8.8" PRIx32 "", data);
 				}
 			}
 
@@ -1108,21 +1294,28 @@ static int etmv1_analyze_trace(struct etm_context *ctx, struct command_context *
 			next_pc += (ctx->core_state == ARM_STATE_ARM) ? 4 : 2;
 
 		if ((pipestat != STAT_TD) && (pipestat != STAT_WT)) {
-			char cycles_text[32] = "";
+			if (ctx->replay) {
+				/* profiling a saved capture, count instead of printing */
+				etm_replay_record(ctx->replay, ctx->current_pc, next_pc,
+					(ctx->core_state == ARM_STATE_ARM) ? 4 : 2,
+					pipestat != STAT_IN);
+			} else {
+				char cycles_text[32] = "";
 
-			/* if the trace was captured with cycle accurate tracing enabled,
-			 * output the number of cycles since the last executed instruction
-			 */
-			if (ctx->control & ETM_CTRL_CYCLE_ACCURATE) {
-				snprintf(cycles_text, 32, " (%i %s)",
-					(int)cycles,
-					(cycles == 1) ? "cycle" : "cycles");
-			}
+				/* if the trace was captured with cycle accurate tracing enabled,
+				 * output the number of cycles since the last executed instruction
+				 */
+				if (ctx->control & ETM_CTRL_CYCLE_ACCURATE) {
+					snprintf(cycles_text, 32, " (%i %s)",
+						(int)cycles,
+						(cycles == 1) ? "cycle" : "cycles");
+				}
 
-			command_print(cmd_ctx, "%s%s%s",
-				instruction.text,
-				(pipestat == STAT_IN) ? " (not executed)" : "",
-				cycles_text);
+				command_print(cmd_ctx, "%s%s%s",
+					instruction.text,
+					(pipestat == STAT_IN) ? " (not executed)" : "",
+					cycles_text);
+			}
 
 			ctx->current_pc = next_pc;
 
@@ -1648,6 +1841,27 @@ COMMAND_HANDLER(handle_etm_status_command)
 	return ERROR_OK;
 }
 
+static int etm_image_open(struct image **image_p, const char *url,
+	bool base_address_set, long long base_address, const char *type)
+{
+	struct image *image = malloc(sizeof(struct image));
+
+	if (!image)
+		return ERROR_FAIL;
+
+	image->base_address_set = base_address_set;
+	image->base_address = base_address;
+	image->start_address_set = 0;
+
+	if (image_open(image, url, type) != ERROR_OK) {
+		free(image);
+		return ERROR_FAIL;
+	}
+
+	*image_p = image;
+	return ERROR_OK;
+}
+
 COMMAND_HANDLER(handle_etm_image_command)
 {
 	struct target *target;
@@ -1671,30 +1885,19 @@ COMMAND_HANDLER(handle_etm_image_command)
 	}
 
 	if (etm_ctx->image) {
+		etm_decode_cache_free(etm_ctx);
 		image_close(etm_ctx->image);
 		free(etm_ctx->image);
 		command_print(CMD_CTX, "previously loaded image found and closed");
 	}
 
-	etm_ctx->image = malloc(sizeof(struct image));
-	etm_ctx->image->base_address_set = 0;
-	etm_ctx->image->start_address_set = 0;
-
+	long long base_address = 0;
 	/* a base address isn't always necessary, default to 0x0 (i.e. don't relocate) */
-	if (CMD_ARGC >= 2) {
-		etm_ctx->image->base_address_set = 1;
-		COMMAND_PARSE_NUMBER(llong, CMD_ARGV[1], etm_ctx->image->base_address);
-	} else
-		etm_ctx->image->base_address_set = 0;
+	if (CMD_ARGC >= 2)
+		COMMAND_PARSE_NUMBER(llong, CMD_ARGV[1], base_address);
 
-	if (image_open(etm_ctx->image, CMD_ARGV[0],
-		(CMD_ARGC >= 3) ? CMD_ARGV[2] : NULL) != ERROR_OK) {
-		free(etm_ctx->image);
-		etm_ctx->image = NULL;
-		return ERROR_FAIL;
-	}
-
-	return ERROR_OK;
+	return etm_image_open(&etm_ctx->image, CMD_ARGV[0], CMD_ARGC >= 2, base_address,
+			(CMD_ARGC >= 3) ? CMD_ARGV[2] : NULL);
 }
 
 COMMAND_HANDLER(handle_etm_dump_command)
@@ -1754,36 +1957,13 @@ COMMAND_HANDLER(handle_etm_dump_command)
 	return ERROR_OK;
 }
 
-COMMAND_HANDLER(handle_etm_load_command)
+/* Read trace data saved with "etm dump". */
+static int etm_read_capture(struct etm_context *etm_ctx, const char *filename)
 {
 	struct fileio *file;
-	struct target *target;
-	struct arm *arm;
-	struct etm_context *etm_ctx;
 	uint32_t i;
 
-	if (CMD_ARGC != 1)
-		return ERROR_COMMAND_SYNTAX_ERROR;
-
-	target = get_current_target(CMD_CTX);
-	arm = target_to_arm(target);
-	if (!is_arm(arm)) {
-		command_print(CMD_CTX, "ETM: current target isn't an ARM");
-		return ERROR_FAIL;
-	}
-
-	etm_ctx = arm->etm;
-	if (!etm_ctx) {
-		command_print(CMD_CTX, "current target doesn't have an ETM configured");
-		return ERROR_FAIL;
-	}
-
-	if (etm_ctx->capture_driver->status(etm_ctx) & TRACE_RUNNING) {
-		command_print(CMD_CTX, "trace capture running, stop first");
-		return ERROR_FAIL;
-	}
-
-	if (fileio_open(&file, CMD_ARGV[0], FILEIO_READ, FILEIO_BINARY) != ERROR_OK)
+	if (fileio_open(&file, filename, FILEIO_READ, FILEIO_BINARY) != ERROR_OK)
 		return ERROR_FAIL;
 
 	size_t filesize;
@@ -1794,7 +1974,7 @@ COMMAND_HANDLER(handle_etm_load_command)
 	}
 
 	if (filesize % 4) {
-		command_print(CMD_CTX, "size isn't a multiple of 4, no valid trace data");
+		LOG_ERROR("size isn't a multiple of 4, no valid trace data");
 		fileio_close(file);
 		return ERROR_FAIL;
 	}
@@ -1812,7 +1992,8 @@ COMMAND_HANDLER(handle_etm_load_command)
 	}
 	etm_ctx->trace_data = malloc(sizeof(struct etmv1_trace_data) * etm_ctx->trace_depth);
 	if (etm_ctx->trace_data == NULL) {
-		command_print(CMD_CTX, "not enough memory to perform operation");
+		LOG_ERROR("not enough memory to perform operation");
+		etm_ctx->trace_depth = 0;
 		fileio_close(file);
 		return ERROR_FAIL;
 	}
@@ -1832,6 +2013,36 @@ COMMAND_HANDLER(handle_etm_load_command)
 	return ERROR_OK;
 }
 
+COMMAND_HANDLER(handle_etm_load_command)
+{
+	struct target *target;
+	struct arm *arm;
+	struct etm_context *etm_ctx;
+
+	if (CMD_ARGC != 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	target = get_current_target(CMD_CTX);
+	arm = target_to_arm(target);
+	if (!is_arm(arm)) {
+		command_print(CMD_CTX, "ETM: current target isn't an ARM");
+		return ERROR_FAIL;
+	}
+
+	etm_ctx = arm->etm;
+	if (!etm_ctx) {
+		command_print(CMD_CTX, "current target doesn't have an ETM configured");
+		return ERROR_FAIL;
+	}
+
+	if (etm_ctx->capture_driver->status(etm_ctx) & TRACE_RUNNING) {
+		command_print(CMD_CTX, "trace capture running, stop first");
+		return ERROR_FAIL;
+	}
+
+	return etm_read_capture(etm_ctx, CMD_ARGV[0]);
+}
+
 COMMAND_HANDLER(handle_etm_start_command)
 {
 	struct target *target;
@@ -1982,7 +2193,23 @@ COMMAND_HANDLER(handle_etm_analyze_command)
 		return ERROR_FAIL;
 	}
 
+	struct duration bench;
+	uint64_t lookups = etm_ctx->decode_cache ? etm_ctx->decode_cache->lookups : 0;
+	uint64_t decoded = etm_ctx->decode_cache ? etm_ctx->decode_cache->decoded : 0;
+
+	duration_start(&bench);
 	retval = etmv1_analyze_trace(etm_ctx, CMD_CTX);
+	duration_measure(&bench);
+
+	if (etm_ctx->decode_cache) {
+		lookups = etm_ctx->decode_cache->lookups - lookups;
+		decoded = etm_ctx->decode_cache->decoded - decoded;
+		float elapsed = duration_elapsed(&bench);
+		LOG_INFO("analyzed %" PRIu64 " instructions (%" PRIu64 " decoded) "
+				"in %fs (%0.0f instructions/s)", lookups, decoded,
+				elapsed, elapsed > 0 ? lookups / elapsed : 0);
+	}
+
 	if (retval != ERROR_OK) {
 		/* FIX! error should be reported inside etmv1_analyze_trace() */
 		switch (retval) {
@@ -2005,6 +2232,101 @@ COMMAND_HANDLER(handle_etm_analyze_command)
 	return retval;
 }
 
+/* Profile a capture saved with "etm dump", without an ETM or debug adapter;
+ * the current target only supplies the byte order of the image. */
+COMMAND_HANDLER(handle_etm_replay_command)
+{
+	struct etm_context *ctx;
+	long long base_address = 0;
+	int retval;
+
+	if (CMD_ARGC < 2 || CMD_ARGC > 4)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC >= 3)
+		COMMAND_PARSE_NUMBER(llong, CMD_ARGV[2], base_address);
+
+	struct target *target = get_target_by_num(CMD_CTX->current_target);
+	if (!target) {
+		command_print(CMD_CTX, "a target is needed for the byte order of the image");
+		return ERROR_FAIL;
+	}
+
+	ctx = calloc(1, sizeof(struct etm_context));
+	if (!ctx)
+		return ERROR_FAIL;
+	ctx->target = target;
+	ctx->core_state = ARM_STATE_ARM;
+	ctx->replay = etm_replay_new();
+	if (!ctx->replay) {
+		free(ctx);
+		return ERROR_FAIL;
+	}
+
+	retval = etm_read_capture(ctx, CMD_ARGV[0]);
+	if (retval != ERROR_OK)
+		goto out;
+
+	retval = etm_image_open(&ctx->image, CMD_ARGV[1], CMD_ARGC >= 3, base_address,
+			(CMD_ARGC >= 4) ? CMD_ARGV[3] : NULL);
+	if (retval != ERROR_OK)
+		goto out;
+
+	/* symbols are only for the report, raw binaries don't have any */
+	if (ctx->image->type != IMAGE_ELF
+			|| etm_replay_load_symbols(ctx->replay, ctx->image, base_address) != ERROR_OK)
+		command_print(CMD_CTX, "no function symbols in %s", CMD_ARGV[1]);
+
+	if (ctx->trace_depth == 0) {
+		command_print(CMD_CTX, "Trace is empty.");
+		goto out;
+	}
+
+	struct duration bench;
+	duration_start(&bench);
+	retval = etmv1_analyze_trace(ctx, CMD_CTX);
+	duration_measure(&bench);
+
+	switch (retval) {
+		case ERROR_OK:
+			break;
+		case ERROR_ETM_ANALYSIS_FAILED:
+			/* a capture that ends mid-packet is normal, report what we have */
+			command_print(CMD_CTX,
+				"further analysis failed (corrupted trace data or just end of data");
+			retval = ERROR_OK;
+			break;
+		case ERROR_TRACE_INSTRUCTION_UNAVAILABLE:
+			command_print(CMD_CTX,
+				"no instruction for current address available, analysis aborted");
+			break;
+		default:
+			command_print(CMD_CTX, "trace analysis failed");
+			break;
+	}
+
+	etm_replay_report(ctx->replay, CMD_CTX, 20);
+
+	if (ctx->decode_cache) {
+		float elapsed = duration_elapsed(&bench);
+		LOG_INFO("replayed %" PRIu64 " instructions in %fs (%0.0f instructions/s)",
+				ctx->decode_cache->lookups, elapsed,
+				elapsed > 0 ? ctx->decode_cache->lookups / elapsed : 0);
+	}
+
+out:
+	if (ctx->image) {
+		etm_decode_cache_free(ctx);
+		image_close(ctx->image);
+		free(ctx->image);
+	}
+	free(ctx->trace_data);
+	etm_replay_free(ctx->replay);
+	free(ctx);
+
+	return retval;
+}
+
 static const struct command_registration etm_config_command_handlers[] = {
 	{
 		/* NOTE:  with ADIv5, ETMs are accessed by DAP operations,
@@ -2018,6 +2340,14 @@ static const struct command_registration etm_config_command_handlers[] = {
 		.help = "Set up ETM output port.",
 		.usage = "target port_width port_mode clocking capture_driver",
 	},
+	{
+		.name = "replay",
+		.handler = handle_etm_replay_command,
+		.mode = COMMAND_ANY,
+		.help = "Profile a saved trace capture against an image: "
+			"hottest instructions, functions and branches.",
+		.usage = "capture_file image_file [base_address [type]]",
+	},
 	COMMAND_REGISTRATION_DONE
 };
 const struct command_registration etm_command_handlers[] = {
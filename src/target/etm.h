@@ -154,6 +154,9 @@ struct etmv1_trace_data {
 	int flags;		/* ETMV1_TRACESYNC_CYCLE, ETMV1_TRIGGER_CYCLE */
 };
 
+struct etm_decode_cache;
+struct etm_replay;
+
 /* describe a trace context
  * if support for ETMv2 or ETMv3 is to be implemented,
  * this will have to be split into version independent elements
@@ -170,6 +173,8 @@ struct etm_context {
 	uint32_t control;	/* shadow of ETM_CTRL */
 	int /*arm_state*/ core_state;	/* current core state */
 	struct image *image;		/* source for target opcodes */
+	struct etm_decode_cache *decode_cache;	/* opcodes decoded from image */
+	struct etm_replay *replay;	/* profile instead of printing the trace */
 	uint32_t pipe_index;		/* current trace cycle */
 	uint32_t data_index;		/* cycle holding next data packet */
 	bool data_half;			/* port half on a 16 bit port */
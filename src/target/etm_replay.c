@@ -0,0 +1,380 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <helper/log.h>
+#include <helper/command.h>
+#include <helper/types.h>
+
+#include "image.h"
+#include "etm_replay.h"
+
+struct etm_replay_count {
+	/* address, or branch source and destination */
+	uint64_t key;
+	uint64_t executed;
+	uint64_t not_executed;
+};
+
+/* Open addressing hash table of counters. An entry is free while both of
+ * its counts are zero, as a counter is only created to be incremented. */
+struct etm_replay_table {
+	struct etm_replay_count *entries;
+	unsigned int bits;
+	size_t used;
+};
+
+struct etm_replay_symbol {
+	uint32_t address;
+	uint32_t size;
+	char *name;
+	uint64_t executed;
+};
+
+struct etm_replay {
+	struct etm_replay_table instructions;
+	struct etm_replay_table branches;
+	uint64_t executed;
+	uint64_t not_executed;
+	uint64_t taken;
+
+	struct etm_replay_symbol *symbols;
+	unsigned int num_symbols;
+};
+
+static size_t etm_replay_hash(uint64_t key, unsigned int bits)
+{
+	return (key * 0x9e3779b97f4a7c15ULL) >> (64 - bits);
+}
+
+static int etm_replay_table_grow(struct etm_replay_table *table)
+{
+	unsigned int bits = table->bits ? table->bits + 1 : 12;
+	struct etm_replay_count *entries = calloc((size_t)1 << bits, sizeof(*entries));
+
+	if (!entries)
+		return ERROR_FAIL;
+
+	size_t mask = ((size_t)1 << bits) - 1;
+	for (size_t i = 0; table->entries && i < ((size_t)1 << table->bits); i++) {
+		struct etm_replay_count *old = &table->entries[i];
+		if (!old->executed && !old->not_executed)
+			continue;
+
+		size_t j = etm_replay_hash(old->key, bits);
+		while (entries[j].executed || entries[j].not_executed)
+			j = (j + 1) & mask;
+		entries[j] = *old;
+	}
+
+	free(table->entries);
+	table->entries = entries;
+	table->bits = bits;
+	return ERROR_OK;
+}
+
+static struct etm_replay_count *etm_replay_table_get(struct etm_replay_table *table,
+		uint64_t key)
+{
+	/* keep the table at most half full */
+	if (2 * (table->used + 1) > ((size_t)1 << table->bits)) {
+		if (etm_replay_table_grow(table) != ERROR_OK)
+			return NULL;
+	}
+
+	size_t mask = ((size_t)1 << table->bits) - 1;
+	size_t i = etm_replay_hash(key, table->bits);
+	while (table->entries[i].executed || table->entries[i].not_executed) {
+		if (table->entries[i].key == key)
+			return &table->entries[i];
+		i = (i + 1) & mask;
+	}
+
+	table->used++;
+	table->entries[i].key = key;
+	return &table->entries[i];
+}
+
+/* Copy out the used entries, hottest first. */
+static int etm_replay_count_compare(const void *a, const void *b)
+{
+	const struct etm_replay_count *ca = a, *cb = b;
+
+	if (ca->executed != cb->executed)
+		return ca->executed > cb->executed ? -1 : 1;
+	if (ca->key != cb->key)
+		return ca->key < cb->key ? -1 : 1;
+	return 0;
+}
+
+static struct etm_replay_count *etm_replay_table_sorted(struct etm_replay_table *table)
+{
+	struct etm_replay_count *sorted = malloc((table->used + 1) * sizeof(*sorted));
+	size_t n = 0;
+
+	if (!sorted)
+		return NULL;
+
+	for (size_t i = 0; table->entries && i < ((size_t)1 << table->bits); i++) {
+		if (table->entries[i].executed || table->entries[i].not_executed)
+			sorted[n++] = table->entries[i];
+	}
+	qsort(sorted, n, sizeof(*sorted), etm_replay_count_compare);
+
+	return sorted;
+}
+
+struct etm_replay *etm_replay_new(void)
+{
+	return calloc(1, sizeof(struct etm_replay));
+}
+
+void etm_replay_free(struct etm_replay *replay)
+{
+	if (!replay)
+		return;
+
+	for (unsigned int i = 0; i < replay->num_symbols; i++)
+		free(replay->symbols[i].name);
+	free(replay->symbols);
+	free(replay->instructions.entries);
+	free(replay->branches.entries);
+	free(replay);
+}
+
+void etm_replay_record(struct etm_replay *replay, uint32_t address,
+		uint32_t next_address, unsigned int size, bool executed)
+{
+	struct etm_replay_count *count = etm_replay_table_get(&replay->instructions, address);
+
+	if (executed) {
+		replay->executed++;
+		if (count)
+			count->executed++;
+	} else {
+		replay->not_executed++;
+		if (count)
+			count->not_executed++;
+	}
+
+	if (next_address != address + size) {
+		replay->taken++;
+		count = etm_replay_table_get(&replay->branches,
+				(uint64_t)address << 32 | next_address);
+		if (count)
+			count->executed++;
+	}
+}
+
+static int etm_replay_symbol_compare(const void *a, const void *b)
+{
+	const struct etm_replay_symbol *sa = a, *sb = b;
+
+	if (sa->address != sb->address)
+		return sa->address < sb->address ? -1 : 1;
+	/* of several symbols for one address, prefer the sized one */
+	if (sa->size != sb->size)
+		return sa->size > sb->size ? -1 : 1;
+	return 0;
+}
+
+struct etm_replay_symbol_loader {
+	struct etm_replay *replay;
+	uint32_t offset;
+	unsigned int max_symbols;
+};
+
+static int etm_replay_add_symbol(void *priv, const char *name,
+		uint32_t value, uint32_t size, unsigned int type)
+{
+	struct etm_replay_symbol_loader *loader = priv;
+	struct etm_replay *replay = loader->replay;
+
+	if (type != STT_FUNC)
+		return ERROR_OK;
+
+	if (replay->num_symbols == loader->max_symbols) {
+		unsigned int max_symbols = loader->max_symbols ? 2 * loader->max_symbols : 256;
+		struct etm_replay_symbol *symbols = realloc(replay->symbols,
+				max_symbols * sizeof(*symbols));
+		if (!symbols)
+			return ERROR_FAIL;
+		replay->symbols = symbols;
+		loader->max_symbols = max_symbols;
+	}
+
+	struct etm_replay_symbol *s = &replay->symbols[replay->num_symbols];
+	/* bit 0 only marks Thumb code */
+	s->address = (value & ~1u) + loader->offset;
+	s->size = size;
+	s->executed = 0;
+	s->name = strdup(name);
+	if (!s->name)
+		return ERROR_FAIL;
+	replay->num_symbols++;
+
+	return ERROR_OK;
+}
+
+int etm_replay_load_symbols(struct etm_replay *replay, struct image *image,
+		uint32_t offset)
+{
+	struct etm_replay_symbol_loader loader = {
+		.replay = replay,
+		.offset = offset,
+		.max_symbols = replay->num_symbols,
+	};
+
+	int retval = image_elf_read_symbols(image, etm_replay_add_symbol, &loader);
+	if (retval != ERROR_OK)
+		return retval;
+
+	qsort(replay->symbols, replay->num_symbols, sizeof(*replay->symbols),
+			etm_replay_symbol_compare);
+	LOG_DEBUG("%u function symbols read", replay->num_symbols);
+
+	return ERROR_OK;
+}
+
+/* The function containing @a address; a symbol without a size is assumed to
+ * extend to the next one. */
+static struct etm_replay_symbol *etm_replay_find_symbol(struct etm_replay *replay,
+		uint32_t address)
+{
+	unsigned int lo = 0, hi = replay->num_symbols;
+
+	while (lo < hi) {
+		unsigned int mid = (lo + hi) / 2;
+		if (replay->symbols[mid].address <= address)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == 0)
+		return NULL;
+
+	struct etm_replay_symbol *s = &replay->symbols[lo - 1];
+	/* step back to the preferred symbol of that address */
+	while (s > replay->symbols && s[-1].address == s->address)
+		s--;
+	if (s->size && address - s->address >= s->size)
+		return NULL;
+	return s;
+}
+
+static void etm_replay_format_address(struct etm_replay *replay, uint32_t address,
+		char *buf, size_t size)
+{
+	struct etm_replay_symbol *s = etm_replay_find_symbol(replay, address);
+
+	if (s)
+		snprintf(buf, size, "0x%8.8" PRIx32 " %s+0x%" PRIx32, address, s->name,
+				address - s->address);
+	else
+		snprintf(buf, size, "0x%8.8" PRIx32, address);
+}
+
+static int etm_replay_hot_compare(const void *a, const void *b)
+{
+	const struct etm_replay_symbol *sa = *(const struct etm_replay_symbol * const *)a;
+	const struct etm_replay_symbol *sb = *(const struct etm_replay_symbol * const *)b;
+
+	if (sa->executed != sb->executed)
+		return sa->executed > sb->executed ? -1 : 1;
+	return strcmp(sa->name, sb->name);
+}
+
+void etm_replay_report(struct etm_replay *replay, struct command_context *cmd_ctx,
+		unsigned int count)
+{
+	struct etm_replay_count *sorted;
+	char from[128], to[128];
+	size_t n;
+
+	command_print(cmd_ctx, "%" PRIu64 " instructions executed, %" PRIu64
+			" not executed, %" PRIu64 " branches taken, %zu distinct addresses",
+			replay->executed, replay->not_executed, replay->taken,
+			replay->instructions.used);
+	if (replay->executed == 0)
+		return;
+
+	sorted = etm_replay_table_sorted(&replay->instructions);
+	if (!sorted) {
+		LOG_ERROR("Out of memory");
+		return;
+	}
+
+	command_print(cmd_ctx, "hottest instructions:");
+	n = MIN(count, replay->instructions.used);
+	for (size_t i = 0; i < n; i++) {
+		etm_replay_format_address(replay, sorted[i].key, from, sizeof(from));
+		command_print(cmd_ctx, "%12" PRIu64 " %5.1f%%  %s%s", sorted[i].executed,
+				100.0 * sorted[i].executed / replay->executed, from,
+				sorted[i].not_executed ? " (sometimes not executed)" : "");
+	}
+
+	/* attribute every instruction to its function */
+	if (replay->num_symbols) {
+		uint64_t unknown = 0;
+
+		for (unsigned int i = 0; i < replay->num_symbols; i++)
+			replay->symbols[i].executed = 0;
+		for (size_t i = 0; i < replay->instructions.used; i++) {
+			struct etm_replay_symbol *s = etm_replay_find_symbol(replay, sorted[i].key);
+			if (s)
+				s->executed += sorted[i].executed;
+			else
+				unknown += sorted[i].executed;
+		}
+
+		struct etm_replay_symbol **hot = malloc(replay->num_symbols * sizeof(*hot));
+		if (hot) {
+			for (unsigned int i = 0; i < replay->num_symbols; i++)
+				hot[i] = &replay->symbols[i];
+			qsort(hot, replay->num_symbols, sizeof(*hot), etm_replay_hot_compare);
+
+			command_print(cmd_ctx, "hottest functions:");
+			for (unsigned int i = 0; i < MIN(count, replay->num_symbols); i++) {
+				if (!hot[i]->executed)
+					break;
+				command_print(cmd_ctx, "%12" PRIu64 " %5.1f%%  %s", hot[i]->executed,
+						100.0 * hot[i]->executed / replay->executed, hot[i]->name);
+			}
+			if (unknown)
+				command_print(cmd_ctx, "%12" PRIu64 " %5.1f%%  (outside any function)",
+						unknown, 100.0 * unknown / replay->executed);
+			free(hot);
+		}
+	}
+	free(sorted);
+
+	sorted = etm_replay_table_sorted(&replay->branches);
+	if (!sorted) {
+		LOG_ERROR("Out of memory");
+		return;
+	}
+
+	command_print(cmd_ctx, "hottest branches:");
+	n = MIN(count, replay->branches.used);
+	for (size_t i = 0; i < n; i++) {
+		etm_replay_format_address(replay, sorted[i].key >> 32, from, sizeof(from));
+		etm_replay_format_address(replay, (uint32_t)sorted[i].key, to, sizeof(to));
+		command_print(cmd_ctx, "%12" PRIu64 "  %s -> %s", sorted[i].executed, from, to);
+	}
+	free(sorted);
+}
@@ -0,0 +1,53 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef OPENOCD_TARGET_ETM_REPLAY_H
+#define OPENOCD_TARGET_ETM_REPLAY_H
+
+struct command_context;
+struct image;
+
+/*
+ * Profile of a saved trace capture: how often every instruction executed,
+ * which branches were taken, and the functions that the time went to.
+ * Filled in by trace analysis instead of printing every instruction.
+ */
+struct etm_replay;
+
+struct etm_replay *etm_replay_new(void);
+void etm_replay_free(struct etm_replay *replay);
+
+/**
+ * Count one traced instruction.
+ * @param address Address of the instruction.
+ * @param next_address Address of the instruction that followed it.
+ * @param size Instruction size, a different @a next_address is a branch.
+ * @param executed False if the instruction failed its condition code.
+ */
+void etm_replay_record(struct etm_replay *replay, uint32_t address,
+		uint32_t next_address, unsigned int size, bool executed);
+
+/**
+ * Read the function symbols of an ELF image, to attribute instructions to
+ * functions. @a offset is added to every symbol, like an image base address.
+ */
+int etm_replay_load_symbols(struct etm_replay *replay, struct image *image,
+		uint32_t offset);
+
+/** Print the @a count hottest instructions, branches and functions. */
+void etm_replay_report(struct etm_replay *replay, struct command_context *cmd_ctx,
+		unsigned int count);
+
+#endif /* OPENOCD_TARGET_ETM_REPLAY_H */
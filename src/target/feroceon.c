@@ -717,6 +717,7 @@ struct target_type feroceon_target = {
 
 	.checksum_memory = arm_checksum_memory,
 	.blank_check_memory = arm_blank_check_memory,
+	.blank_check_memory_blocks = arm_blank_check_memory_blocks,
 
 	.run_algorithm = armv4_5_run_algorithm,
 
@@ -728,6 +729,7 @@ struct target_type feroceon_target = {
 	.commands = arm926ejs_command_handlers,
 	.target_create = feroceon_target_create,
 	.init_target = feroceon_init_target,
+	.deinit_target = arm7_9_deinit_target,
 	.examine = feroceon_examine,
 };
 
@@ -754,6 +756,7 @@ struct target_type dragonite_target = {
 
 	.checksum_memory = arm_checksum_memory,
 	.blank_check_memory = arm_blank_check_memory,
+	.blank_check_memory_blocks = arm_blank_check_memory_blocks,
 
 	.run_algorithm = armv4_5_run_algorithm,
 
@@ -765,5 +768,6 @@ struct target_type dragonite_target = {
 	.commands = arm966e_command_handlers,
 	.target_create = dragonite_target_create,
 	.init_target = feroceon_init_target,
+	.deinit_target = arm7_9_deinit_target,
 	.examine = feroceon_examine,
 };
@@ -938,6 +938,108 @@ int image_add_section(struct image *image, uint32_t base, uint32_t size, int fla
 	return ERROR_OK;
 }
 
+/**
+ * Reads the symbol table of an ELF image opened with image_open() and calls
+ * @a handler for each symbol that has a name.
+ */
+int image_elf_read_symbols(struct image *image,
+		image_elf_symbol_handler_t handler, void *priv)
+{
+	struct image_elf *elf = image->type_private;
+	Elf32_Shdr *shdrs = NULL, *symtab = NULL, *strhdr;
+	Elf32_Sym *syms = NULL;
+	char *strtab = NULL;
+	uint32_t shoff, syms_size, str_size;
+	uint16_t shnum;
+	size_t read_bytes;
+	int retval;
+
+	if (image->type != IMAGE_ELF)
+		return ERROR_IMAGE_TYPE_UNKNOWN;
+
+	shoff = field32(elf, elf->header->e_shoff);
+	shnum = field16(elf, elf->header->e_shnum);
+	if (shoff == 0 || shnum == 0
+			|| field16(elf, elf->header->e_shentsize) != sizeof(Elf32_Shdr)) {
+		LOG_ERROR("invalid ELF file, no section headers");
+		return ERROR_IMAGE_FORMAT_ERROR;
+	}
+
+	shdrs = malloc(shnum * sizeof(Elf32_Shdr));
+	if (shdrs == NULL) {
+		LOG_ERROR("insufficient memory to perform operation ");
+		return ERROR_FILEIO_OPERATION_FAILED;
+	}
+
+	retval = fileio_seek(elf->fileio, shoff);
+	if (retval == ERROR_OK)
+		retval = fileio_read(elf->fileio, shnum * sizeof(Elf32_Shdr),
+				(uint8_t *)shdrs, &read_bytes);
+	if (retval != ERROR_OK || read_bytes != shnum * sizeof(Elf32_Shdr)) {
+		LOG_ERROR("cannot read ELF section headers");
+		retval = ERROR_FILEIO_OPERATION_FAILED;
+		goto out;
+	}
+
+	/* the symbol table and the string table it links to */
+	for (unsigned int i = 0; i < shnum; i++) {
+		if (field32(elf, shdrs[i].sh_type) == SHT_SYMTAB) {
+			symtab = &shdrs[i];
+			break;
+		}
+	}
+	if (symtab == NULL || field32(elf, symtab->sh_link) >= shnum) {
+		LOG_ERROR("ELF file has no symbol table");
+		retval = ERROR_IMAGE_FORMAT_ERROR;
+		goto out;
+	}
+	strhdr = &shdrs[field32(elf, symtab->sh_link)];
+
+	syms_size = field32(elf, symtab->sh_size);
+	str_size = field32(elf, strhdr->sh_size);
+	syms = malloc(syms_size);
+	strtab = malloc(str_size + 1);
+	if (syms == NULL || strtab == NULL) {
+		LOG_ERROR("insufficient memory to perform operation ");
+		retval = ERROR_FILEIO_OPERATION_FAILED;
+		goto out;
+	}
+
+	retval = fileio_seek(elf->fileio, field32(elf, symtab->sh_offset));
+	if (retval == ERROR_OK)
+		retval = fileio_read(elf->fileio, syms_size, (uint8_t *)syms, &read_bytes);
+	if (retval == ERROR_OK && read_bytes == syms_size)
+		retval = fileio_seek(elf->fileio, field32(elf, strhdr->sh_offset));
+	if (retval == ERROR_OK)
+		retval = fileio_read(elf->fileio, str_size, (uint8_t *)strtab, &read_bytes);
+	if (retval != ERROR_OK || read_bytes != str_size) {
+		LOG_ERROR("cannot read ELF symbol table");
+		retval = ERROR_FILEIO_OPERATION_FAILED;
+		goto out;
+	}
+	strtab[str_size] = 0;
+
+	for (uint32_t i = 0; i < syms_size / sizeof(Elf32_Sym); i++) {
+		uint32_t name = field32(elf, syms[i].st_name);
+
+		if (name == 0 || name >= str_size)
+			continue;
+
+		retval = handler(priv, strtab + name, field32(elf, syms[i].st_value),
+				field32(elf, syms[i].st_size), ELF32_ST_TYPE(syms[i].st_info));
+		if (retval != ERROR_OK)
+			goto out;
+	}
+
+	retval = ERROR_OK;
+
+out:
+	free(strtab);
+	free(syms);
+	free(shdrs);
+	return retval;
+}
+
 void image_close(struct image *image)
 {
 	if (image->type == IMAGE_BINARY) {
@@ -99,6 +99,13 @@ void image_close(struct image *image);
 int image_add_section(struct image *image, uint32_t base, uint32_t size,
 		int flags, uint8_t const *data);
 
+/* Called for each symbol of an ELF image, @a type being its STT_* type */
+typedef int (*image_elf_symbol_handler_t)(void *priv, const char *name,
+		uint32_t value, uint32_t size, unsigned int type);
+
+int image_elf_read_symbols(struct image *image,
+		image_elf_symbol_handler_t handler, void *priv);
+
 int image_calculate_checksum(uint8_t *buffer, uint32_t nbytes,
 		uint32_t *checksum);
 
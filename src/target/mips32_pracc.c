@@ -99,17 +99,40 @@ static int wait_for_pracc_rw(struct mips_ejtag *ejtag_info)
 	return ERROR_OK;
 }
 
-/* Shift in control and address for a new processor access, save them in ejtag_info */
+/* Shift in control and address for a new processor access, save them in ejtag_info.
+ * Both scans are queued together so every poll costs a single queue flush;
+ * the address is only taken into account once PrAcc is seen pending. */
 static int mips32_pracc_read_ctrl_addr(struct mips_ejtag *ejtag_info)
 {
-	int retval = wait_for_pracc_rw(ejtag_info);
-	if (retval != ERROR_OK)
-		return retval;
+	int64_t then = timeval_ms();
+	uint8_t ctrl_in[4];
+	uint8_t addr_in[4];
 
-	mips_ejtag_set_instr(ejtag_info, EJTAG_INST_ADDRESS);
+	while (1) {
+		mips_ejtag_set_instr(ejtag_info, EJTAG_INST_CONTROL);
+		mips_ejtag_drscan_32_queued(ejtag_info, ejtag_info->ejtag_ctrl, ctrl_in);
+		mips_ejtag_set_instr(ejtag_info, EJTAG_INST_ADDRESS);
+		mips_ejtag_drscan_32_queued(ejtag_info, 0, addr_in);
+
+		int retval = jtag_execute_queue();
+		if (retval != ERROR_OK) {
+			LOG_ERROR("register read failed");
+			return retval;
+		}
+
+		ejtag_info->pa_ctrl = buf_get_u32(ctrl_in, 0, 32);
+		if (ejtag_info->pa_ctrl & EJTAG_CTRL_PRACC)
+			break;
 
-	ejtag_info->pa_addr = 0;
-	return  mips_ejtag_drscan_32(ejtag_info, &ejtag_info->pa_addr);
+		int64_t timeout = timeval_ms() - then;
+		if (timeout > 1000) {
+			LOG_DEBUG("DEBUGMODULE: No memory access in progress!");
+			return ERROR_JTAG_DEVICE_ERROR;
+		}
+	}
+
+	ejtag_info->pa_addr = buf_get_u32(addr_in, 0, 32);
+	return ERROR_OK;
 }
 
 /* Finish processor access */
@@ -44,6 +44,8 @@ static int mips_m4k_internal_restore(struct target *target, int current,
 		target_addr_t address, int handle_breakpoints,
 		int debug_execution);
 static int mips_m4k_halt(struct target *target);
+static int mips_m4k_bulk_read_memory(struct target *target, target_addr_t address,
+		uint32_t count, uint8_t *buffer);
 static int mips_m4k_bulk_write_memory(struct target *target, target_addr_t address,
 		uint32_t count, const uint8_t *buffer);
 
@@ -1037,6 +1039,13 @@ static int mips_m4k_read_memory(struct target *target, target_addr_t address,
 	if (((size == 4) && (address & 0x3u)) || ((size == 2) && (address & 0x1u)))
 		return ERROR_TARGET_UNALIGNED_ACCESS;
 
+	if (size == 4 && count > 32) {
+		int retval = mips_m4k_bulk_read_memory(target, address, count, buffer);
+		if (retval == ERROR_OK)
+			return ERROR_OK;
+		LOG_DEBUG("Falling back to non-bulk read");
+	}
+
 	/* since we don't know if buffer is aligned, we allocate new mem that is always aligned */
 	void *t = NULL;
 
@@ -1200,17 +1209,15 @@ static int mips_m4k_examine(struct target *target)
 	return mips32_examine(target);
 }
 
-static int mips_m4k_bulk_write_memory(struct target *target, target_addr_t address,
-		uint32_t count, const uint8_t *buffer)
+/* Transfer count words between host buffer (host endianness) and target memory
+ * through the EJTAG fastdata register, using the handler kept in fast_data_area */
+static int mips_m4k_bulk_xfer(struct target *target, int write_t, target_addr_t address,
+		uint32_t count, uint32_t *buf)
 {
 	struct mips32_common *mips32 = target_to_mips32(target);
 	struct mips_ejtag *ejtag_info = &mips32->ejtag_info;
 	struct working_area *fast_data_area;
 	int retval;
-	int write_t = 1;
-
-	LOG_DEBUG("address: " TARGET_ADDR_FMT ", count: 0x%8.8" PRIx32 "",
-			  address, count);
 
 	/* check alignment */
 	if (address & 0x3u)
@@ -1225,7 +1232,7 @@ static int mips_m4k_bulk_write_memory(struct target *target, target_addr_t addre
 				MIPS32_FASTDATA_HANDLER_SIZE,
 				&mips32->fast_data_area);
 		if (retval != ERROR_OK) {
-			LOG_ERROR("No working area available");
+			LOG_DEBUG("No working area available");
 			return retval;
 		}
 
@@ -1235,19 +1242,62 @@ static int mips_m4k_bulk_write_memory(struct target *target, target_addr_t addre
 
 	fast_data_area = mips32->fast_data_area;
 
-	if (address <= fast_data_area->address + fast_data_area->size &&
-			fast_data_area->address <= address + count) {
+	/* the handler lives in fast_data_area, so a transfer overlapping it
+	 * would read back the handler or overwrite it while it runs */
+	if (address < fast_data_area->address + fast_data_area->size &&
+			fast_data_area->address < address + count * 4) {
+		if (!write_t) {
+			LOG_DEBUG("fast_data (" TARGET_ADDR_FMT ") is within read area",
+				  fast_data_area->address);
+			return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+		}
 		LOG_ERROR("fast_data (" TARGET_ADDR_FMT ") is within write area "
 			  "(" TARGET_ADDR_FMT "-" TARGET_ADDR_FMT ").",
-			  fast_data_area->address, address, address + count);
+			  fast_data_area->address, address, address + count * 4);
 		LOG_ERROR("Change work-area-phys or load_image address!");
 		return ERROR_FAIL;
 	}
 
+	retval = mips32_pracc_fastdata_xfer(ejtag_info, fast_data_area, write_t, address,
+			count, buf);
+
+	if (retval != ERROR_OK)
+		LOG_ERROR("Fastdata access Failed");
+
+	return retval;
+}
+
+static int mips_m4k_bulk_read_memory(struct target *target, target_addr_t address,
+		uint32_t count, uint8_t *buffer)
+{
+	LOG_DEBUG("address: " TARGET_ADDR_FMT ", count: 0x%8.8" PRIx32 "",
+			  address, count);
+
+	/* mips32_pracc_fastdata_xfer returns uint32_t in host endianness, */
+	/* but byte array should represent target endianness               */
+	uint32_t *t = malloc(count * sizeof(uint32_t));
+	if (t == NULL) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
+
+	int retval = mips_m4k_bulk_xfer(target, 0, address, count, t);
+	if (retval == ERROR_OK)
+		target_buffer_set_u32_array(target, buffer, count, t);
+
+	free(t);
+	return retval;
+}
+
+static int mips_m4k_bulk_write_memory(struct target *target, target_addr_t address,
+		uint32_t count, const uint8_t *buffer)
+{
+	LOG_DEBUG("address: " TARGET_ADDR_FMT ", count: 0x%8.8" PRIx32 "",
+			  address, count);
+
 	/* mips32_pracc_fastdata_xfer requires uint32_t in host endianness, */
 	/* but byte array represents target endianness                      */
-	uint32_t *t = NULL;
-	t = malloc(count * sizeof(uint32_t));
+	uint32_t *t = malloc(count * sizeof(uint32_t));
 	if (t == NULL) {
 		LOG_ERROR("Out of memory");
 		return ERROR_FAIL;
@@ -1255,15 +1305,9 @@ static int mips_m4k_bulk_write_memory(struct target *target, target_addr_t addre
 
 	target_buffer_get_u32_array(target, buffer, count, t);
 
-	retval = mips32_pracc_fastdata_xfer(ejtag_info, mips32->fast_data_area, write_t, address,
-			count, t);
-
-	if (t != NULL)
-		free(t);
-
-	if (retval != ERROR_OK)
-		LOG_ERROR("Fastdata access Failed");
+	int retval = mips_m4k_bulk_xfer(target, 1, address, count, t);
 
+	free(t);
 	return retval;
 }
 
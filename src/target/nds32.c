@@ -997,7 +997,7 @@ int nds32_arch_state(struct target *target)
 			nds32->virtual_hosting ? ", virtual hosting" : "");
 
 	/* save pc value to pseudo register pc */
-	struct reg *reg = register_get_by_name(target->reg_cache, "pc", 1);
+	struct reg *reg = register_get_common(target->reg_cache, REG_COMMON_PC);
 	buf_set_u32(reg->value, 0, 32, value_pc);
 
 	return ERROR_OK;
@@ -1469,7 +1469,7 @@ int nds32_add_software_breakpoint(struct target *target,
 	memcpy(breakpoint->orig_instr, &data, breakpoint->length);
 
 	/* self-modified code */
-	target->type->write_buffer(target, breakpoint->address, breakpoint->length, (const uint8_t *)&break_insn);
+	target_write_buffer(target, breakpoint->address, breakpoint->length, (const uint8_t *)&break_insn);
 	/* write_back & invalidate dcache & invalidate icache */
 	nds32_cache_sync(target, breakpoint->address, breakpoint->length);
 
@@ -1502,7 +1502,7 @@ int nds32_remove_software_breakpoint(struct target *target,
 		return ERROR_FAIL;
 
 	/* self-modified code */
-	target->type->write_buffer(target, breakpoint->address, breakpoint->length,
+	target_write_buffer(target, breakpoint->address, breakpoint->length,
 			breakpoint->orig_instr);
 
 	/* write_back & invalidate dcache & invalidate icache */
@@ -36,7 +36,164 @@
  * may be separate registers associated with debug or trace modules.
  */
 
-struct reg *register_get_by_name(struct reg_cache *first,
+/*
+ * Name lookups go through a hash index over the chain of caches starting
+ * at the cache passed in, built on first use and kept in that cache. Some
+ * targets link caches by assigning ->next directly, so an index is checked
+ * against the chain on every lookup and rebuilt when the chain no longer
+ * matches; linking and unlinking through the functions below drops the
+ * index of the chain right away.
+ */
+
+/* Position of a cache in the chain when its index was built */
+struct reg_index_cache {
+	const struct reg_cache *cache;
+	const struct reg *reg_list;
+	unsigned num_regs;
+};
+
+struct reg_index_entry {
+	struct reg *reg;
+	/* number of the cache in the chain, 0 being the first one */
+	unsigned cache_num;
+};
+
+struct reg_index {
+	struct reg_index_cache *caches;
+	unsigned num_caches;
+	/* open addressing, the size is a power of two */
+	struct reg_index_entry *table;
+	unsigned table_size;
+	/* resolved when the index is built, see register_get_common() */
+	struct reg_index_entry common[REG_COMMON_COUNT];
+};
+
+static const char * const reg_common_names[REG_COMMON_COUNT] = {
+	[REG_COMMON_PC] = "pc",
+	[REG_COMMON_SP] = "sp",
+	[REG_COMMON_CPSR] = "cpsr",
+};
+
+/* FNV-1a */
+static uint32_t register_name_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+static void register_index_free(struct reg_index *index)
+{
+	if (index == NULL)
+		return;
+
+	free(index->caches);
+	free(index->table);
+	free(index);
+}
+
+static bool register_index_matches(const struct reg_index *index, const struct reg_cache *first)
+{
+	const struct reg_cache *cache = first;
+	unsigned i;
+
+	for (i = 0; cache && i < index->num_caches; i++, cache = cache->next) {
+		if (index->caches[i].cache != cache
+				|| index->caches[i].reg_list != cache->reg_list
+				|| index->caches[i].num_regs != cache->num_regs)
+			return false;
+	}
+
+	return cache == NULL && i == index->num_caches;
+}
+
+static const struct reg_index_entry *register_index_find(const struct reg_index *index,
+		const char *name)
+{
+	unsigned mask = index->table_size - 1;
+
+	for (unsigned i = register_name_hash(name) & mask; index->table[i].reg; i = (i + 1) & mask) {
+		if (strcmp(index->table[i].reg->name, name) == 0)
+			return &index->table[i];
+	}
+
+	return NULL;
+}
+
+static struct reg_index *register_index_build(struct reg_cache *first)
+{
+	struct reg_index *index = calloc(1, sizeof(*index));
+	unsigned num_regs = 0;
+	struct reg_cache *cache;
+
+	if (index == NULL)
+		return NULL;
+
+	for (cache = first; cache; cache = cache->next) {
+		index->num_caches++;
+		num_regs += cache->num_regs;
+	}
+
+	/* keep the table at most half full */
+	index->table_size = 16;
+	while (index->table_size < 2 * num_regs)
+		index->table_size *= 2;
+
+	index->caches = calloc(index->num_caches, sizeof(*index->caches));
+	index->table = calloc(index->table_size, sizeof(*index->table));
+	if (index->caches == NULL || index->table == NULL) {
+		register_index_free(index);
+		return NULL;
+	}
+
+	unsigned cache_num = 0;
+	for (cache = first; cache; cache = cache->next, cache_num++) {
+		index->caches[cache_num].cache = cache;
+		index->caches[cache_num].reg_list = cache->reg_list;
+		index->caches[cache_num].num_regs = cache->num_regs;
+
+		for (unsigned i = 0; i < cache->num_regs; i++) {
+			struct reg *reg = &cache->reg_list[i];
+			unsigned mask = index->table_size - 1;
+			unsigned slot = register_name_hash(reg->name) & mask;
+
+			/* like a linear search, the first register of a name wins */
+			while (index->table[slot].reg && strcmp(index->table[slot].reg->name, reg->name) != 0)
+				slot = (slot + 1) & mask;
+			if (index->table[slot].reg)
+				continue;
+
+			index->table[slot].reg = reg;
+			index->table[slot].cache_num = cache_num;
+		}
+	}
+
+	for (unsigned i = 0; i < REG_COMMON_COUNT; i++) {
+		const struct reg_index_entry *entry = register_index_find(index, reg_common_names[i]);
+		if (entry)
+			index->common[i] = *entry;
+	}
+
+	return index;
+}
+
+static struct reg_index *register_index_get(struct reg_cache *first)
+{
+	if (first->index && register_index_matches(first->index, first))
+		return first->index;
+
+	register_index_free(first->index);
+	first->index = register_index_build(first);
+
+	return first->index;
+}
+
+static struct reg *register_get_by_name_slow(struct reg_cache *first,
 		const char *name, bool search_all)
 {
 	unsigned i;
@@ -57,10 +214,54 @@ struct reg *register_get_by_name(struct reg_cache *first,
 	return NULL;
 }
 
+struct reg *register_get_by_name(struct reg_cache *first,
+		const char *name, bool search_all)
+{
+	if (first == NULL)
+		return NULL;
+
+	struct reg_index *index = register_index_get(first);
+	if (index == NULL)
+		return register_get_by_name_slow(first, name, search_all);
+
+	const struct reg_index_entry *entry = register_index_find(index, name);
+	if (entry == NULL) {
+		/* a register renamed in place would not be found in the index */
+		return register_get_by_name_slow(first, name, search_all);
+	}
+
+	if (!search_all && entry->cache_num != 0)
+		return NULL;
+
+	return entry->reg;
+}
+
+/**
+ * Looks up one of the registers most targets have and many commands need,
+ * without hashing its name. Like register_get_by_name() with search_all set.
+ */
+struct reg *register_get_common(struct reg_cache *first, enum reg_common which)
+{
+	assert(which < REG_COMMON_COUNT);
+
+	if (first == NULL)
+		return NULL;
+
+	struct reg_index *index = register_index_get(first);
+	if (index == NULL)
+		return register_get_by_name_slow(first, reg_common_names[which], true);
+
+	return index->common[which].reg;
+}
+
 struct reg_cache **register_get_last_cache_p(struct reg_cache **first)
 {
 	struct reg_cache **cache_p = first;
 
+	/* the caller is about to link another cache to this chain */
+	if (*first)
+		register_cache_free_index(*first);
+
 	if (*cache_p)
 		while (*cache_p)
 			cache_p = &((*cache_p)->next);
@@ -72,6 +273,11 @@ struct reg_cache **register_get_last_cache_p(struct reg_cache **first)
 
 void register_unlink_cache(struct reg_cache **cache_p, const struct reg_cache *cache)
 {
+	/* other chains containing the cache see the change on their next
+	 * lookup; the cache's own index goes when the caller frees it */
+	if (*cache_p)
+		register_cache_free_index(*cache_p);
+
 	while (*cache_p && *cache_p != cache)
 		cache_p = &((*cache_p)->next);
 	if (*cache_p)
@@ -89,6 +295,13 @@ void register_cache_invalidate(struct reg_cache *cache)
 	}
 }
 
+/** Frees the name lookup index of the chain starting at @a cache. */
+void register_cache_free_index(struct reg_cache *cache)
+{
+	register_index_free(cache->index);
+	cache->index = NULL;
+}
+
 static int register_get_dummy_core_reg(struct reg *reg)
 {
 	return ERROR_OK;
@@ -144,11 +144,16 @@ struct reg {
 	const struct reg_arch_type *type;
 };
 
+struct reg_index;
+
 struct reg_cache {
 	const char *name;
 	struct reg_cache *next;
 	struct reg *reg_list;
 	unsigned num_regs;
+	/* name lookup index of the chain starting here, built on first use;
+	 * free it with register_cache_free_index() before freeing the cache */
+	struct reg_index *index;
 };
 
 struct reg_arch_type {
@@ -156,11 +161,21 @@ struct reg_arch_type {
 	int (*set)(struct reg *reg, uint8_t *buf);
 };
 
+/* Registers with a cached lookup, see register_get_common() */
+enum reg_common {
+	REG_COMMON_PC,
+	REG_COMMON_SP,
+	REG_COMMON_CPSR,
+	REG_COMMON_COUNT,
+};
+
 struct reg *register_get_by_name(struct reg_cache *first,
 		const char *name, bool search_all);
+struct reg *register_get_common(struct reg_cache *first, enum reg_common which);
 struct reg_cache **register_get_last_cache_p(struct reg_cache **first);
 void register_unlink_cache(struct reg_cache **cache_p, const struct reg_cache *cache);
 void register_cache_invalidate(struct reg_cache *cache);
+void register_cache_free_index(struct reg_cache *cache);
 
 void register_init_dummy(struct reg *reg);
 
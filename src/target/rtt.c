@@ -0,0 +1,711 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+/**
+ * @file
+ * Real Time Transfer (RTT) style data channels.
+ *
+ * Target software keeps a control block in RAM, starting with an
+ * identifier string and followed by descriptors of "up" (target to host)
+ * and "down" (host to target) ring buffers. The control block is located
+ * once by searching target memory; afterwards the ring buffers are
+ * drained from a timer callback with bulk memory accesses, which on cores
+ * with a memory access port (e.g. Cortex-M) works while the target keeps
+ * running, so logging costs no halts at all.
+ *
+ * The poll rate adapts to the data volume: while a poll moves data the
+ * next one follows after RTT_MIN_POLLING_INTERVAL, otherwise the delay
+ * doubles up to the configured polling interval.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <helper/log.h>
+#include <helper/command.h>
+#include <helper/time_support.h>
+
+#include "target.h"
+#include "rtt.h"
+
+/* Control block layout: identifier, number of up and down buffers,
+ * followed by the up and then the down buffer descriptors. */
+#define RTT_CB_NUM_UP_OFFSET		16
+#define RTT_CB_NUM_DOWN_OFFSET		20
+#define RTT_CB_BUFFERS_OFFSET		24
+#define RTT_BUFFER_DESC_SIZE		24
+#define RTT_BUFFER_WR_OFF_OFFSET	12
+#define RTT_BUFFER_RD_OFF_OFFSET	16
+
+/* Sanity limit on the channel counts read from target memory. */
+#define RTT_MAX_CHANNELS		64
+
+/* Search window, large enough to amortize the per transfer overhead. */
+#define RTT_SEARCH_CHUNK		1024
+
+#define RTT_MIN_POLLING_INTERVAL	1
+#define RTT_DEFAULT_POLLING_INTERVAL	10
+
+struct rtt_sink {
+	unsigned int channel;
+	rtt_sink_write_t write;
+	rtt_sink_poll_t poll;
+	void *priv;
+	struct rtt_sink *next;
+};
+
+static struct {
+	struct target *target;
+	bool configured;
+	bool started;
+	target_addr_t search_addr;
+	uint32_t search_size;
+	char id[RTT_CB_MAX_ID_LENGTH];
+
+	uint32_t cb_address;
+	unsigned int num_up;
+	unsigned int num_down;
+	struct rtt_buffer *up;
+	struct rtt_buffer *down;
+
+	/* scratch memory for descriptor and data reads */
+	uint8_t *desc_buf;
+	uint8_t *data_buf;
+	uint32_t data_buf_size;
+
+	struct rtt_sink *sinks;
+	unsigned int polling_interval;
+	/* current adaptive delay and time of the next poll */
+	unsigned int poll_delay;
+	int64_t next_poll;
+	int64_t start_time;
+	uint64_t polls;
+	bool got_data;
+	bool read_failed;
+} rtt = {
+	.polling_interval = RTT_DEFAULT_POLLING_INTERVAL,
+};
+
+bool rtt_got_data(void)
+{
+	bool t = rtt.got_data;
+	rtt.got_data = false;
+	return t;
+}
+
+int rtt_register_sink(unsigned int channel, rtt_sink_write_t write,
+		rtt_sink_poll_t poll, void *priv)
+{
+	struct rtt_sink *sink = malloc(sizeof(*sink));
+	if (sink == NULL) {
+		LOG_ERROR("Out of memory");
+		return ERROR_FAIL;
+	}
+
+	sink->channel = channel;
+	sink->write = write;
+	sink->poll = poll;
+	sink->priv = priv;
+	sink->next = rtt.sinks;
+	rtt.sinks = sink;
+
+	return ERROR_OK;
+}
+
+int rtt_unregister_sink(unsigned int channel, rtt_sink_write_t write, void *priv)
+{
+	for (struct rtt_sink **p = &rtt.sinks; *p; p = &(*p)->next) {
+		struct rtt_sink *sink = *p;
+		if (sink->channel == channel && sink->write == write && sink->priv == priv) {
+			*p = sink->next;
+			free(sink);
+			return ERROR_OK;
+		}
+	}
+
+	return ERROR_FAIL;
+}
+
+static bool rtt_channel_has_sink(unsigned int channel)
+{
+	for (struct rtt_sink *sink = rtt.sinks; sink; sink = sink->next) {
+		if (sink->channel == channel)
+			return true;
+	}
+
+	return false;
+}
+
+static void rtt_parse_buffer_desc(struct target *target, const uint8_t *desc,
+		struct rtt_buffer *buffer)
+{
+	buffer->name_addr = target_buffer_get_u32(target, desc + 0);
+	buffer->buffer_addr = target_buffer_get_u32(target, desc + 4);
+	buffer->size = target_buffer_get_u32(target, desc + 8);
+	buffer->write_offset = target_buffer_get_u32(target, desc + 12);
+	buffer->read_offset = target_buffer_get_u32(target, desc + 16);
+	buffer->flags = target_buffer_get_u32(target, desc + 20);
+}
+
+static int rtt_find_control_block(struct target *target, uint32_t *address)
+{
+	uint8_t buf[RTT_SEARCH_CHUNK];
+	size_t id_length = strlen(rtt.id);
+	uint32_t offset = 0;
+
+	while (offset < rtt.search_size) {
+		uint32_t n = MIN(rtt.search_size - offset, (uint32_t)sizeof(buf));
+
+		int retval = target_read_buffer(target, rtt.search_addr + offset, n, buf);
+		if (retval != ERROR_OK)
+			return retval;
+
+		for (uint32_t i = 0; i + id_length <= n; i++) {
+			if (!memcmp(buf + i, rtt.id, id_length)) {
+				*address = rtt.search_addr + offset + i;
+				return ERROR_OK;
+			}
+		}
+
+		if (offset + n >= rtt.search_size)
+			break;
+
+		/* let the next window overlap, so a split identifier is found */
+		offset += n - (id_length - 1);
+	}
+
+	return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+}
+
+static void rtt_read_channel_name(struct target *target, struct rtt_buffer *buffer)
+{
+	buffer->name[0] = '\0';
+	if (buffer->name_addr == 0)
+		return;
+
+	if (target_read_buffer(target, buffer->name_addr, sizeof(buffer->name) - 1,
+			(uint8_t *)buffer->name) != ERROR_OK) {
+		buffer->name[0] = '\0';
+		return;
+	}
+
+	buffer->name[sizeof(buffer->name) - 1] = '\0';
+}
+
+static void rtt_free_channels(void)
+{
+	free(rtt.up);
+	free(rtt.down);
+	free(rtt.desc_buf);
+	free(rtt.data_buf);
+	rtt.up = NULL;
+	rtt.down = NULL;
+	rtt.desc_buf = NULL;
+	rtt.data_buf = NULL;
+	rtt.data_buf_size = 0;
+	rtt.num_up = 0;
+	rtt.num_down = 0;
+}
+
+/* Read the control block header and all buffer descriptors in one go. */
+static int rtt_read_control_block(struct target *target)
+{
+	uint8_t header[RTT_CB_BUFFERS_OFFSET];
+
+	int retval = target_read_buffer(target, rtt.cb_address, sizeof(header), header);
+	if (retval != ERROR_OK)
+		return retval;
+
+	uint32_t num_up = target_buffer_get_u32(target, header + RTT_CB_NUM_UP_OFFSET);
+	uint32_t num_down = target_buffer_get_u32(target, header + RTT_CB_NUM_DOWN_OFFSET);
+	if (num_up > RTT_MAX_CHANNELS || num_down > RTT_MAX_CHANNELS) {
+		LOG_ERROR("rtt: invalid control block at 0x%8.8" PRIx32 " (%" PRIu32
+				" up, %" PRIu32 " down channels)", rtt.cb_address, num_up, num_down);
+		return ERROR_FAIL;
+	}
+
+	rtt_free_channels();
+
+	unsigned int num_buffers = num_up + num_down;
+	rtt.up = calloc(num_up ? num_up : 1, sizeof(struct rtt_buffer));
+	rtt.down = calloc(num_down ? num_down : 1, sizeof(struct rtt_buffer));
+	rtt.desc_buf = malloc((num_buffers ? num_buffers : 1) * RTT_BUFFER_DESC_SIZE);
+	if (rtt.up == NULL || rtt.down == NULL || rtt.desc_buf == NULL) {
+		LOG_ERROR("Out of memory");
+		rtt_free_channels();
+		return ERROR_FAIL;
+	}
+	rtt.num_up = num_up;
+	rtt.num_down = num_down;
+
+	retval = target_read_buffer(target, rtt.cb_address + RTT_CB_BUFFERS_OFFSET,
+			num_buffers * RTT_BUFFER_DESC_SIZE, rtt.desc_buf);
+	if (retval != ERROR_OK) {
+		rtt_free_channels();
+		return retval;
+	}
+
+	uint32_t max_size = 0;
+	for (unsigned int i = 0; i < num_buffers; i++) {
+		struct rtt_buffer *buffer = i < num_up ? &rtt.up[i] : &rtt.down[i - num_up];
+
+		buffer->address = rtt.cb_address + RTT_CB_BUFFERS_OFFSET + i * RTT_BUFFER_DESC_SIZE;
+		rtt_parse_buffer_desc(target, rtt.desc_buf + i * RTT_BUFFER_DESC_SIZE, buffer);
+		rtt_read_channel_name(target, buffer);
+
+		if (buffer->size > max_size)
+			max_size = buffer->size;
+	}
+
+	rtt.data_buf = malloc(max_size ? max_size : 1);
+	if (rtt.data_buf == NULL) {
+		LOG_ERROR("Out of memory");
+		rtt_free_channels();
+		return ERROR_FAIL;
+	}
+	rtt.data_buf_size = max_size;
+
+	return ERROR_OK;
+}
+
+static void rtt_deliver(unsigned int channel, const uint8_t *buf, size_t length)
+{
+	for (struct rtt_sink *sink = rtt.sinks; sink; sink = sink->next) {
+		if (sink->channel == channel)
+			sink->write(channel, buf, length, sink->priv);
+	}
+}
+
+/* Drain one up buffer, whose offsets were just refreshed: at most two
+ * reads, for the part up to the end of the ring and the wrapped part. */
+static int rtt_drain_up_buffer(struct target *target, unsigned int channel)
+{
+	struct rtt_buffer *buffer = &rtt.up[channel];
+	uint32_t rd = buffer->read_offset;
+	uint32_t wr = buffer->write_offset;
+
+	if (rd == wr)
+		return ERROR_OK;
+
+	if (buffer->size == 0 || buffer->size > rtt.data_buf_size ||
+			rd >= buffer->size || wr >= buffer->size) {
+		LOG_DEBUG("rtt: up channel %u has invalid offsets", channel);
+		return ERROR_OK;
+	}
+
+	uint32_t length = 0;
+	if (wr < rd) {
+		length = buffer->size - rd;
+		int retval = target_read_buffer(target, buffer->buffer_addr + rd, length,
+				rtt.data_buf);
+		if (retval != ERROR_OK)
+			return retval;
+		rd = 0;
+	}
+
+	if (wr > rd) {
+		int retval = target_read_buffer(target, buffer->buffer_addr + rd, wr - rd,
+				rtt.data_buf + length);
+		if (retval != ERROR_OK)
+			return retval;
+		length += wr - rd;
+	}
+
+	int retval = target_write_u32(target, buffer->address + RTT_BUFFER_RD_OFF_OFFSET, wr);
+	if (retval != ERROR_OK)
+		return retval;
+	buffer->read_offset = wr;
+	buffer->bytes += length;
+	buffer->transfers++;
+
+	rtt_deliver(channel, rtt.data_buf, length);
+	rtt.got_data = true;
+
+	return ERROR_OK;
+}
+
+static void rtt_schedule_next_poll(bool busy)
+{
+	if (busy)
+		rtt.poll_delay = RTT_MIN_POLLING_INTERVAL;
+	else
+		rtt.poll_delay = MIN(rtt.poll_delay * 2, rtt.polling_interval);
+
+	rtt.next_poll = timeval_ms() + rtt.poll_delay;
+}
+
+static int rtt_poll(void *priv)
+{
+	struct target *target = rtt.target;
+
+	if (!rtt.started || rtt.sinks == NULL)
+		return ERROR_OK;
+
+	if (!target_was_examined(target) || target->state == TARGET_RESET)
+		return ERROR_OK;
+
+	/* the timer fires at the minimum interval, skip until the adaptive
+	 * delay has elapsed */
+	if (timeval_ms() < rtt.next_poll)
+		return ERROR_OK;
+
+	rtt.polls++;
+	bool got_data = rtt.got_data;
+	rtt.got_data = false;
+
+	/* e.g. retry client data which did not fit into a down buffer */
+	for (struct rtt_sink *sink = rtt.sinks; sink; sink = sink->next) {
+		if (sink->poll)
+			sink->poll(sink->channel, sink->priv);
+	}
+
+	/* all up descriptors are refreshed with a single read */
+	int retval = ERROR_OK;
+	if (rtt.num_up)
+		retval = target_read_buffer(target, rtt.cb_address + RTT_CB_BUFFERS_OFFSET,
+				rtt.num_up * RTT_BUFFER_DESC_SIZE, rtt.desc_buf);
+
+	for (unsigned int i = 0; retval == ERROR_OK && i < rtt.num_up; i++) {
+		if (!rtt_channel_has_sink(i))
+			continue;
+
+		rtt_parse_buffer_desc(target, rtt.desc_buf + i * RTT_BUFFER_DESC_SIZE, &rtt.up[i]);
+		retval = rtt_drain_up_buffer(target, i);
+	}
+
+	bool busy = rtt.got_data;
+	rtt.got_data = rtt.got_data || got_data;
+	rtt_schedule_next_poll(busy);
+
+	if (retval != ERROR_OK) {
+		if (!rtt.read_failed)
+			LOG_WARNING("rtt: failed to access the ring buffers");
+		rtt.read_failed = true;
+		return ERROR_OK;
+	}
+
+	rtt.read_failed = false;
+	return ERROR_OK;
+}
+
+int rtt_write_channel(unsigned int channel, const uint8_t *buf, size_t *length)
+{
+	struct target *target = rtt.target;
+
+	if (!rtt.started || channel >= rtt.num_down) {
+		*length = 0;
+		return ERROR_FAIL;
+	}
+
+	struct rtt_buffer *buffer = &rtt.down[channel];
+	uint8_t desc[RTT_BUFFER_DESC_SIZE];
+
+	/* the target advances the read offset, refresh the descriptor */
+	int retval = target_read_buffer(target, buffer->address, sizeof(desc), desc);
+	if (retval != ERROR_OK) {
+		*length = 0;
+		return retval;
+	}
+	rtt_parse_buffer_desc(target, desc, buffer);
+
+	uint32_t rd = buffer->read_offset;
+	uint32_t wr = buffer->write_offset;
+	if (buffer->size == 0 || rd >= buffer->size || wr >= buffer->size) {
+		LOG_DEBUG("rtt: down channel %u has invalid offsets", channel);
+		*length = 0;
+		return ERROR_FAIL;
+	}
+
+	/* one byte stays free to tell a full buffer from an empty one */
+	uint32_t space = rd > wr ? rd - wr - 1 : buffer->size - (wr - rd) - 1;
+	uint32_t n = MIN(*length, space);
+	*length = 0;
+	if (n == 0)
+		return ERROR_OK;
+
+	uint32_t first = MIN(n, buffer->size - wr);
+	retval = target_write_buffer(target, buffer->buffer_addr + wr, first, buf);
+	if (retval != ERROR_OK)
+		return retval;
+
+	if (n > first) {
+		retval = target_write_buffer(target, buffer->buffer_addr, n - first, buf + first);
+		if (retval != ERROR_OK)
+			return retval;
+	}
+
+	wr = (wr + n) % buffer->size;
+	retval = target_write_u32(target, buffer->address + RTT_BUFFER_WR_OFF_OFFSET, wr);
+	if (retval != ERROR_OK)
+		return retval;
+
+	buffer->write_offset = wr;
+	buffer->bytes += n;
+	buffer->transfers++;
+	*length = n;
+
+	/* a reply is likely to follow, poll the up channels soon */
+	rtt.got_data = true;
+	rtt_schedule_next_poll(true);
+
+	return ERROR_OK;
+}
+
+static int rtt_start(void)
+{
+	struct target *target = rtt.target;
+
+	int retval = rtt_find_control_block(target, &rtt.cb_address);
+	if (retval == ERROR_TARGET_RESOURCE_NOT_AVAILABLE) {
+		LOG_ERROR("rtt: control block '%s' not found in " TARGET_ADDR_FMT
+				" + 0x%" PRIx32, rtt.id, rtt.search_addr, rtt.search_size);
+		return ERROR_FAIL;
+	}
+	if (retval != ERROR_OK)
+		return retval;
+
+	LOG_INFO("rtt: control block found at 0x%8.8" PRIx32, rtt.cb_address);
+
+	retval = rtt_read_control_block(target);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = target_register_timer_callback(rtt_poll, RTT_MIN_POLLING_INTERVAL, 1, NULL);
+	if (retval != ERROR_OK) {
+		rtt_free_channels();
+		return retval;
+	}
+
+	rtt.started = true;
+	rtt.read_failed = false;
+	rtt.polls = 0;
+	rtt.start_time = timeval_ms();
+	rtt.poll_delay = RTT_MIN_POLLING_INTERVAL;
+	rtt.next_poll = rtt.start_time;
+
+	return ERROR_OK;
+}
+
+static void rtt_stop(void)
+{
+	if (!rtt.started)
+		return;
+
+	target_unregister_timer_callback(rtt_poll, NULL);
+	rtt_free_channels();
+	rtt.started = false;
+
+	/* nothing polls from now on, let the sinks give up on data still
+	 * waiting for room in a down channel */
+	for (struct rtt_sink *sink = rtt.sinks; sink; sink = sink->next) {
+		if (sink->poll)
+			sink->poll(sink->channel, sink->priv);
+	}
+}
+
+COMMAND_HANDLER(handle_rtt_setup_command)
+{
+	if (CMD_ARGC != 3)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	target_addr_t address;
+	uint32_t size;
+	COMMAND_PARSE_ADDRESS(CMD_ARGV[0], address);
+	COMMAND_PARSE_NUMBER(u32, CMD_ARGV[1], size);
+
+	size_t id_length = strlen(CMD_ARGV[2]);
+	if (id_length == 0 || id_length >= RTT_CB_MAX_ID_LENGTH) {
+		command_print(CMD_CTX, "control block ID must be 1 to %d characters long",
+				RTT_CB_MAX_ID_LENGTH - 1);
+		return ERROR_COMMAND_ARGUMENT_INVALID;
+	}
+
+	rtt_stop();
+
+	rtt.target = get_current_target(CMD_CTX);
+	rtt.search_addr = address;
+	rtt.search_size = size;
+	strcpy(rtt.id, CMD_ARGV[2]);
+	rtt.configured = true;
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_rtt_start_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (!rtt.configured) {
+		command_print(CMD_CTX, "rtt is not configured, use 'rtt setup' first");
+		return ERROR_FAIL;
+	}
+
+	if (rtt.started) {
+		command_print(CMD_CTX, "rtt is already started");
+		return ERROR_OK;
+	}
+
+	return rtt_start();
+}
+
+COMMAND_HANDLER(handle_rtt_stop_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	rtt_stop();
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_rtt_channels_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (!rtt.started) {
+		command_print(CMD_CTX, "rtt is not started");
+		return ERROR_FAIL;
+	}
+
+	command_print(CMD_CTX, "control block at 0x%8.8" PRIx32 ": %u up, %u down channels",
+			rtt.cb_address, rtt.num_up, rtt.num_down);
+
+	for (unsigned int i = 0; i < rtt.num_up; i++)
+		command_print(CMD_CTX, "up %u: \"%s\" size: %" PRIu32 " flags: 0x%" PRIx32,
+				i, rtt.up[i].name, rtt.up[i].size, rtt.up[i].flags);
+
+	for (unsigned int i = 0; i < rtt.num_down; i++)
+		command_print(CMD_CTX, "down %u: \"%s\" size: %" PRIu32 " flags: 0x%" PRIx32,
+				i, rtt.down[i].name, rtt.down[i].size, rtt.down[i].flags);
+
+	return ERROR_OK;
+}
+
+static void rtt_print_stats(struct command_context *cmd_ctx, const char *direction,
+		unsigned int channel, const struct rtt_buffer *buffer, int64_t elapsed_ms)
+{
+	command_print(cmd_ctx, "%s %u: %" PRIu64 " bytes in %" PRIu64 " transfers"
+			" (%.3f KiB/s)", direction, channel, buffer->bytes, buffer->transfers,
+			elapsed_ms ? buffer->bytes * 1000.0 / 1024.0 / elapsed_ms : 0.0);
+}
+
+COMMAND_HANDLER(handle_rtt_stats_command)
+{
+	if (CMD_ARGC != 0)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (!rtt.started) {
+		command_print(CMD_CTX, "rtt is not started");
+		return ERROR_FAIL;
+	}
+
+	int64_t elapsed = timeval_ms() - rtt.start_time;
+	command_print(CMD_CTX, "%" PRIu64 " polls in %" PRId64 " ms, current poll delay %u ms",
+			rtt.polls, elapsed, rtt.poll_delay);
+
+	for (unsigned int i = 0; i < rtt.num_up; i++)
+		rtt_print_stats(CMD_CTX, "up", i, &rtt.up[i], elapsed);
+
+	for (unsigned int i = 0; i < rtt.num_down; i++)
+		rtt_print_stats(CMD_CTX, "down", i, &rtt.down[i], elapsed);
+
+	return ERROR_OK;
+}
+
+COMMAND_HANDLER(handle_rtt_polling_interval_command)
+{
+	if (CMD_ARGC > 1)
+		return ERROR_COMMAND_SYNTAX_ERROR;
+
+	if (CMD_ARGC == 1) {
+		unsigned int interval;
+		COMMAND_PARSE_NUMBER(uint, CMD_ARGV[0], interval);
+		if (interval == 0)
+			return ERROR_COMMAND_ARGUMENT_INVALID;
+
+		rtt.polling_interval = interval;
+		if (rtt.poll_delay > interval)
+			rtt.poll_delay = interval;
+	}
+
+	command_print(CMD_CTX, "rtt polling interval: %u ms", rtt.polling_interval);
+
+	return ERROR_OK;
+}
+
+static const struct command_registration rtt_subcommand_handlers[] = {
+	{
+		.name = "setup",
+		.handler = handle_rtt_setup_command,
+		.mode = COMMAND_ANY,
+		.help = "configure where to search for the RTT control block",
+		.usage = "address size ID",
+	},
+	{
+		.name = "start",
+		.handler = handle_rtt_start_command,
+		.mode = COMMAND_EXEC,
+		.help = "locate the control block and start polling the channels",
+		.usage = "",
+	},
+	{
+		.name = "stop",
+		.handler = handle_rtt_stop_command,
+		.mode = COMMAND_EXEC,
+		.help = "stop polling the channels",
+		.usage = "",
+	},
+	{
+		.name = "channels",
+		.handler = handle_rtt_channels_command,
+		.mode = COMMAND_EXEC,
+		.help = "list the channels of the control block",
+		.usage = "",
+	},
+	{
+		.name = "stats",
+		.handler = handle_rtt_stats_command,
+		.mode = COMMAND_EXEC,
+		.help = "show per channel throughput since 'rtt start'",
+		.usage = "",
+	},
+	{
+		.name = "polling_interval",
+		.handler = handle_rtt_polling_interval_command,
+		.mode = COMMAND_ANY,
+		.help = "display or set the channel polling interval while idle",
+		.usage = "[milliseconds]",
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+static const struct command_registration rtt_command_handlers[] = {
+	{
+		.name = "rtt",
+		.mode = COMMAND_ANY,
+		.help = "RTT ring buffer channel commands",
+		.usage = "",
+		.chain = rtt_subcommand_handlers,
+	},
+	COMMAND_REGISTRATION_DONE
+};
+
+int rtt_register_commands(struct command_context *cmd_ctx)
+{
+	return register_commands(cmd_ctx, NULL, rtt_command_handlers);
+}
@@ -0,0 +1,96 @@
+/***************************************************************************
+ *   This program is free software; you can redistribute it and/or modify  *
+ *   it under the terms of the GNU General Public License as published by  *
+ *   the Free Software Foundation; either version 2 of the License, or     *
+ *   (at your option) any later version.                                   *
+ *                                                                         *
+ *   This program is distributed in the hope that it will be useful,       *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU General Public License for more details.                          *
+ *                                                                         *
+ *   You should have received a copy of the GNU General Public License     *
+ *   along with this program.  If not, see <http://www.gnu.org/licenses/>. *
+ ***************************************************************************/
+
+#ifndef OPENOCD_TARGET_RTT_H
+#define OPENOCD_TARGET_RTT_H
+
+struct target;
+struct command_context;
+
+/** Maximum length of the control block identifier, including the NUL. */
+#define RTT_CB_MAX_ID_LENGTH	16
+
+/** Maximum length of a channel name shown to the user, including the NUL. */
+#define RTT_CHANNEL_NAME_LENGTH	32
+
+/**
+ * Ring buffer descriptor as found in the target's control block.
+ * The layout in target memory is six 32-bit words in this order.
+ */
+struct rtt_buffer {
+	/** Address of the descriptor itself in target memory. */
+	uint32_t address;
+	uint32_t name_addr;
+	uint32_t buffer_addr;
+	uint32_t size;
+	uint32_t write_offset;
+	uint32_t read_offset;
+	uint32_t flags;
+	char name[RTT_CHANNEL_NAME_LENGTH];
+	/** Bytes moved through this buffer since 'rtt start'. */
+	uint64_t bytes;
+	/** Number of transfers that moved data. */
+	uint64_t transfers;
+};
+
+/**
+ * Called with data drained from an up (target to host) channel.
+ *
+ * @param channel Index of the up channel the data was read from.
+ * @param buf The data.
+ * @param length Number of bytes in @a buf.
+ * @param priv The pointer handed to rtt_register_sink().
+ */
+typedef int (*rtt_sink_write_t)(unsigned int channel, const uint8_t *buf,
+		size_t length, void *priv);
+
+/**
+ * Called on every poll of the channels, e.g. to retry writing to a down
+ * channel that was full, and once more when RTT is stopped.
+ *
+ * @param channel The channel the sink was registered for.
+ * @param priv The pointer handed to rtt_register_sink().
+ */
+typedef void (*rtt_sink_poll_t)(unsigned int channel, void *priv);
+
+/** Register a sink for an up channel, @a poll may be NULL. */
+int rtt_register_sink(unsigned int channel, rtt_sink_write_t write,
+		rtt_sink_poll_t poll, void *priv);
+int rtt_unregister_sink(unsigned int channel, rtt_sink_write_t write, void *priv);
+
+/**
+ * Write data to a down (host to target) channel.
+ *
+ * Only as much data as currently fits into the ring buffer is written.
+ *
+ * @param channel Index of the down channel.
+ * @param buf The data to write.
+ * @param length On entry the number of bytes in @a buf, on return the
+ *	number of bytes actually written.
+ * @return ERROR_OK on success, else an error code.
+ */
+int rtt_write_channel(unsigned int channel, const uint8_t *buf, size_t *length);
+
+/**
+ * Read and clear the flag as to whether the last poll moved data.
+ *
+ * Like target_got_message(), this lets the server loop skip its idle
+ * sleep while data is streaming.
+ */
+bool rtt_got_data(void);
+
+int rtt_register_commands(struct command_context *cmd_ctx);
+
+#endif /* OPENOCD_TARGET_RTT_H */
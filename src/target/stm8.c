@@ -1216,7 +1216,7 @@ static struct reg_cache *stm8_build_reg_cache(struct target *target)
 
 	int num_regs = STM8_NUM_REGS;
 	struct reg_cache **cache_p = register_get_last_cache_p(&target->reg_cache);
-	struct reg_cache *cache = malloc(sizeof(struct reg_cache));
+	struct reg_cache *cache = calloc(1, sizeof(struct reg_cache));
 	struct reg *reg_list = calloc(num_regs, sizeof(struct reg));
 	struct stm8_core_reg *arch_info = malloc(
 			sizeof(struct stm8_core_reg) * num_regs);
@@ -1291,6 +1291,7 @@ static void stm8_free_reg_cache(struct target *target)
 
 	free(cache->reg_list[0].arch_info);
 	free(cache->reg_list);
+	register_cache_free_index(cache);
 	free(cache);
 
 	stm8->core_cache = NULL;
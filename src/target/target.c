@@ -42,14 +42,18 @@
 #endif
 
 #include <helper/time_support.h>
+#include <helper/tracelog.h>
 #include <jtag/jtag.h>
 #include <flash/nor/core.h>
 
 #include "target.h"
 #include "target_type.h"
 #include "target_request.h"
+#include "rtt.h"
+#include "bench.h"
 #include "breakpoints.h"
 #include "register.h"
+#include "arm_adi_v5.h"
 #include "trace.h"
 #include "image.h"
 #include "rtos/rtos.h"
@@ -523,6 +527,7 @@ struct target *get_current_target(struct command_context *cmd_ctx)
 int target_poll(struct target *target)
 {
 	int retval;
+	enum target_state old_state = target->state;
 
 	/* We can't poll until after examine */
 	if (!target_was_examined(target)) {
@@ -534,6 +539,10 @@ int target_poll(struct target *target)
 	if (retval != ERROR_OK)
 		return retval;
 
+	/* started running or reset behind our back, e.g. by an external reset */
+	if (target->state != old_state && target->state != TARGET_HALTED)
+		target->memory_generation++;
+
 	if (target->halt_issued) {
 		if (target->state == TARGET_HALTED)
 			target->halt_issued = false;
@@ -559,7 +568,9 @@ int target_halt(struct target *target)
 		return ERROR_FAIL;
 	}
 
+	TRACELOG(TRACELOG_TARGET_HALT, TRACELOG_BEGIN, 0);
 	retval = target->type->halt(target);
+	TRACELOG(TRACELOG_TARGET_HALT, TRACELOG_END, retval);
 	if (retval != ERROR_OK)
 		return retval;
 
@@ -612,11 +623,16 @@ int target_resume(struct target *target, int current, target_addr_t address,
 
 	target_call_event_callbacks(target, TARGET_EVENT_RESUME_START);
 
+	/* the code that runs now can change anything */
+	target->memory_generation++;
+
 	/* note that resume *must* be asynchronous. The CPU can halt before
 	 * we poll. The CPU can even halt at the current PC as a result of
 	 * a software breakpoint being inserted by (a bug?) the application.
 	 */
+	TRACELOG(TRACELOG_TARGET_RESUME, TRACELOG_BEGIN, 0);
 	retval = target->type->resume(target, current, address, handle_breakpoints, debug_execution);
+	TRACELOG(TRACELOG_TARGET_RESUME, TRACELOG_END, retval);
 	if (retval != ERROR_OK)
 		return retval;
 
@@ -637,8 +653,10 @@ static int target_process_reset(struct command_context *cmd_ctx, enum target_res
 	}
 
 	struct target *target;
-	for (target = all_targets; target; target = target->next)
+	for (target = all_targets; target; target = target->next) {
+		target->memory_generation++;
 		target_call_reset_callbacks(target, reset_mode);
+	}
 
 	/* disable polling during reset to make reset event scripts
 	 * more predictable, i.e. dr/irscan & pathmove in events will
@@ -697,6 +715,9 @@ static int default_check_reset(struct target *target)
 
 int target_examine_one(struct target *target)
 {
+	/* may well be a power cycled or different chip */
+	target->memory_generation++;
+
 	target_call_event_callbacks(target, TARGET_EVENT_EXAMINE_START);
 
 	int retval = target->type->examine(target);
@@ -797,6 +818,7 @@ int target_run_algorithm(struct target *target,
 	}
 
 	target->running_alg = true;
+	target->memory_generation++;
 	retval = target->type->run_algorithm(target,
 			num_mem_params, mem_params,
 			num_reg_params, reg_param,
@@ -837,6 +859,7 @@ int target_start_algorithm(struct target *target,
 	}
 
 	target->running_alg = true;
+	target->memory_generation++;
 	retval = target->type->start_algorithm(target,
 			num_mem_params, mem_params,
 			num_reg_params, reg_params,
@@ -1047,7 +1070,12 @@ int target_read_memory(struct target *target,
 		LOG_ERROR("Target %s doesn't support read_memory", target_name(target));
 		return ERROR_FAIL;
 	}
-	return target->type->read_memory(target, address, size, count, buffer);
+
+	TRACELOG(TRACELOG_TARGET_READ_MEMORY, TRACELOG_BEGIN, size * count);
+	int retval = target->type->read_memory(target, address, size, count, buffer);
+	TRACELOG(TRACELOG_TARGET_READ_MEMORY, TRACELOG_END, retval);
+
+	return retval;
 }
 
 int target_read_phys_memory(struct target *target,
@@ -1075,7 +1103,13 @@ int target_write_memory(struct target *target,
 		LOG_ERROR("Target %s doesn't support write_memory", target_name(target));
 		return ERROR_FAIL;
 	}
-	return target->type->write_memory(target, address, size, count, buffer);
+
+	target->memory_generation++;
+	TRACELOG(TRACELOG_TARGET_WRITE_MEMORY, TRACELOG_BEGIN, size * count);
+	int retval = target->type->write_memory(target, address, size, count, buffer);
+	TRACELOG(TRACELOG_TARGET_WRITE_MEMORY, TRACELOG_END, retval);
+
+	return retval;
 }
 
 int target_write_phys_memory(struct target *target,
@@ -1089,6 +1123,7 @@ int target_write_phys_memory(struct target *target,
 		LOG_ERROR("Target %s doesn't support write_phys_memory", target_name(target));
 		return ERROR_FAIL;
 	}
+	target->memory_generation++;
 	return target->type->write_phys_memory(target, address, size, count, buffer);
 }
 
@@ -1099,6 +1134,7 @@ int target_add_breakpoint(struct target *target,
 		LOG_WARNING("target %s is not halted (add breakpoint)", target_name(target));
 		return ERROR_TARGET_NOT_HALTED;
 	}
+	target->memory_generation++;
 	return target->type->add_breakpoint(target, breakpoint);
 }
 
@@ -1109,6 +1145,7 @@ int target_add_context_breakpoint(struct target *target,
 		LOG_WARNING("target %s is not halted (add context breakpoint)", target_name(target));
 		return ERROR_TARGET_NOT_HALTED;
 	}
+	target->memory_generation++;
 	return target->type->add_context_breakpoint(target, breakpoint);
 }
 
@@ -1119,12 +1156,14 @@ int target_add_hybrid_breakpoint(struct target *target,
 		LOG_WARNING("target %s is not halted (add hybrid breakpoint)", target_name(target));
 		return ERROR_TARGET_NOT_HALTED;
 	}
+	target->memory_generation++;
 	return target->type->add_hybrid_breakpoint(target, breakpoint);
 }
 
 int target_remove_breakpoint(struct target *target,
 		struct breakpoint *breakpoint)
 {
+	target->memory_generation++;
 	return target->type->remove_breakpoint(target, breakpoint);
 }
 
@@ -1169,7 +1208,18 @@ int target_get_gdb_reg_list(struct target *target,
 int target_step(struct target *target,
 		int current, target_addr_t address, int handle_breakpoints)
 {
-	return target->type->step(target, current, address, handle_breakpoints);
+	target->step_without_store = false;
+
+	TRACELOG(TRACELOG_TARGET_STEP, TRACELOG_BEGIN, 0);
+	int retval = target->type->step(target, current, address, handle_breakpoints);
+	TRACELOG(TRACELOG_TARGET_STEP, TRACELOG_END, retval);
+
+	/* the stepped instruction can store to memory, like a resume; bumped
+	 * afterwards so the step handler's own decoding still hits caches */
+	if (!target->step_without_store)
+		target->memory_generation++;
+
+	return retval;
 }
 
 int target_get_gdb_fileio_info(struct target *target, struct gdb_fileio_info *fileio_info)
@@ -1906,6 +1956,14 @@ void target_quit(void)
 	}
 
 	all_targets = NULL;
+
+	/* a DAP can be shared by the targets on its TAP, free it after them */
+	for (struct jtag_tap *tap = jtag_all_taps(); tap; tap = tap->next_tap) {
+		if (tap->dap) {
+			dap_free(tap->dap);
+			tap->dap = NULL;
+		}
+	}
 }
 
 /* free resources and restore memory, if restoring memory fails,
@@ -2003,7 +2061,7 @@ static int target_profiling_default(struct target *target, uint32_t *samples,
 
 	uint32_t sample_count = 0;
 	/* hopefully it is safe to cache! We want to stop/restart as quickly as possible. */
-	struct reg *reg = register_get_by_name(target->reg_cache, "pc", 1);
+	struct reg *reg = register_get_common(target->reg_cache, REG_COMMON_PC);
 
 	int retval = ERROR_OK;
 	for (;;) {
@@ -2064,6 +2122,7 @@ int target_write_buffer(struct target *target, target_addr_t address, uint32_t s
 		return ERROR_FAIL;
 	}
 
+	target->memory_generation++;
 	return target->type->write_buffer(target, address, size, buffer);
 }
 
@@ -2219,6 +2278,39 @@ int target_blank_check_memory(struct target *target, target_addr_t address, uint
 	return retval;
 }
 
+int target_blank_check_memory_blocks(struct target *target,
+		struct target_memory_check_block *blocks, unsigned int num_blocks,
+		uint8_t erased_value)
+{
+	int retval;
+
+	if (!target_was_examined(target)) {
+		LOG_ERROR("Target not examined yet");
+		return ERROR_FAIL;
+	}
+
+	if (num_blocks == 0)
+		return 0;
+
+	if (target->type->blank_check_memory_blocks) {
+		retval = target->type->blank_check_memory_blocks(target, blocks,
+				num_blocks, erased_value);
+		if (retval != ERROR_TARGET_RESOURCE_NOT_AVAILABLE)
+			return retval;
+		/* not even one block fits, try the range at a time check */
+	}
+
+	if (target->type->blank_check_memory == 0)
+		return ERROR_TARGET_RESOURCE_NOT_AVAILABLE;
+
+	retval = target->type->blank_check_memory(target, blocks[0].address,
+			blocks[0].size, &blocks[0].result, erased_value);
+	if (retval != ERROR_OK)
+		return retval;
+
+	return 1;
+}
+
 int target_read_u64(struct target *target, target_addr_t address, uint64_t *value)
 {
 	uint8_t value_buf[8];
@@ -6440,6 +6532,13 @@ static int target_register_user_commands(struct command_context *cmd_ctx)
 	if (retval != ERROR_OK)
 		return retval;
 
+	retval = rtt_register_commands(cmd_ctx);
+	if (retval != ERROR_OK)
+		return retval;
+
+	retval = bench_register_commands(cmd_ctx);
+	if (retval != ERROR_OK)
+		return retval;
 
 	return register_commands(cmd_ctx, NULL, target_exec_command_handlers);
 }
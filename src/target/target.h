@@ -150,6 +150,22 @@ struct target {
 	 */
 	bool running_alg;
 
+	/**
+	 * Incremented whenever target memory may have changed: memory and
+	 * breakpoint writes, resume, algorithms, reset, examine, the target
+	 * found running or reset by a poll, and single steps of instructions
+	 * which may store. Host side caches of target memory save it and
+	 * start over when it differs.
+	 */
+	uint32_t memory_generation;
+
+	/**
+	 * Set during target_step() by a step handler which decoded the
+	 * stepped instruction and found it doesn't write memory, so the
+	 * step leaves memory_generation alone.
+	 */
+	bool step_without_store;
+
 	struct target_event_action *event_action;
 
 	int reset_halt;						/* attempt resetting the CPU into the halted mode? */
@@ -585,6 +601,27 @@ int target_checksum_memory(struct target *target,
 		target_addr_t address, uint32_t size, uint32_t *crc);
 int target_blank_check_memory(struct target *target,
 		target_addr_t address, uint32_t size, uint32_t *blank, uint8_t erased_value);
+
+/** One memory range of a batched blank check. */
+struct target_memory_check_block {
+	target_addr_t address;
+	uint32_t size;
+	/** Set to the erased value if the range is blank, any other value
+	 * means it is not. */
+	uint32_t result;
+};
+
+/**
+ * Blank check several memory ranges, on the target if it can run
+ * algorithms. Checks the ranges in order, stopping early when the target
+ * cannot take all of them in one run.
+ *
+ * @returns the number of ranges checked from the start of @a blocks (at
+ * least one), or an error code.
+ */
+int target_blank_check_memory_blocks(struct target *target,
+		struct target_memory_check_block *blocks, unsigned int num_blocks,
+		uint8_t erased_value);
 int target_wait_state(struct target *target, enum target_state state, int ms);
 
 /**
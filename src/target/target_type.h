@@ -28,6 +28,7 @@
 #include <jim-nvp.h>
 
 struct target;
+struct target_memory_check_block;
 
 /**
  * This holds methods shared between all instances of a given target
@@ -132,6 +133,12 @@ struct target_type {
 			uint32_t count, uint32_t *checksum);
 	int (*blank_check_memory)(struct target *target, target_addr_t address,
 			uint32_t count, uint32_t *blank, uint8_t erased_value);
+	/* optional, checks as many of the blocks as it can in one run and
+	 * returns how many; target_blank_check_memory_blocks() falls back to
+	 * blank_check_memory one block at a time */
+	int (*blank_check_memory_blocks)(struct target *target,
+			struct target_memory_check_block *blocks, unsigned int num_blocks,
+			uint8_t erased_value);
 
 	/*
 	 * target break-/watchpoint control
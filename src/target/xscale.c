@@ -2879,7 +2879,7 @@ static void xscale_build_reg_cache(struct target *target)
 
 	(*cache_p) = arm_build_reg_cache(target, arm);
 
-	(*cache_p)->next = malloc(sizeof(struct reg_cache));
+	(*cache_p)->next = calloc(1, sizeof(struct reg_cache));
 	cache_p = &(*cache_p)->next;
 
 	/* fill in values for the xscale reg cache */
@@ -2910,6 +2910,11 @@ static int xscale_init_target(struct command_context *cmd_ctx,
 	return ERROR_OK;
 }
 
+static void xscale_deinit_target(struct target *target)
+{
+	arm_simulate_free(target_to_arm(target));
+}
+
 static int xscale_init_arch_info(struct target *target,
 	struct xscale_common *xscale, struct jtag_tap *tap)
 {
@@ -3713,6 +3718,7 @@ struct target_type xscale_target = {
 
 	.checksum_memory = arm_checksum_memory,
 	.blank_check_memory = arm_blank_check_memory,
+	.blank_check_memory_blocks = arm_blank_check_memory_blocks,
 
 	.run_algorithm = armv4_5_run_algorithm,
 
@@ -3724,6 +3730,7 @@ struct target_type xscale_target = {
 	.commands = xscale_command_handlers,
 	.target_create = xscale_target_create,
 	.init_target = xscale_init_target,
+	.deinit_target = xscale_deinit_target,
 
 	.virt2phys = xscale_virt2phys,
 	.mmu = xscale_mmu
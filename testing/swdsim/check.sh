@@ -0,0 +1,8 @@
+#!/bin/sh
+#
+# "make check" driver for check.cfg, run from the build directory.
+#
+
+srcdir=${srcdir:-.}
+
+exec ./src/openocd -s "$srcdir/tcl" -f "$srcdir/testing/swdsim/check.cfg"